@@ -16,7 +16,19 @@ SOURCES += \
     startdialog.cpp \
     promotiondialog.cpp \
     chessai.cpp \
-    uciengine.cpp
+    uciengine.cpp \
+    uciengineio.cpp \
+    linequeue.cpp \
+    enginepool.cpp \
+    bitboard.cpp \
+    position.cpp \
+    bitbase.cpp \
+    syzygy.cpp \
+    evaluate.cpp \
+    nnue.cpp \
+    movepick.cpp \
+    tt.cpp \
+    search.cpp
 
 HEADERS += \
     mychess.h \
@@ -26,7 +38,20 @@ HEADERS += \
     startdialog.h \
     promotiondialog.h \
     chessai.h \
-    uciengine.h
+    uciengine.h \
+    uciengineio.h \
+    linequeue.h \
+    enginepool.h \
+    bitboard.h \
+    position.h \
+    bitbase.h \
+    syzygy.h \
+    evaluate.h \
+    evalparams.h \
+    nnue.h \
+    movepick.h \
+    tt.h \
+    search.h
 
 FORMS += \
     mychess.ui
@@ -37,6 +62,12 @@ RESOURCES += \
 TRANSLATIONS += \
     chess_zh_CN.ts
 
+# NNUE 推論在 x86-64 預設使用 SSE2；以 qmake CONFIG+=avx2 建置可改用 AVX2（執行的 CPU 必須支援）
+avx2 {
+    gcc|clang: QMAKE_CXXFLAGS += -mavx2
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+}
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
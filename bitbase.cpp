@@ -0,0 +1,381 @@
+#include "bitbase.h"
+#include <mutex>
+
+using namespace Engine;
+
+namespace Bitbases {
+
+namespace {
+
+// 產生表格時的暫時狀態；完成後 UNKNOWN 全部變為 DRAW
+const quint8 UNKNOWN = 0xFF;
+const quint8 DRAW = 0xFE;
+const quint8 INVALID = 0xFD;
+
+// KPK：輪走方 × 兵（a-d 檔、第 2-7 橫列，24 格）× 白王 × 黑王；白方固定為有兵的一方
+const int KPK_SIZE = 2 * 24 * 64 * 64;
+
+// KQK / KRK：輪走方 × 強方國王（a1-d1-d4 三角形，10 格）× 弱方國王 × 子；輪走方 0 為強方
+const int KXK_SIZE = 2 * 10 * 64 * 64;
+
+quint8 KPKTable[KPK_SIZE];
+quint8 KQKTable[KXK_SIZE];
+quint8 KRKTable[KXK_SIZE];
+
+const int TriangleSquares[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+int TriangleIndex[SQUARE_NB];
+
+inline int kpkIndex(int stm, int wk, int bk, int psq)
+{
+    return wk | (bk << 6) | ((stm * 24 + fileOf(psq) * 6 + rankOf(psq) - 1) << 12);
+}
+
+inline int kxkIndex(int stm, int triangle, int wk, int piece)
+{
+    return piece | (wk << 6) | ((stm * 10 + triangle) << 12);
+}
+
+// 八種對稱：bit 0 左右鏡射、bit 1 上下鏡射、bit 2 沿 a1-h8 對角線翻轉
+inline int transform(int sq, int t)
+{
+    if (t & 1) sq ^= 7;
+    if (t & 2) sq ^= 56;
+    if (t & 4) sq = ((sq >> 3) | (sq << 3)) & 63;
+    return sq;
+}
+
+// 讓強方國王落在 a1-d1-d4 三角形內的對稱
+inline int canonicalTransform(int strongKing)
+{
+    int t = (fileOf(strongKing) > 3 ? 1 : 0) | (rankOf(strongKing) > 3 ? 2 : 0);
+    const int sq = transform(strongKing, t);
+    if (rankOf(sq) > fileOf(sq)) {
+        t |= 4;
+    }
+    return t;
+}
+
+inline int kxkCanonicalIndex(int stm, int sk, int wk, int piece)
+{
+    const int t = canonicalTransform(sk);
+    return kxkIndex(stm, TriangleIndex[transform(sk, t)], transform(wk, t), transform(piece, t));
+}
+
+// 分層倒推：第 n 層找出 n 個半回合內達成目標的局面
+// 強方（輪走方 0）只要有一步到達已解的局面即可；弱方必須所有著法都到達已解的局面
+template<typename Children>
+void solve(quint8* table, int size, Children children)
+{
+    const int half = size / 2;
+    int lastChange = 0;
+
+    for (int n = 1; n - lastChange <= 2 && n < int(INVALID); ++n) {
+        const bool strongToMove = n & 1;
+        const int begin = strongToMove ? 0 : half;
+
+        for (int idx = begin; idx < begin + half; ++idx) {
+            if (table[idx] != UNKNOWN) {
+                continue;
+            }
+
+            int childIdx[64];
+            const int count = children(idx, childIdx);
+            bool resolved = !strongToMove;
+
+            for (int i = 0; i < count; ++i) {
+                const quint8 v = table[childIdx[i]];
+                const bool won = v < INVALID && v < n;
+                if (strongToMove && won) {
+                    resolved = true;
+                    break;
+                }
+                if (!strongToMove && !won) {
+                    resolved = false;
+                    break;
+                }
+            }
+
+            if (resolved) {
+                table[idx] = quint8(n);
+                lastChange = n;
+            }
+        }
+    }
+
+    for (int idx = 0; idx < size; ++idx) {
+        if (table[idx] == UNKNOWN) {
+            table[idx] = DRAW;
+        }
+    }
+}
+
+void generateKPK()
+{
+    // 初始化：非法局面、終局（安全升變、逼和、吃掉無保護的兵）
+    for (int idx = 0; idx < KPK_SIZE; ++idx) {
+        const int stm = idx >= KPK_SIZE / 2 ? 1 : 0;
+        const int wk = idx & 63;
+        const int bk = (idx >> 6) & 63;
+        const int p = (idx >> 12) % 24;
+        const int psq = makeSquare(p / 6, p % 6 + 1);
+
+        quint8& r = KPKTable[idx];
+        r = UNKNOWN;
+
+        if (Bitboards::distance(wk, bk) <= 1 || wk == psq || bk == psq
+            || (stm == 0 && (Bitboards::PawnAttacks[WHITE][psq] & squareBB(bk)))) {
+            r = INVALID;
+        } else if (stm == 0 && rankOf(psq) == 6 && wk != psq + 8 && bk != psq + 8
+                   && (Bitboards::distance(bk, psq + 8) > 1 || Bitboards::distance(wk, psq + 8) == 1)) {
+            r = 1;  // 下一步安全升變
+        } else if (stm == 1) {
+            const Bitboard moves = Bitboards::KingAttacks[bk]
+                                 & ~(Bitboards::KingAttacks[wk] | Bitboards::PawnAttacks[WHITE][psq]);
+            if (!moves || (moves & squareBB(psq) & ~Bitboards::KingAttacks[wk])) {
+                r = DRAW;
+            }
+        }
+    }
+
+    solve(KPKTable, KPK_SIZE, [](int idx, int* out) {
+        const int stm = idx >= KPK_SIZE / 2 ? 1 : 0;
+        const int wk = idx & 63;
+        const int bk = (idx >> 6) & 63;
+        const int p = (idx >> 12) % 24;
+        const int psq = makeSquare(p / 6, p % 6 + 1);
+        int count = 0;
+
+        if (stm == 0) {
+            Bitboard b = Bitboards::KingAttacks[wk]
+                       & ~(Bitboards::KingAttacks[bk] | squareBB(psq));
+            while (b) {
+                out[count++] = kpkIndex(1, popLsb(b), bk, psq);
+            }
+            // 第 7 橫列的兵只經由安全升變計算，不在這裡展開
+            if (rankOf(psq) < 6 && psq + 8 != wk && psq + 8 != bk) {
+                out[count++] = kpkIndex(1, wk, bk, psq + 8);
+                if (rankOf(psq) == 1 && psq + 16 != wk && psq + 16 != bk) {
+                    out[count++] = kpkIndex(1, wk, bk, psq + 16);
+                }
+            }
+        } else {
+            Bitboard b = Bitboards::KingAttacks[bk]
+                       & ~(Bitboards::KingAttacks[wk] | Bitboards::PawnAttacks[WHITE][psq] | squareBB(psq));
+            while (b) {
+                out[count++] = kpkIndex(0, wk, popLsb(b), psq);
+            }
+        }
+        return count;
+    });
+}
+
+void generateKXK(quint8* table, PieceKind kind)
+{
+    const int half = KXK_SIZE / 2;
+
+    for (int idx = 0; idx < KXK_SIZE; ++idx) {
+        const int stm = idx >= half ? 1 : 0;
+        const int piece = idx & 63;
+        const int wk = (idx >> 6) & 63;
+        const int sk = TriangleSquares[(idx >> 12) % 10];
+        const Bitboard occupied = squareBB(sk) | squareBB(wk) | squareBB(piece);
+
+        quint8& r = table[idx];
+        r = UNKNOWN;
+
+        const bool check = Bitboards::attacks(kind, piece, occupied) & squareBB(wk);
+        if (Bitboards::distance(sk, wk) <= 1 || piece == sk || piece == wk || (stm == 0 && check)) {
+            r = INVALID;
+            continue;
+        }
+
+        if (stm == 1) {
+            // 弱方國王可以吃掉無保護的子就是和棋
+            if (Bitboards::distance(wk, piece) == 1 && Bitboards::distance(sk, piece) > 1) {
+                r = DRAW;
+                continue;
+            }
+            Bitboard moves = Bitboards::KingAttacks[wk] & ~(Bitboards::KingAttacks[sk] | squareBB(piece));
+            bool hasMove = false;
+            while (moves && !hasMove) {
+                const int to = popLsb(moves);
+                const Bitboard occ = squareBB(sk) | squareBB(to);
+                hasMove = !(Bitboards::attacks(kind, piece, occ) & squareBB(to));
+            }
+            if (!hasMove) {
+                r = check ? 0 : DRAW;  // 將死或逼和
+            }
+        }
+    }
+
+    solve(table, KXK_SIZE, [kind, half](int idx, int* out) {
+        const int stm = idx >= half ? 1 : 0;
+        const int piece = idx & 63;
+        const int wk = (idx >> 6) & 63;
+        const int sk = TriangleSquares[(idx >> 12) % 10];
+        int count = 0;
+
+        if (stm == 0) {
+            Bitboard b = Bitboards::KingAttacks[sk]
+                       & ~(Bitboards::KingAttacks[wk] | squareBB(piece));
+            while (b) {
+                out[count++] = kxkCanonicalIndex(1, popLsb(b), wk, piece);
+            }
+            b = Bitboards::attacks(kind, piece, squareBB(sk) | squareBB(wk))
+              & ~(squareBB(sk) | squareBB(wk));
+            while (b) {
+                out[count++] = kxkCanonicalIndex(1, sk, wk, popLsb(b));
+            }
+        } else {
+            Bitboard b = Bitboards::KingAttacks[wk]
+                       & ~(Bitboards::KingAttacks[sk] | squareBB(piece));
+            while (b) {
+                const int to = popLsb(b);
+                const Bitboard occ = squareBB(sk) | squareBB(to);
+                if (!(Bitboards::attacks(kind, piece, occ) & squareBB(to))) {
+                    out[count++] = kxkCanonicalIndex(0, sk, to, piece);
+                }
+            }
+        }
+        return count;
+    });
+}
+
+void generateAll()
+{
+    Bitboards::init();
+
+    for (int sq = 0; sq < SQUARE_NB; ++sq) {
+        TriangleIndex[sq] = -1;
+    }
+    for (int i = 0; i < 10; ++i) {
+        TriangleIndex[TriangleSquares[i]] = i;
+    }
+
+    generateKPK();
+    generateKXK(KQKTable, QUEEN);
+    generateKXK(KRKTable, ROOK);
+}
+
+// 分數：勝方越快達成目標越好；敗方越晚越好
+inline int scoreFor(bool strongToMove, quint8 plies, int base)
+{
+    if (plies >= INVALID) {
+        return 0;
+    }
+    const int value = base + 2 * (100 - plies);
+    return strongToMove ? value : -value;
+}
+
+// 把對方國王逼向角落（KBNK 需要與象同色的角落）
+const int PushClose[8] = { 0, 0, 100, 80, 60, 40, 20, 10 };
+
+int kbnkScore(const Position& pos, Color strong)
+{
+    const int bishop = lsb(pos.pieces(strong, BISHOP));
+    int weakKing = pos.kingSquare(~strong);
+    const int strongKing = pos.kingSquare(strong);
+
+    // 象在淺色格時以 a8/h1 為目標角落，翻轉後統一以 a1/h8 計算
+    if (!(squareBB(bishop) & DARK_SQUARES_BB)) {
+        weakKing ^= 7;
+    }
+    const int cornerDistance = qMin(Bitboards::distance(weakKing, SQ_A1), Bitboards::distance(weakKing, SQ_H8));
+    const int edgeDistance = qMin(qMin(fileOf(weakKing), 7 - fileOf(weakKing)),
+                                  qMin(rankOf(weakKing), 7 - rankOf(weakKing)));
+
+    return KnownWin / 2
+         + 60 * (7 - cornerDistance)
+         + 20 * (3 - edgeDistance)
+         + PushClose[Bitboards::distance(strongKing, pos.kingSquare(~strong))];
+}
+
+}
+
+void init()
+{
+    static std::once_flag once;
+    std::call_once(once, generateAll);
+}
+
+bool probeKPK(Color strongSide, Color sideToMove, int strongKing, int pawn, int weakKing)
+{
+    init();
+
+    // 統一為白方有兵、兵在 a-d 檔
+    if (strongSide == BLACK) {
+        strongKing ^= 56;
+        pawn ^= 56;
+        weakKing ^= 56;
+    }
+    if (fileOf(pawn) > 3) {
+        strongKing ^= 7;
+        pawn ^= 7;
+        weakKing ^= 7;
+    }
+    const int stm = sideToMove == strongSide ? 0 : 1;
+    return KPKTable[kpkIndex(stm, strongKing, weakKing, pawn)] < INVALID;
+}
+
+bool probe(const Position& pos, int* value)
+{
+    const int pieceCount = pos.pieceCount();
+    if (pieceCount > 3) {
+        return false;
+    }
+
+    // 子力不足：KK、KBK、KNK
+    if (pieceCount == 2 || pos.pieces(KNIGHT) || pos.pieces(BISHOP)) {
+        *value = 0;
+        return true;
+    }
+
+    init();
+
+    const Color strong = pos.pieces(WHITE) & ~pos.pieces(KING) ? WHITE : BLACK;
+    const bool strongToMove = pos.sideToMove() == strong;
+    int sk = pos.kingSquare(strong);
+    int wk = pos.kingSquare(~strong);
+    const int piece = lsb(pos.pieces(strong) & ~pos.pieces(KING));
+
+    if (pos.pieces(PAWN)) {
+        int psq = piece;
+        if (strong == BLACK) {
+            sk ^= 56;
+            wk ^= 56;
+            psq ^= 56;
+        }
+        if (fileOf(psq) > 3) {
+            sk ^= 7;
+            wk ^= 7;
+            psq ^= 7;
+        }
+        // KPK 的目標是安全升變，分數低於已升變的 KQK
+        *value = scoreFor(strongToMove, KPKTable[kpkIndex(strongToMove ? 0 : 1, sk, wk, psq)], KnownWin - 400);
+        return true;
+    }
+
+    const quint8* table = pos.pieces(QUEEN) ? KQKTable : KRKTable;
+    *value = scoreFor(strongToMove, table[kxkCanonicalIndex(strongToMove ? 0 : 1, sk, wk, piece)], KnownWin);
+    return true;
+}
+
+bool evaluate(const Position& pos, int* value)
+{
+    if (probe(pos, value)) {
+        return true;
+    }
+
+    if (pos.pieceCount() == 4) {
+        for (Color c : { WHITE, BLACK }) {
+            if (pos.count(c, BISHOP) == 1 && pos.count(c, KNIGHT) == 1) {
+                const int score = kbnkScore(pos, c);
+                *value = pos.sideToMove() == c ? score : -score;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,29 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "position.h"
+
+// 內建的小殘局庫：KPK、KQK、KRK 以倒推分析（retrograde analysis）產生，不需要外部檔案
+// 每個局面一個位元組（0xFE = 和棋，其餘為到達目標的半回合數），利用對稱性縮小表格，
+// 合計約 350 KB，第一次查詢時產生；只存勝負的位元表格會失去距離，必勝的一方無從推進（見 ENDGAME_BITBASES.md）
+namespace Bitbases {
+
+// 確定勝利的基準分數：高於任何子力優勢，低於將死
+const int KnownWin = 10000;
+
+// 產生所有表格；可重複呼叫，只有第一次會計算
+void init();
+
+// 精確結果：KPK、KQK、KRK 以及子力不足的和棋（KK、KBK、KNK）
+// 分數從輪走方角度：勝利越快分數越高，KPK 的勝利分數低於已升變的 KQK/KRK
+bool probe(const Engine::Position& pos, int* value);
+
+// probe() 加上啟發式殘局評估（KBNK：把對方國王逼向與象同色的角落）
+bool evaluate(const Engine::Position& pos, int* value);
+
+// KPK 勝負：strongSide 有兵；回傳有兵的一方是否必勝
+bool probeKPK(Engine::Color strongSide, Engine::Color sideToMove, int strongKing, int pawn, int weakKing);
+
+}
+
+#endif // BITBASE_H
@@ -0,0 +1,211 @@
+#include "bitboard.h"
+#include <mutex>
+
+namespace Engine {
+namespace Bitboards {
+
+Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+Bitboard KnightAttacks[SQUARE_NB];
+Bitboard KingAttacks[SQUARE_NB];
+Bitboard Between[SQUARE_NB][SQUARE_NB];
+Bitboard Line[SQUARE_NB][SQUARE_NB];
+
+namespace {
+
+// 魔術位元棋盤：每格一組遮罩、乘數與位移，攻擊表共用同一塊陣列
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    int shift;
+
+    int index(Bitboard occupied) const
+    {
+        return int(((occupied & mask) * magic) >> shift);
+    }
+};
+
+Magic BishopMagics[SQUARE_NB];
+Magic RookMagics[SQUARE_NB];
+Bitboard BishopTable[0x1480];
+Bitboard RookTable[0x19000];
+
+const int BishopDirections[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+const int RookDirections[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+// 逐格沿方向走，遇到棋子即停止（僅用於初始化）
+Bitboard slidingAttacks(const int directions[4][2], int sq, Bitboard occupied)
+{
+    Bitboard result = 0;
+    for (int d = 0; d < 4; ++d) {
+        int file = fileOf(sq) + directions[d][0];
+        int rank = rankOf(sq) + directions[d][1];
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            const Bitboard b = squareBB(makeSquare(file, rank));
+            result |= b;
+            if (occupied & b) {
+                break;
+            }
+            file += directions[d][0];
+            rank += directions[d][1];
+        }
+    }
+    return result;
+}
+
+// 固定種子的 xorshift 亂數，讓每次啟動找到相同的魔術數
+class MagicRng {
+public:
+    explicit MagicRng(quint64 seed) : m_state(seed) {}
+
+    quint64 next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ULL;
+    }
+
+    quint64 sparse() { return next() & next() & next(); }
+
+private:
+    quint64 m_state;
+};
+
+void initMagics(const int directions[4][2], Magic magics[], Bitboard table[])
+{
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096] = {};
+    int currentEpoch = 0;
+    Bitboard* next = table;
+    MagicRng rng(728);
+
+    for (int sq = 0; sq < SQUARE_NB; ++sq) {
+        // 邊緣格不影響攻擊範圍，從遮罩中移除
+        const Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rankBB(sq))
+                             | ((FILE_A_BB | FILE_H_BB) & ~fileBB(sq));
+
+        Magic& m = magics[sq];
+        m.mask = slidingAttacks(directions, sq, 0) & ~edges;
+        m.shift = 64 - popcount(m.mask);
+        m.attacks = next;
+
+        // Carry-Rippler 列舉遮罩的所有子集合
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(directions, sq, b);
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        for (int i = 0; i < size;) {
+            do {
+                m.magic = rng.sparse();
+            } while (popcount((m.magic * m.mask) >> 56) < 6);
+
+            ++currentEpoch;
+            for (i = 0; i < size; ++i) {
+                const int idx = m.index(occupancy[i]);
+                if (epoch[idx] < currentEpoch) {
+                    epoch[idx] = currentEpoch;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+
+        next += size;
+    }
+}
+
+void initTables()
+{
+    for (int sq = 0; sq < SQUARE_NB; ++sq) {
+        const Bitboard b = squareBB(sq);
+        PawnAttacks[WHITE][sq] = shiftNorth(shiftEast(b) | shiftWest(b));
+        PawnAttacks[BLACK][sq] = shiftSouth(shiftEast(b) | shiftWest(b));
+
+        KingAttacks[sq] = 0;
+        KnightAttacks[sq] = 0;
+        for (int df = -2; df <= 2; ++df) {
+            for (int dr = -2; dr <= 2; ++dr) {
+                const int file = fileOf(sq) + df;
+                const int rank = rankOf(sq) + dr;
+                if (file < 0 || file > 7 || rank < 0 || rank > 7 || (df == 0 && dr == 0)) {
+                    continue;
+                }
+                if (qAbs(df) <= 1 && qAbs(dr) <= 1) {
+                    KingAttacks[sq] |= squareBB(makeSquare(file, rank));
+                }
+                if (qAbs(df * dr) == 2) {
+                    KnightAttacks[sq] |= squareBB(makeSquare(file, rank));
+                }
+            }
+        }
+    }
+
+    initMagics(BishopDirections, BishopMagics, BishopTable);
+    initMagics(RookDirections, RookMagics, RookTable);
+
+    for (int s1 = 0; s1 < SQUARE_NB; ++s1) {
+        for (int s2 = 0; s2 < SQUARE_NB; ++s2) {
+            Between[s1][s2] = 0;
+            Line[s1][s2] = 0;
+            if (s1 == s2) {
+                continue;
+            }
+            if (bishopAttacks(s1, 0) & squareBB(s2)) {
+                Line[s1][s2] = (bishopAttacks(s1, 0) & bishopAttacks(s2, 0)) | squareBB(s1) | squareBB(s2);
+                Between[s1][s2] = bishopAttacks(s1, squareBB(s2)) & bishopAttacks(s2, squareBB(s1));
+            } else if (rookAttacks(s1, 0) & squareBB(s2)) {
+                Line[s1][s2] = (rookAttacks(s1, 0) & rookAttacks(s2, 0)) | squareBB(s1) | squareBB(s2);
+                Between[s1][s2] = rookAttacks(s1, squareBB(s2)) & rookAttacks(s2, squareBB(s1));
+            }
+        }
+    }
+}
+
+}
+
+void init()
+{
+    static std::once_flag once;
+    std::call_once(once, initTables);
+}
+
+Bitboard bishopAttacks(int sq, Bitboard occupied)
+{
+    const Magic& m = BishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+Bitboard rookAttacks(int sq, Bitboard occupied)
+{
+    const Magic& m = RookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+Bitboard attacks(PieceKind kind, int sq, Bitboard occupied)
+{
+    switch (kind) {
+    case KNIGHT:
+        return KnightAttacks[sq];
+    case BISHOP:
+        return bishopAttacks(sq, occupied);
+    case ROOK:
+        return rookAttacks(sq, occupied);
+    case QUEEN:
+        return queenAttacks(sq, occupied);
+    case KING:
+        return KingAttacks[sq];
+    default:
+        return 0;
+    }
+}
+
+}
+}
@@ -0,0 +1,134 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 內建引擎使用的位元棋盤基本型別與攻擊表
+// 格子編號：a1 = 0、b1 = 1 ... h8 = 63（與 ChessBoard 的 row/col 不同，轉換見 Engine::squareFromBoard）
+namespace Engine {
+
+typedef quint64 Bitboard;
+
+enum Color { WHITE, BLACK, COLOR_NB = 2 };
+
+enum PieceKind { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_KIND_NB = 6 };
+
+// 棋子編碼：color * 6 + kind，NO_PIECE 表示空格
+enum Piece { NO_PIECE = 12, PIECE_NB = 12 };
+
+enum Square { SQ_A1 = 0, SQ_H8 = 63, SQUARE_NB = 64, SQ_NONE = 64 };
+
+enum CastlingRight {
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+inline int makePiece(Color c, PieceKind k) { return int(c) * 6 + int(k); }
+inline Color colorOf(int piece) { return Color(piece / 6); }
+inline PieceKind kindOf(int piece) { return PieceKind(piece % 6); }
+
+inline int fileOf(int sq) { return sq & 7; }
+inline int rankOf(int sq) { return sq >> 3; }
+inline int makeSquare(int file, int rank) { return rank * 8 + file; }
+inline int relativeRank(Color c, int sq) { return c == WHITE ? rankOf(sq) : 7 - rankOf(sq); }
+
+// ChessBoard 的 QPoint(x = col, y = row)，row 0 為第 8 橫列
+inline int squareFromBoard(int row, int col) { return (7 - row) * 8 + col; }
+inline int boardRowOf(int sq) { return 7 - rankOf(sq); }
+inline int boardColOf(int sq) { return fileOf(sq); }
+
+inline Color operator~(Color c) { return Color(c ^ 1); }
+
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard RANK_1_BB = 0xFFULL;
+const Bitboard RANK_2_BB = RANK_1_BB << 8;
+const Bitboard RANK_4_BB = RANK_1_BB << 24;
+const Bitboard RANK_5_BB = RANK_1_BB << 32;
+const Bitboard RANK_7_BB = RANK_1_BB << 48;
+const Bitboard RANK_8_BB = RANK_1_BB << 56;
+const Bitboard DARK_SQUARES_BB = 0xAA55AA55AA55AA55ULL;
+
+inline Bitboard squareBB(int sq) { return 1ULL << sq; }
+inline Bitboard fileBB(int sq) { return FILE_A_BB << fileOf(sq); }
+inline Bitboard rankBB(int sq) { return RANK_1_BB << (8 * rankOf(sq)); }
+
+inline int popcount(Bitboard b)
+{
+#if defined(_MSC_VER)
+    return int(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+inline int lsb(Bitboard b)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return int(index);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int msb(Bitboard b)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, b);
+    return int(index);
+#else
+    return 63 ^ __builtin_clzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b)
+{
+    const int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+inline bool moreThanOne(Bitboard b) { return b & (b - 1); }
+
+inline Bitboard shiftNorth(Bitboard b) { return b << 8; }
+inline Bitboard shiftSouth(Bitboard b) { return b >> 8; }
+inline Bitboard shiftEast(Bitboard b) { return (b & ~FILE_H_BB) << 1; }
+inline Bitboard shiftWest(Bitboard b) { return (b & ~FILE_A_BB) >> 1; }
+
+namespace Bitboards {
+
+// 程式啟動時呼叫一次（可重複呼叫）
+void init();
+
+extern Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+extern Bitboard KnightAttacks[SQUARE_NB];
+extern Bitboard KingAttacks[SQUARE_NB];
+extern Bitboard Between[SQUARE_NB][SQUARE_NB];  // 兩格之間（不含端點），不在同一線上時為 0
+extern Bitboard Line[SQUARE_NB][SQUARE_NB];     // 通過兩格的整條直線/斜線
+
+Bitboard bishopAttacks(int sq, Bitboard occupied);
+Bitboard rookAttacks(int sq, Bitboard occupied);
+inline Bitboard queenAttacks(int sq, Bitboard occupied) { return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied); }
+
+Bitboard attacks(PieceKind kind, int sq, Bitboard occupied);
+
+inline int distance(int a, int b)
+{
+    return qMax(qAbs(fileOf(a) - fileOf(b)), qAbs(rankOf(a) - rankOf(b)));
+}
+
+}
+
+}
+
+#endif // BITBOARD_H
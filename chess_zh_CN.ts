@@ -23,6 +23,14 @@
         <source>Draw - Insufficient Material!</source>
         <translation>平局 - 棋子不足！</translation>
     </message>
+    <message>
+        <source>Draw - Fifty-Move Rule!</source>
+        <translation>平局 - 五十步規則！</translation>
+    </message>
+    <message>
+        <source>Draw - Threefold Repetition!</source>
+        <translation>平局 - 三次重複局面！</translation>
+    </message>
     <message>
         <source>White is in check!</source>
         <translation>白方被將軍！</translation>
@@ -70,6 +78,102 @@
         <source>Dark Squares:</source>
         <translation>深色方格：</translation>
     </message>
+    <message>
+        <source>Endgame Tablebases</source>
+        <translation>殘局庫</translation>
+    </message>
+    <message>
+        <source>Folder containing Syzygy .rtbw/.rtbz files</source>
+        <translation>存放 Syzygy .rtbw/.rtbz 檔案的資料夾</translation>
+    </message>
+    <message>
+        <source>Browse...</source>
+        <translation>瀏覽...</translation>
+    </message>
+    <message>
+        <source>Used by the built-in AI. Separate multiple folders with '%1'.</source>
+        <translation>供內建 AI 使用。多個資料夾請以「%1」分隔。</translation>
+    </message>
+    <message>
+        <source>Built-in Engine</source>
+        <translation>內建引擎</translation>
+    </message>
+    <message>
+        <source>Threads:</source>
+        <translation>執行緒數：</translation>
+    </message>
+    <message>
+        <source>Think during your turn (pondering)</source>
+        <translation>在您的回合預先思考</translation>
+    </message>
+    <message>
+        <source>CPU limit while pondering:</source>
+        <translation>預先思考時的 CPU 上限：</translation>
+    </message>
+    <message>
+        <source>Empty = classical evaluation</source>
+        <translation>留空 = 使用傳統評估</translation>
+    </message>
+    <message>
+        <source>NNUE network:</source>
+        <translation>NNUE 網路：</translation>
+    </message>
+    <message>
+        <source>Choose Network File</source>
+        <translation>選擇網路檔案</translation>
+    </message>
+    <message>
+        <source>NNUE networks (*.nnue);;All files (*)</source>
+        <translation>NNUE 網路 (*.nnue);;所有檔案 (*)</translation>
+    </message>
+    <message>
+        <source>Game clock</source>
+        <translation>依棋鐘</translation>
+    </message>
+    <message>
+        <source>Time per move</source>
+        <translation>每步固定時間</translation>
+    </message>
+    <message>
+        <source>Depth</source>
+        <translation>固定深度</translation>
+    </message>
+    <message>
+        <source>Nodes</source>
+        <translation>固定節點數</translation>
+    </message>
+    <message>
+        <source>Timed games always pass both clocks to the engine; the limit is applied on top of them.</source>
+        <translation>計時對局一律把雙方的剩餘時間交給引擎，這裡的限制另外加上。</translation>
+    </message>
+    <message>
+        <source>Search limit:</source>
+        <translation>搜尋限制：</translation>
+    </message>
+    <message>
+        <source>Limit value:</source>
+        <translation>限制數值：</translation>
+    </message>
+    <message>
+        <source> ms</source>
+        <translation> 毫秒</translation>
+    </message>
+    <message>
+        <source>External Engine</source>
+        <translation>外部引擎</translation>
+    </message>
+    <message>
+        <source>The external engine is not running.</source>
+        <translation>外部引擎沒有在執行。</translation>
+    </message>
+    <message>
+        <source> MB</source>
+        <translation> MB</translation>
+    </message>
+    <message>
+        <source>Choose Tablebase Folder</source>
+        <translation>選擇殘局庫資料夾</translation>
+    </message>
     <message>
         <source>Sound Volume</source>
         <translation type="vanished">音效音量</translation>
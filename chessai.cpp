@@ -1,32 +1,55 @@
 #include "chessai.h"
-#include <QRandomGenerator>
+#include "syzygy.h"
+#include "bitbase.h"
+#include "nnue.h"
 #include <QDebug>
 #include <QCoreApplication>
 #include <QDir>
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
+// 不計時又沒有指定限制時每步的思考時間（毫秒），所有技能等級相同
+static const int MAX_SEARCH_TIME_MS = 1000;
+
+// 直接走殘局庫最佳著法的最低技能等級
+static const int TABLEBASE_SKILL_LEVEL = 10;
+
+// 技能等級對應的節點數：等級 0 為 400，每升一級約乘 1.5；20 級不限節點，只受時間限制
+static quint64 skillNodes(int level)
+{
+    if (level >= Engine::MAX_SKILL_LEVEL) {
+        return 0;
+    }
+    return quint64(400.0 * std::pow(2.0, 0.6 * level));
+}
+
 ChessAI::ChessAI(AIDifficulty difficulty, QObject* parent)
     : QObject(parent),
       m_difficulty(difficulty),
       m_skillLevel(10),
-      m_useEngine(true),
+      m_useEngine(false),
       m_engine(nullptr),
+      m_waitingForEngine(false),
       m_currentBoard(nullptr),
-      m_currentColor(PieceColor::WHITE)
+      m_currentColor(PieceColor::WHITE),
+      m_search(new Engine::Search),
+      m_searchId(0),
+      m_ponderEnabled(false),
+      m_ponderCpuLimit(50),
+      m_pondering(false),
+      m_ponderKey(0),
+      m_limitMode(SearchLimitMode::Clock),
+      m_limitValue(0)
 {
-    m_engine = new UCIEngine(this);
-    
-    connect(m_engine, &UCIEngine::bestMoveFound, this, &ChessAI::onEngineMoveFound);
-    connect(m_engine, &UCIEngine::engineError, this, &ChessAI::onEngineError);
-    
     // 根據難度設定技能等級
     updateSkillLevelFromDifficulty();
 }
 
 ChessAI::~ChessAI()
 {
-    // m_engine 會被 Qt 的父物件系統自動刪除
+    // 搜尋執行緒必須先停下
+    delete m_search;
 }
 
 void ChessAI::updateSkillLevelFromDifficulty()
@@ -48,18 +71,38 @@ void ChessAI::updateSkillLevelFromDifficulty()
     }
 }
 
-bool ChessAI::initializeEngine(const QString& enginePath)
+void ChessAI::setEngine(UCIEngine* engine)
 {
-    if (!m_engine) {
-        return false;
+    if (m_engine) {
+        m_engine->disconnect(this);
     }
-    
-    bool success = m_engine->initialize(enginePath);
-    if (success) {
+    m_engine = engine;
+    if (m_engine) {
+        connect(m_engine, &UCIEngine::bestMoveFound, this, &ChessAI::onEngineMoveFound);
+        connect(m_engine, &UCIEngine::engineError, this, &ChessAI::onEngineError);
         m_engine->setSkillLevel(m_skillLevel);
+        m_engine->setOption("Ponder", m_ponderEnabled ? "true" : "false");
+    }
+    m_useEngine = m_engine && m_engine->isAvailable();
+}
+
+void ChessAI::newGame()
+{
+    stopPondering();
+    // 換掉 searchId，舊對局還在進行的搜尋結果會被丟棄
+    ++m_searchId;
+    m_search->stop();
+    m_search->clearHash();
+    m_waitingForEngine = false;
+
+    // 上一局引擎多次重新啟動都失敗而改用內建引擎時，開新局再試一次（請求在握手完成前排入佇列）
+    if (m_engine && !m_engine->isAvailable()) {
+        m_engine->restart();
+    }
+    m_useEngine = m_engine && m_engine->isAvailable();
+    if (m_useEngine) {
+        m_engine->newGame();
     }
-    
-    return success;
 }
 
 void ChessAI::setDifficulty(AIDifficulty difficulty)
@@ -70,68 +113,200 @@ void ChessAI::setDifficulty(AIDifficulty difficulty)
 
 void ChessAI::setSkillLevel(int level)
 {
-    m_skillLevel = qBound(0, level, 20);
+    m_skillLevel = qBound(0, level, Engine::MAX_SKILL_LEVEL);
+    // 與開始對話框的標示一致：0-5 簡單、6-15 中等、16-20 困難
+    m_difficulty = m_skillLevel <= 5 ? AIDifficulty::EASY
+                 : m_skillLevel <= 15 ? AIDifficulty::MEDIUM
+                 : AIDifficulty::HARD;
+    if (m_skillLevel < Engine::MAX_SKILL_LEVEL) {
+        stopPondering();
+    }
     if (m_engine) {
         m_engine->setSkillLevel(m_skillLevel);
     }
 }
 
-void ChessAI::getBestMove(ChessBoard* board, PieceColor aiColor)
+void ChessAI::setThreads(int threads)
+{
+    if (threads == m_search->threads()) {
+        return;
+    }
+    stopPondering();
+    m_search->setThreads(threads);
+}
+
+bool ChessAI::setEvalFile(const QString& path)
+{
+    if (path == Engine::NNUE::loadedPath()) {
+        return true;
+    }
+    // 網路由所有搜尋共用，必須等搜尋完全停下才能替換
+    stopPondering();
+    m_search->wait();
+
+    bool ok = true;
+    if (path.isEmpty()) {
+        Engine::NNUE::unload();
+    } else {
+        QString error;
+        ok = Engine::NNUE::load(path, &error);
+        if (ok) {
+            qDebug() << "NNUE network loaded:" << path << "hidden" << Engine::NNUE::hiddenSize()
+                     << Engine::NNUE::simdName();
+        } else {
+            qDebug() << "Failed to load NNUE network:" << error << "- using classical evaluation";
+            Engine::NNUE::unload();
+        }
+    }
+    m_search->clearHash();
+    return ok;
+}
+
+void ChessAI::setPonderEnabled(bool enabled)
+{
+    m_ponderEnabled = enabled;
+    // UCI 規定要預先思考的介面先設定 Ponder，引擎據此分配較多的時間
+    if (m_engine) {
+        m_engine->setOption("Ponder", enabled ? "true" : "false");
+    }
+    if (!enabled) {
+        stopPondering();
+    }
+}
+
+void ChessAI::setPonderCpuLimit(int cpuLimit)
+{
+    m_ponderCpuLimit = qBound(10, cpuLimit, 100);
+}
+
+void ChessAI::stopPondering()
+{
+    if (m_engine && m_engine->isPondering()) {
+        m_engine->stop();
+    }
+    if (!m_pondering) {
+        return;
+    }
+    // 先換掉 searchId，被停下的預先思考結果才會被丟棄
+    m_pondering = false;
+    ++m_searchId;
+    m_search->stop();
+}
+
+void ChessAI::stopSearch()
+{
+    stopPondering();
+    m_search->stop();
+    m_search->wait();
+}
+
+void ChessAI::setSearchLimit(SearchLimitMode mode, int value)
+{
+    m_limitMode = mode;
+    m_limitValue = qMax(1, value);
+}
+
+void ChessAI::getBestMove(ChessBoard* board, PieceColor aiColor, const Engine::SearchLimits& clock)
 {
     m_currentBoard = board;
     m_currentColor = aiColor;
+    m_moveTimer.start();
+
+    // 棋鐘讓引擎自行分配時間，選擇的限制另外加上；兩者都沒有時每步 1 秒
+    m_limits = Engine::SearchLimits();
+    for (int c = 0; c < Engine::COLOR_NB; ++c) {
+        m_limits.time[c] = clock.time[c];
+        m_limits.inc[c] = clock.inc[c];
+    }
+    m_limits.movestogo = clock.movestogo;
+    switch (m_limitMode) {
+    case SearchLimitMode::MoveTime: m_limits.movetime = m_limitValue; break;
+    case SearchLimitMode::Depth:    m_limits.depth = m_limitValue; break;
+    case SearchLimitMode::Nodes:    m_limits.nodes = quint64(m_limitValue); break;
+    case SearchLimitMode::Clock:    break;
+    }
+    if (!m_limits.useTimeManagement() && m_limits.movetime == 0 && m_limits.depth == 0 && m_limits.nodes == 0) {
+        m_limits.movetime = MAX_SEARCH_TIME_MS;
+    }
     
-    if (m_useEngine && m_engine && m_engine->isReady()) {
-        // 使用 UCI 引擎
-        m_engine->getBestMove(board, aiColor);
+    if (m_useEngine && m_engine && m_engine->isAvailable()) {
+        // 使用 UCI 引擎：握手還沒完成時請求會排入佇列
+        // 玩家走了預測的應著時預先思考直接轉為正式搜尋，否則它已被停下，重新搜尋
+        m_waitingForEngine = true;
+        if (m_engine->ponderHit(board)) {
+            return;
+        }
+        m_engine->getBestMove(board, m_limits);
     } else {
-        // 使用內建 AI（備用）
-        QPair<QPoint, QPoint> move;
-        
-        switch (m_difficulty) {
-        case AIDifficulty::EASY:
-            move = getRandomMove(board, aiColor);
-            break;
-        case AIDifficulty::MEDIUM:
-            move = getBasicEvaluationMove(board, aiColor);
-            break;
-        case AIDifficulty::HARD:
-            move = getMinimaxMove(board, aiColor);
-            break;
-        default:
-            move = getRandomMove(board, aiColor);
-            break;
+        // 使用內建引擎（備用）：所有技能等級都用同一個搜尋，只差在節點數、評估雜訊與抽選
+        // 玩家走了預測的著法：背景的預先思考直接轉為正式搜尋，置換表與已完成的深度都保留
+        if (ponderHit(board)) {
+            return;
         }
-        
-        // 發射移動訊號
-        if (move.first != QPoint(-1, -1)) {
-            emit moveReady(move.first, move.second);
-        } else {
-            emit engineError("No valid moves available");
+        stopPondering();
+
+        // 殘局庫範圍內的局面不需搜尋，直接走最佳著法（低等級照常搜尋以維持難度差異）
+        if (m_skillLevel >= TABLEBASE_SKILL_LEVEL && (playTablebaseMove(board) || playBitbaseMove(board))) {
+            return;
         }
+
+        startSearch(board);
     }
 }
 
-void ChessAI::onEngineMoveFound(QString fromUCI, QString toUCI)
+void ChessAI::onEngineMoveFound(QString fromUCI, QString toUCI, PieceType promotion)
 {
+    m_waitingForEngine = false;
     QPoint from = uciToPosition(fromUCI);
     QPoint to = uciToPosition(toUCI);
     
     if (from != QPoint(-1, -1) && to != QPoint(-1, -1)) {
-        emit moveReady(from, to);
+        // 先排入預先思考再回報著法：這一步若結束對局，stopPondering() 會把它取消
+        if (m_ponderEnabled && m_useEngine && m_engine) {
+            startEnginePonder();
+        }
+        emit moveReady(from, to, promotion);
     } else {
         emit engineError("Invalid move from engine");
     }
 }
 
+void ChessAI::startEnginePonder()
+{
+    m_engine->ponder(ponderLimits());
+}
+
+Engine::SearchLimits ChessAI::ponderLimits() const
+{
+    // 預先思考收到 ponderhit 才依棋鐘計時：自己的剩餘時間扣掉這一步用掉的時間並加上加秒，
+    // 對手的時間照實送出（玩家的思考時間正是預先思考的時間）
+    Engine::SearchLimits limits = m_limits;
+    const int side = m_currentColor == PieceColor::WHITE ? Engine::WHITE : Engine::BLACK;
+    if (limits.time[side] > 0) {
+        limits.time[side] = qMax(1, limits.time[side] - int(m_moveTimer.elapsed()) + limits.inc[side]);
+    }
+    if (limits.movestogo > 1) {
+        --limits.movestogo;
+    }
+    return limits;
+}
+
 void ChessAI::onEngineError(QString error)
 {
     qDebug() << "Engine error:" << error;
     
-    // 引擎錯誤時，使用內建 AI 作為備用
+    // 引擎當掉時 UCIEngine 會自行重新啟動並接續搜尋，連續失敗才回報錯誤：這一局剩下的部分改用內建 AI，
+    // 下一局再試；引擎是跨對局共用的，只有等待中的請求才需要改由內建引擎回答
+    // 棋鐘照常沿用，自己的剩餘時間扣掉等待外部引擎已用掉的時間
     m_useEngine = false;
-    if (m_currentBoard) {
-        getBestMove(m_currentBoard, m_currentColor);
+    if (m_waitingForEngine && m_currentBoard) {
+        m_waitingForEngine = false;
+        Engine::SearchLimits clock = m_limits;
+        const int side = m_currentColor == PieceColor::WHITE ? Engine::WHITE : Engine::BLACK;
+        if (clock.time[side] > 0) {
+            clock.time[side] = qMax(1, clock.time[side] - int(m_moveTimer.elapsed()));
+        }
+        getBestMove(m_currentBoard, m_currentColor, clock);
     }
 }
 
@@ -140,251 +315,234 @@ QPoint ChessAI::uciToPosition(const QString& uci)
     if (uci.length() < 2) return QPoint(-1, -1);
     
     int col = uci[0].toLatin1() - 'a';
-    int row = uci[1].toLatin1() - '1';
+    int rank = uci[1].toLatin1() - '1';
     
-    if (row < 0 || row > 7 || col < 0 || col > 7) {
+    if (rank < 0 || rank > 7 || col < 0 || col > 7) {
         return QPoint(-1, -1);
     }
     
-    return QPoint(row, col);
+    // 棋盤座標為 (col, row)，row 0 是第 8 橫列
+    return QPoint(col, 7 - rank);
 }
 
-QVector<QPair<QPoint, QPoint>> ChessAI::getAllValidMoves(ChessBoard* board, PieceColor color)
+bool ChessAI::playTablebaseMove(ChessBoard* board)
 {
-    QVector<QPair<QPoint, QPoint>> validMoves;
-
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board->getPieceAt(row, col);
-            if (piece && piece->getColor() == color) {
-                QPoint from(row, col);
-                // 檢查所有可能的目標位置
-                for (int toRow = 0; toRow < 8; ++toRow) {
-                    for (int toCol = 0; toCol < 8; ++toCol) {
-                        QPoint to(toRow, toCol);
-                        if (board->canMove(from, to)) {
-                            validMoves.append(qMakePair(from, to));
-                        }
-                    }
-                }
-            }
-        }
+    // 子力計數是增量維護的，不在殘局庫範圍內時不必建立局面
+    if (board->getTotalPieceCount() > Syzygy::maxCardinality()) {
+        return false;
     }
 
-    return validMoves;
-}
-
-QPair<QPoint, QPoint> ChessAI::getRandomMove(ChessBoard* board, PieceColor aiColor)
-{
-    QVector<QPair<QPoint, QPoint>> validMoves = getAllValidMoves(board, aiColor);
+    Engine::Position pos;
+    if (!pos.setFen(board->toFEN()) || !Syzygy::canProbe(pos)) {
+        return false;
+    }
 
-    if (validMoves.isEmpty()) {
-        return QPair<QPoint, QPoint>(QPoint(-1, -1), QPoint(-1, -1));
+    Engine::Move move = Syzygy::probeRoot(pos);
+    if (move == Engine::MOVE_NONE) {
+        return false;  // 缺少需要的殘局庫檔案
     }
 
-    // 隨機選擇一個有效移動
-    int randomIndex = QRandomGenerator::global()->bounded(validMoves.size());
-    return validMoves[randomIndex];
+    emitEngineMove(move);
+    return true;
 }
 
-int ChessAI::getPieceValue(ChessPiece* piece)
+bool ChessAI::playBitbaseMove(ChessBoard* board)
 {
-    if (!piece) return 0;
-
-    switch (piece->getType()) {
-    case PieceType::PAWN:
-        return 100;
-    case PieceType::KNIGHT:
-        return 320;
-    case PieceType::BISHOP:
-        return 330;
-    case PieceType::ROOK:
-        return 500;
-    case PieceType::QUEEN:
-        return 900;
-    case PieceType::KING:
-        return 20000;
-    default:
-        return 0;
+    // 內建殘局庫涵蓋雙王加上至多一個其他棋子（KPK、KQK、KRK 與子力不足的 KK、KNK、KBK）
+    const quint64 kings = ChessBoard::materialKeyOf(PieceColor::WHITE, PieceType::KING)
+                        + ChessBoard::materialKeyOf(PieceColor::BLACK, PieceType::KING);
+    const quint64 extra = board->getMaterialKey() - kings;
+    bool covered = extra == 0;
+    for (PieceColor color : { PieceColor::WHITE, PieceColor::BLACK }) {
+        for (PieceType type : { PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP,
+                                PieceType::ROOK, PieceType::QUEEN }) {
+            covered = covered || extra == ChessBoard::materialKeyOf(color, type);
+        }
+    }
+    if (!covered) {
+        return false;
     }
-}
 
-int ChessAI::evaluateBoard(ChessBoard* board, PieceColor aiColor)
-{
-    int score = 0;
-    PieceColor opponentColor = (aiColor == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
-
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board->getPieceAt(row, col);
-            if (piece) {
-                int pieceValue = getPieceValue(piece);
-                if (piece->getColor() == aiColor) {
-                    score += pieceValue;
-                } else {
-                    score -= pieceValue;
-                }
-            }
-        }
+    Engine::Position pos;
+    if (!pos.setFen(board->toFEN())) {
+        return false;
     }
 
-    // 額外獎勵：控制中心
-    for (int row = 3; row <= 4; ++row) {
-        for (int col = 3; col <= 4; ++col) {
-            ChessPiece* piece = board->getPieceAt(row, col);
-            if (piece && piece->getColor() == aiColor) {
-                score += 30;
-            }
+    Engine::MoveList moves;
+    pos.generateLegal(moves);
+
+    // 三子以下的局面走完一步仍在內建殘局庫範圍內，逐一查詢子局面即可
+    Engine::Move bestMove = Engine::MOVE_NONE;
+    int bestScore = std::numeric_limits<int>::min();
+    for (int i = 0; i < moves.size; ++i) {
+        pos.doMove(moves.moves[i]);
+        int value;
+        bool found = Bitbases::probe(pos, &value);
+        pos.undoMove();
+        if (!found) {
+            return false;
+        }
+        if (-value > bestScore) {
+            bestScore = -value;
+            bestMove = moves.moves[i];
         }
     }
 
-    // 檢查將軍狀態
-    if (board->isKingInCheck(opponentColor)) {
-        score += 50;
-    }
-    if (board->isKingInCheck(aiColor)) {
-        score -= 50;
+    if (bestMove == Engine::MOVE_NONE) {
+        return false;
     }
 
-    return score;
+    emitEngineMove(bestMove);
+    return true;
 }
 
-QPair<QPoint, QPoint> ChessAI::getBasicEvaluationMove(ChessBoard* board, PieceColor aiColor)
+bool ChessAI::positionFromBoard(ChessBoard* board, Engine::Position* pos)
 {
-    QVector<QPair<QPoint, QPoint>> validMoves = getAllValidMoves(board, aiColor);
-
-    if (validMoves.isEmpty()) {
-        return QPair<QPoint, QPoint>(QPoint(-1, -1), QPoint(-1, -1));
+    if (!pos->setFen(board->getStartFEN())) {
+        return false;
     }
-
-    QPair<QPoint, QPoint> bestMove = validMoves[0];
-    int bestScore = std::numeric_limits<int>::min();
-
-    // 保存當前回合
-    PieceColor originalTurn = board->getCurrentTurn();
-
-    for (const auto& move : validMoves) {
-        // 模擬移動
-        ChessPiece* capturedPiece = board->getPieceAt(move.second);
-        int captureValue = (capturedPiece) ? getPieceValue(capturedPiece) : 0;
-        
-        // 簡單評估：吃子的價值
-        int moveScore = captureValue;
-        
-        // 優先考慮中心控制
-        int toRow = move.second.x();
-        int toCol = move.second.y();
-        if (toRow >= 3 && toRow <= 4 && toCol >= 3 && toCol <= 4) {
-            moveScore += 30;
+    for (const Move& move : board->getMoveHistory()) {
+        const int from = Engine::squareFromBoard(move.from.y(), move.from.x());
+        const int to = Engine::squareFromBoard(move.to.y(), move.to.x());
+        Engine::PieceKind promotion = Engine::QUEEN;
+        switch (move.promotedTo) {
+        case PieceType::KNIGHT: promotion = Engine::KNIGHT; break;
+        case PieceType::BISHOP: promotion = Engine::BISHOP; break;
+        case PieceType::ROOK:   promotion = Engine::ROOK; break;
+        default:                promotion = Engine::QUEEN; break;
         }
 
-        if (moveScore > bestScore) {
-            bestScore = moveScore;
-            bestMove = move;
+        Engine::MoveList legal;
+        pos->generateLegal(legal);
+        Engine::Move found = Engine::MOVE_NONE;
+        for (int i = 0; i < legal.size; ++i) {
+            const Engine::Move m = legal.moves[i];
+            if (Engine::moveFrom(m) == from && Engine::moveTo(m) == to
+                && (Engine::moveType(m) != Engine::PROMOTION || Engine::promotionKind(m) == promotion)) {
+                found = m;
+                break;
+            }
         }
+        if (found == Engine::MOVE_NONE) {
+            return false;
+        }
+        pos->doMove(found);
     }
-
-    return bestMove;
+    return true;
 }
 
-int ChessAI::minimax(ChessBoard* board, int depth, int alpha, int beta, bool maximizingPlayer, PieceColor aiColor)
+void ChessAI::startSearch(ChessBoard* board)
 {
-    if (depth == 0) {
-        return evaluateBoard(board, aiColor);
+    // 重播失敗時退回目前局面的 FEN，只是少了重複和棋的資訊
+    Engine::Position pos;
+    if (!positionFromBoard(board, &pos) && !pos.setFen(board->toFEN())) {
+        emit engineError("Invalid position");
+        return;
     }
 
-    PieceColor currentColor = maximizingPlayer ? aiColor : 
-                              (aiColor == PieceColor::WHITE ? PieceColor::BLACK : PieceColor::WHITE);
-    
-    // 檢查遊戲結束狀態
-    if (board->isCheckmate(currentColor)) {
-        return maximizingPlayer ? -100000 : 100000;
+    m_search->stop();
+    launchSearch(pos, m_limits, false);
+}
+
+void ChessAI::launchSearch(const Engine::Position& pos, const Engine::SearchLimits& base, bool ponder)
+{
+    // 預先思考時不計時，等 ponderhit 才開始算；時間從搜尋開始算起，
+    // 所以想得比思考時間久時玩家一走就立刻回應
+    // 技能等級的節點數與選擇的節點限制取較小者
+    Engine::SearchLimits limits = base;
+    const quint64 nodes = skillNodes(m_skillLevel);
+    if (nodes > 0 && (limits.nodes == 0 || nodes < limits.nodes)) {
+        limits.nodes = nodes;
     }
-    if (board->isStalemate(currentColor)) {
-        return 0;
+    limits.skillLevel = m_skillLevel;
+    limits.ponder = ponder;
+    limits.cpuLimit = m_ponderCpuLimit;
+
+    // 搜尋在背景執行緒回報，回到 GUI 執行緒再處理；
+    // 已被新的搜尋取代的結果直接丟棄，預先思考的迭代等 ponderhit 之後才回報
+    const int searchId = ++m_searchId;
+    m_search->setInfoCallback([this, searchId](const Engine::SearchInfo& info) {
+        if (info.multiPv != 1) {
+            return;
+        }
+        const Engine::SearchStats stats = info.stats;
+        QMetaObject::invokeMethod(this, [this, searchId, stats]() {
+            if (searchId == m_searchId && !m_pondering) {
+                emit searchStatsUpdated(stats);
+            }
+        }, Qt::QueuedConnection);
+    });
+    m_search->start(pos, limits, [this, searchId, pos](Engine::Move bestMove, Engine::Move ponderMove) {
+        const Engine::SearchStats stats = m_search->stats();
+        QMetaObject::invokeMethod(this, [this, searchId, pos, bestMove, ponderMove, stats]() {
+            if (searchId != m_searchId) {
+                return;
+            }
+            onSearchFinished(pos, bestMove, ponderMove, stats);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ChessAI::onSearchFinished(const Engine::Position& root, Engine::Move bestMove, Engine::Move ponderMove,
+                               const Engine::SearchStats& stats)
+{
+    m_pondering = false;
+    m_lastStats = stats;
+
+    if (bestMove == Engine::MOVE_NONE) {
+        emit engineError("No valid moves available");
+        return;
     }
+    emitEngineMove(bestMove);
 
-    QVector<QPair<QPoint, QPoint>> moves = getAllValidMoves(board, currentColor);
-    if (moves.isEmpty()) {
-        return 0;
+    // 預先思考不計節點，只在全力時使用，否則 ponderhit 後會走出比技能等級強的著法
+    if (!m_ponderEnabled || m_skillLevel < Engine::MAX_SKILL_LEVEL || ponderMove == Engine::MOVE_NONE) {
+        return;
     }
 
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const auto& move : moves) {
-            // 保存狀態
-            QVector<Move> savedHistory = board->getMoveHistory();
-            PieceColor savedTurn = board->getCurrentTurn();
-            
-            // 執行移動
-            if (board->movePiece(move.first, move.second)) {
-                int eval = minimax(board, depth - 1, alpha, beta, false, aiColor);
-                
-                // 撤銷移動
-                board->undo();
-                
-                maxEval = std::max(maxEval, eval);
-                alpha = std::max(alpha, eval);
-                if (beta <= alpha) {
-                    break; // Beta cutoff
-                }
-            }
-        }
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const auto& move : moves) {
-            // 保存狀態
-            QVector<Move> savedHistory = board->getMoveHistory();
-            PieceColor savedTurn = board->getCurrentTurn();
-            
-            // 執行移動
-            if (board->movePiece(move.first, move.second)) {
-                int eval = minimax(board, depth - 1, alpha, beta, true, aiColor);
-                
-                // 撤銷移動
-                board->undo();
-                
-                minEval = std::min(minEval, eval);
-                beta = std::min(beta, eval);
-                if (beta <= alpha) {
-                    break; // Alpha cutoff
-                }
-            }
-        }
-        return minEval;
+    // 在預測的應著之後的局面開始預先思考
+    Engine::Position pos = root;
+    pos.doMove(bestMove);
+    Engine::MoveList legal;
+    pos.generateLegal(legal);
+    if (!legal.contains(ponderMove)) {
+        return;
     }
+    pos.doMove(ponderMove);
+    m_ponderKey = pos.key();
+    m_pondering = true;
+    launchSearch(pos, ponderLimits(), true);
 }
 
-QPair<QPoint, QPoint> ChessAI::getMinimaxMove(ChessBoard* board, PieceColor aiColor)
+bool ChessAI::ponderHit(ChessBoard* board)
 {
-    QVector<QPair<QPoint, QPoint>> validMoves = getAllValidMoves(board, aiColor);
-
-    if (validMoves.isEmpty()) {
-        return QPair<QPoint, QPoint>(QPoint(-1, -1), QPoint(-1, -1));
+    if (!m_pondering || m_skillLevel < Engine::MAX_SKILL_LEVEL) {
+        return false;
+    }
+    Engine::Position pos;
+    if (!pos.setFen(board->toFEN()) || pos.key() != m_ponderKey) {
+        return false;
     }
+    m_pondering = false;
+    m_search->ponderhit();
+    return true;
+}
 
-    QPair<QPoint, QPoint> bestMove = validMoves[0];
-    int bestScore = std::numeric_limits<int>::min();
-    int searchDepth = 3; // 深度 3-4 ply 為困難難度
-
-    for (const auto& move : validMoves) {
-        // 執行移動
-        if (board->movePiece(move.first, move.second)) {
-            int score = minimax(board, searchDepth - 1, 
-                              std::numeric_limits<int>::min(), 
-                              std::numeric_limits<int>::max(), 
-                              false, aiColor);
-            
-            // 撤銷移動
-            board->undo();
-            
-            if (score > bestScore) {
-                bestScore = score;
-                bestMove = move;
-            }
+void ChessAI::emitEngineMove(Engine::Move move)
+{
+    int from = Engine::moveFrom(move);
+    int to = Engine::moveTo(move);
+    PieceType promotion = PieceType::QUEEN;
+    if (Engine::moveType(move) == Engine::PROMOTION) {
+        switch (Engine::promotionKind(move)) {
+        case Engine::KNIGHT: promotion = PieceType::KNIGHT; break;
+        case Engine::BISHOP: promotion = PieceType::BISHOP; break;
+        case Engine::ROOK:   promotion = PieceType::ROOK; break;
+        default:             promotion = PieceType::QUEEN; break;
         }
     }
 
-    return bestMove;
+    emit moveReady(QPoint(Engine::boardColOf(from), Engine::boardRowOf(from)),
+                   QPoint(Engine::boardColOf(to), Engine::boardRowOf(to)),
+                   promotion);
 }
@@ -4,17 +4,28 @@
 #include "chessboard.h"
 #include "chesspiece.h"
 #include "uciengine.h"
+#include "search.h"
 #include <QPoint>
 #include <QVector>
 #include <QPair>
 #include <QObject>
+#include <QElapsedTimer>
 
+// 舊的三段難度，對應技能等級 5、10、20
 enum class AIDifficulty {
     EASY,
     MEDIUM,
     HARD
 };
 
+// 每步搜尋的額外限制；計時對局一律把雙方的剩餘時間交給引擎，這裡的限制再加在上面
+enum class SearchLimitMode {
+    Clock,     // 只依棋鐘（不計時的對局每步 1 秒）
+    MoveTime,  // 每步固定毫秒數
+    Depth,     // 固定深度
+    Nodes      // 固定節點數
+};
+
 class ChessAI : public QObject {
     Q_OBJECT
     
@@ -23,50 +34,101 @@ public:
     ~ChessAI();
 
     // 取得電腦的最佳移動（非同步，透過訊號返回）
-    void getBestMove(ChessBoard* board, PieceColor aiColor);
+    // clock 帶入棋鐘：time/inc（毫秒）與 movestogo，不計時的對局留空
+    void getBestMove(ChessBoard* board, PieceColor aiColor, const Engine::SearchLimits& clock = Engine::SearchLimits());
+
+    // 每步搜尋的額外限制，value 為毫秒、深度或節點數；Clock 模式忽略 value
+    void setSearchLimit(SearchLimitMode mode, int value);
 
     void setDifficulty(AIDifficulty difficulty);
     AIDifficulty getDifficulty() const { return m_difficulty; }
     
-    // 設定引擎技能等級 (0-20)
+    // 設定技能等級 (0-20)：外部引擎送出 Skill Level，內建引擎依等級限制節點數、
+    // 加入評估雜訊並從多條主變化中抽選
     void setSkillLevel(int level);
     int getSkillLevel() const { return m_skillLevel; }
     
-    // 初始化引擎
-    bool initializeEngine(const QString& enginePath);
+    // 外部 UCI 引擎由應用程式擁有並跨對局重複使用；nullptr 表示只用內建引擎
+    void setEngine(UCIEngine* engine);
+
+    // 開新局：丟棄進行中的搜尋與預先思考，清除內建引擎的置換表，外部引擎送出 ucinewgame
+    void newGame();
     
     // 使用引擎模式
     void setUseEngine(bool useEngine) { m_useEngine = useEngine; }
     bool isUsingEngine() const { return m_useEngine; }
 
+    // 內建引擎的搜尋執行緒數
+    void setThreads(int threads);
+
+    // 內建引擎的 NNUE 網路檔，空字串使用傳統評估；載入失敗時回傳 false 並改用傳統評估
+    bool setEvalFile(const QString& path);
+
+    // 預先思考（pondering）：走完一步後在玩家的時間繼續搜尋預測的應著，外部引擎以 go ponder / ponderhit 進行
+    // cpuLimit 為內建引擎預先思考時每個執行緒的 CPU 使用上限（10-100%）
+    void setPonderEnabled(bool enabled);
+    void setPonderCpuLimit(int cpuLimit);
+    // 悔棋、遊戲結束等使預測失效的情況下停止預先思考
+    void stopPondering();
+    // 停止內建引擎的搜尋並等所有執行緒結束；替換搜尋共用的資料（例如 Syzygy 殘局庫）前呼叫
+    // 正在思考的一步會提早以目前最佳著法回應
+    void stopSearch();
+
+    // 內建引擎最近一次搜尋的統計
+    Engine::SearchStats lastSearchStats() const { return m_lastStats; }
+
 signals:
-    void moveReady(QPoint from, QPoint to);
+    void moveReady(QPoint from, QPoint to, PieceType promotion = PieceType::QUEEN);
     void engineError(QString error);
+    // 內建引擎每完成一層迭代發出一次（在 GUI 執行緒）；預先思考與已被取代的搜尋不發出
+    void searchStatsUpdated(const Engine::SearchStats& stats);
 
 private slots:
-    void onEngineMoveFound(QString fromUCI, QString toUCI);
+    void onEngineMoveFound(QString fromUCI, QString toUCI, PieceType promotion);
     void onEngineError(QString error);
 
 private:
     AIDifficulty m_difficulty;
     int m_skillLevel;
     bool m_useEngine;
-    UCIEngine* m_engine;
+    UCIEngine* m_engine;       // 不擁有
+    bool m_waitingForEngine;   // 已向外部引擎請求著法，尚未收到回覆
     ChessBoard* m_currentBoard;
     PieceColor m_currentColor;
-
-    // 不同難度的移動策略（備用，當引擎不可用時）
-    QPair<QPoint, QPoint> getRandomMove(ChessBoard* board, PieceColor aiColor);
-    QPair<QPoint, QPoint> getBasicEvaluationMove(ChessBoard* board, PieceColor aiColor);
-    QPair<QPoint, QPoint> getMinimaxMove(ChessBoard* board, PieceColor aiColor);
+    Engine::Search* m_search;  // 內建引擎
+    int m_searchId;            // 只接受最近一次搜尋的結果
+    bool m_ponderEnabled;
+    int m_ponderCpuLimit;
+    bool m_pondering;          // 背景正在預先思考
+    quint64 m_ponderKey;       // 預先思考的局面（玩家走了預測的著法之後）
+    Engine::SearchStats m_lastStats;
+    SearchLimitMode m_limitMode;
+    int m_limitValue;
+    Engine::SearchLimits m_limits;  // 目前這一步的限制（含棋鐘），預先思考沿用
+    QElapsedTimer m_moveTimer;      // 這一步從請求到現在的時間，外部引擎預先思考時從棋鐘扣除
 
     // 輔助函數
-    QVector<QPair<QPoint, QPoint>> getAllValidMoves(ChessBoard* board, PieceColor color);
-    int evaluateBoard(ChessBoard* board, PieceColor aiColor);
-    int getPieceValue(ChessPiece* piece);
-    int minimax(ChessBoard* board, int depth, int alpha, int beta, bool maximizingPlayer, PieceColor aiColor);
     QPoint uciToPosition(const QString& uci);
     void updateSkillLevelFromDifficulty();
+
+    // 殘局庫：根節點直接取最佳著法（搜尋中的查詢由 Engine::Search 處理）
+    bool playTablebaseMove(ChessBoard* board);
+
+    // 內建殘局庫（KPK、KQK、KRK），不需外部檔案
+    bool playBitbaseMove(ChessBoard* board);
+
+    // 在背景執行緒以內建引擎搜尋，結果經由 moveReady 回傳
+    void startSearch(ChessBoard* board);
+    void launchSearch(const Engine::Position& pos, const Engine::SearchLimits& base, bool ponder);
+    void onSearchFinished(const Engine::Position& root, Engine::Move bestMove, Engine::Move ponderMove,
+                          const Engine::SearchStats& stats);
+    bool ponderHit(ChessBoard* board);
+    void startEnginePonder();  // 外部引擎在玩家的時間預先思考
+    Engine::SearchLimits ponderLimits() const;  // 預先思考用的棋鐘：輪到自己時的剩餘時間
+
+    // 從初始局面重播整盤棋，搜尋才看得到先前出現過的局面（重複和棋）
+    bool positionFromBoard(ChessBoard* board, Engine::Position* pos);
+    void emitEngineMove(Engine::Move move);
 };
 
 #endif // CHESSAI_H
@@ -1,9 +1,10 @@
 #include "chessboard.h"
+#include "position.h"
 #include <QDebug>
 
 ChessBoard::ChessBoard()
     : m_currentTurn(PieceColor::WHITE), m_enPassantTarget(-1, -1),
-    m_isGameOver(false), m_promotionPieceType(PieceType::QUEEN) {
+    m_isGameOver(false), m_promotionPieceType(PieceType::QUEEN), m_halfmoveClock(0), m_materialKey(0) {
     for (int i = 0; i < 8; ++i) {
         for (int j = 0; j < 8; ++j) {
             m_board[i][j] = nullptr;
@@ -75,6 +76,11 @@ void ChessBoard::initializeBoard() {
     m_currentTurn = PieceColor::WHITE;
     m_enPassantTarget = QPoint(-1, -1);
     m_moveHistory.clear();
+    m_halfmoveClock = 0;
+    recountMaterial();
+    m_startFEN = toFEN();
+    m_positionKeys.clear();
+    m_positionKeys.append(computePositionKey());
     m_isGameOver = false;
     m_gameStatus = tr("Game in progress");
 }
@@ -160,6 +166,7 @@ bool ChessBoard::movePiece(QPoint from, QPoint to, bool checkOnly) {
     move.capturedPiece = getPieceAt(to);
     move.movedPieceHadMoved = piece->hasMoved();
     move.previousEnPassantTarget = m_enPassantTarget;
+    move.previousHalfmoveClock = m_halfmoveClock;
     move.movedPieceType = piece->getType();
     move.movedPieceColor = piece->getColor();
 
@@ -218,28 +225,7 @@ bool ChessBoard::movePiece(QPoint from, QPoint to, bool checkOnly) {
             // 重設為預設值（后）以供下次使用
             m_promotionPieceType = PieceType::QUEEN;
             
-            m_moveHistory.append(move);
-            switchTurn();
-
-            // 檢查新的目前玩家是否將死/逼和/棋子不足
-            if (isCheckmate(m_currentTurn)) {
-                m_isGameOver = true;
-                PieceColor winner = (m_currentTurn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
-                m_gameStatus = (winner == PieceColor::WHITE) ?
-                                   tr("White wins by checkmate!") : tr("Black wins by checkmate!");
-            } else if (isStalemate(m_currentTurn)) {
-                m_isGameOver = true;
-                m_gameStatus = tr("Stalemate - Draw!");
-            } else if (isInsufficientMaterial()) {
-                m_isGameOver = true;
-                m_gameStatus = tr("Draw - Insufficient Material!");
-            } else if (isKingInCheck(m_currentTurn)) {
-                m_gameStatus = (m_currentTurn == PieceColor::WHITE) ?
-                                   tr("White is in check!") : tr("Black is in check!");
-            } else {
-                m_gameStatus = tr("Game in progress");
-            }
-
+            finishMove(move);
             return true;
         }
     }
@@ -249,28 +235,7 @@ bool ChessBoard::movePiece(QPoint from, QPoint to, bool checkOnly) {
         move.wasCastling = true;
         bool kingSide = to.x() > from.x();
         performCastling(m_currentTurn, kingSide);
-        m_moveHistory.append(move);
-        switchTurn();
-
-        // 檢查新的目前玩家是否將死/逼和/棋子不足
-        if (isCheckmate(m_currentTurn)) {
-            m_isGameOver = true;
-            PieceColor winner = (m_currentTurn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
-            m_gameStatus = (winner == PieceColor::WHITE) ?
-                               tr("White wins by checkmate!") : tr("Black wins by checkmate!");
-        } else if (isStalemate(m_currentTurn)) {
-            m_isGameOver = true;
-            m_gameStatus = tr("Stalemate - Draw!");
-        } else if (isInsufficientMaterial()) {
-            m_isGameOver = true;
-            m_gameStatus = tr("Draw - Insufficient Material!");
-        } else if (isKingInCheck(m_currentTurn)) {
-            m_gameStatus = (m_currentTurn == PieceColor::WHITE) ?
-                               tr("White is in check!") : tr("Black is in check!");
-        } else {
-            m_gameStatus = tr("Game in progress");
-        }
-
+        finishMove(move);
         return true;
     }
 
@@ -280,10 +245,31 @@ bool ChessBoard::movePiece(QPoint from, QPoint to, bool checkOnly) {
     piece->setPosition(to);
     piece->setMoved(true);
 
+    finishMove(move);
+    return true;
+}
+
+void ChessBoard::finishMove(const Move& move) {
+    if (move.capturedPiece != nullptr) {
+        removeMaterial(move.capturedPiece->getColor(), move.capturedPiece->getType());
+    }
+    if (move.wasPromotion) {
+        removeMaterial(move.movedPieceColor, PieceType::PAWN);
+        addMaterial(move.movedPieceColor, move.promotedTo);
+    }
+
+    // 吃子或兵步重設半回合計數
+    if (move.movedPieceType == PieceType::PAWN || move.capturedPiece != nullptr) {
+        m_halfmoveClock = 0;
+    } else {
+        ++m_halfmoveClock;
+    }
+
     m_moveHistory.append(move);
     switchTurn();
+    m_positionKeys.append(computePositionKey());
 
-    // 檢查新的目前玩家（即將移動的玩家）是否將死/逼和/棋子不足
+    // 檢查新的目前玩家（即將移動的玩家）是否將死/逼和/和棋
     if (isCheckmate(m_currentTurn)) {
         m_isGameOver = true;
         // 剛移動的玩家（與目前回合相反）獲勝
@@ -296,14 +282,18 @@ bool ChessBoard::movePiece(QPoint from, QPoint to, bool checkOnly) {
     } else if (isInsufficientMaterial()) {
         m_isGameOver = true;
         m_gameStatus = tr("Draw - Insufficient Material!");
+    } else if (isFiftyMoveRule()) {
+        m_isGameOver = true;
+        m_gameStatus = tr("Draw - Fifty-Move Rule!");
+    } else if (isThreefoldRepetition()) {
+        m_isGameOver = true;
+        m_gameStatus = tr("Draw - Threefold Repetition!");
     } else if (isKingInCheck(m_currentTurn)) {
         m_gameStatus = (m_currentTurn == PieceColor::WHITE) ?
                            tr("White is in check!") : tr("Black is in check!");
     } else {
         m_gameStatus = tr("Game in progress");
     }
-
-    return true;
 }
 
 void ChessBoard::switchTurn() {
@@ -542,79 +532,92 @@ bool ChessBoard::isStalemate(PieceColor color) {
 }
 
 bool ChessBoard::isInsufficientMaterial() const {
-    // Count pieces for each side
-    int whiteKnights = 0, blackKnights = 0;
-    int whiteBishops = 0, blackBishops = 0;
-    int whiteOther = 0, blackOther = 0; // pawns, rooks, queens
-    
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = m_board[row][col];
-            if (piece == nullptr || piece->getType() == PieceType::KING) {
-                continue;
-            }
-            
-            if (piece->getColor() == PieceColor::WHITE) {
-                if (piece->getType() == PieceType::KNIGHT) {
-                    whiteKnights++;
-                } else if (piece->getType() == PieceType::BISHOP) {
-                    whiteBishops++;
-                } else {
-                    whiteOther++;
-                }
-            } else {
-                if (piece->getType() == PieceType::KNIGHT) {
-                    blackKnights++;
-                } else if (piece->getType() == PieceType::BISHOP) {
-                    blackBishops++;
-                } else {
-                    blackOther++;
-                }
-            }
+    auto count = [this](PieceColor color, PieceType type) { return getPieceCount(color, type); };
+    const int whiteKnights = count(PieceColor::WHITE, PieceType::KNIGHT);
+    const int blackKnights = count(PieceColor::BLACK, PieceType::KNIGHT);
+    const int whiteBishops = count(PieceColor::WHITE, PieceType::BISHOP);
+    const int blackBishops = count(PieceColor::BLACK, PieceType::BISHOP);
+
+    // 任何一方有兵、車或后就足以將死
+    for (PieceColor color : { PieceColor::WHITE, PieceColor::BLACK }) {
+        if (count(color, PieceType::PAWN) || count(color, PieceType::ROOK) || count(color, PieceType::QUEEN)) {
+            return false;
         }
     }
-    
-    // If either side has pawns, rooks, or queens, there's sufficient material
-    if (whiteOther > 0 || blackOther > 0) {
-        return false;
-    }
-    
-    // King vs King
-    if (whiteKnights == 0 && blackKnights == 0 && whiteBishops == 0 && blackBishops == 0) {
+
+    // 雙王，或王加一象對王
+    if (whiteKnights == 0 && blackKnights == 0 && whiteBishops + blackBishops <= 1) {
         return true;
     }
-    
-    // King + Bishop vs King
-    if (whiteKnights == 0 && blackKnights == 0) {
-        if ((whiteBishops == 1 && blackBishops == 0) || 
-            (whiteBishops == 0 && blackBishops == 1)) {
+
+    // 只剩馬：王加一馬對王、王馬對王馬、王加兩馬對王（需對方配合才能將死，一律視為和棋）
+    if (whiteBishops == 0 && blackBishops == 0) {
+        if (whiteKnights + blackKnights <= 1 || (whiteKnights == 1 && blackKnights == 1)
+            || (whiteKnights == 2 && blackKnights == 0) || (whiteKnights == 0 && blackKnights == 2)) {
             return true;
         }
     }
-    
-    // King + Knight vs King
-    if (whiteBishops == 0 && blackBishops == 0) {
-        if ((whiteKnights == 1 && blackKnights == 0) || 
-            (whiteKnights == 0 && blackKnights == 1)) {
-            return true;
+
+    return false;
+}
+
+int ChessBoard::getTotalPieceCount() const {
+    int total = 0;
+    for (int color = 0; color < 2; ++color) {
+        for (int type = 0; type < 6; ++type) {
+            total += m_pieceCount[color][type];
         }
-        // King + Knight vs King + Knight (two knights total)
-        if (whiteKnights == 1 && blackKnights == 1) {
-            return true;
+    }
+    return total;
+}
+
+void ChessBoard::recountMaterial() {
+    for (int color = 0; color < 2; ++color) {
+        for (int type = 0; type < 6; ++type) {
+            m_pieceCount[color][type] = 0;
         }
     }
-    
-    // King + two Knights vs King (technically can checkmate with help, but treating as draw per requirements)
-    if (whiteBishops == 0 && blackBishops == 0) {
-        if ((whiteKnights == 2 && blackKnights == 0) || 
-            (whiteKnights == 0 && blackKnights == 2)) {
+    m_materialKey = 0;
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            if (m_board[row][col] != nullptr) {
+                addMaterial(m_board[row][col]->getColor(), m_board[row][col]->getType());
+            }
+        }
+    }
+}
+
+void ChessBoard::addMaterial(PieceColor color, PieceType type) {
+    ++m_pieceCount[int(color)][int(type)];
+    m_materialKey += materialKeyOf(color, type);
+}
+
+void ChessBoard::removeMaterial(PieceColor color, PieceType type) {
+    --m_pieceCount[int(color)][int(type)];
+    m_materialKey -= materialKeyOf(color, type);
+}
+
+bool ChessBoard::isThreefoldRepetition() const {
+    // 只需往回看到上一次吃子或兵步；同一方走棋的局面才可能相同，每次退兩步
+    const int last = m_positionKeys.size() - 1;
+    const int end = qMin(m_halfmoveClock, last);
+    int count = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (m_positionKeys[last - i] == m_positionKeys[last] && ++count == 2) {
             return true;
         }
     }
-    
     return false;
 }
 
+quint64 ChessBoard::computePositionKey() const {
+    // 沿用引擎的 Zobrist 鍵：易位權一併計入，吃過路兵格只在真的能吃時才計入，
+    // 與規則對「相同局面」的定義一致
+    Engine::Position pos;
+    pos.setFen(toFEN());
+    return pos.key();
+}
+
 bool ChessBoard::canCastle(PieceColor color, bool kingSide) const {
     int row = (color == PieceColor::WHITE) ? 7 : 0;
     int kingCol = 4;
@@ -686,6 +689,19 @@ bool ChessBoard::undo() {
     // Reset game over state if we're undoing
     m_isGameOver = false;
 
+    // 還原半回合計數並移除目前局面的雜湊鍵
+    m_halfmoveClock = lastMove.previousHalfmoveClock;
+    m_positionKeys.removeLast();
+
+    // 還原子力計數
+    if (lastMove.capturedPiece != nullptr) {
+        addMaterial(lastMove.capturedPiece->getColor(), lastMove.capturedPiece->getType());
+    }
+    if (lastMove.wasPromotion) {
+        removeMaterial(lastMove.movedPieceColor, lastMove.promotedTo);
+        addMaterial(lastMove.movedPieceColor, PieceType::PAWN);
+    }
+
     // Switch turn back (since we switched it after making the move)
     switchTurn();
 
@@ -925,3 +941,62 @@ void ChessBoard::getBoardStateAtMove(int moveIndex, ChessPiece* outputBoard[8][8
         turn = (turn == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
     }
 }
+
+QString ChessBoard::toFEN() const {
+    static const char pieceChars[] = "prnbqk";  // 依 PieceType 順序
+    QString fen;
+
+    // 棋盤位置（row 0 為第 8 橫列）
+    for (int row = 0; row < 8; ++row) {
+        int emptyCount = 0;
+        for (int col = 0; col < 8; ++col) {
+            ChessPiece* piece = m_board[row][col];
+            if (!piece) {
+                ++emptyCount;
+                continue;
+            }
+            if (emptyCount > 0) {
+                fen += QString::number(emptyCount);
+                emptyCount = 0;
+            }
+            char c = pieceChars[static_cast<int>(piece->getType())];
+            fen += QChar(piece->getColor() == PieceColor::WHITE ? char(toupper(c)) : c);
+        }
+        if (emptyCount > 0) {
+            fen += QString::number(emptyCount);
+        }
+        if (row < 7) {
+            fen += '/';
+        }
+    }
+
+    fen += (m_currentTurn == PieceColor::WHITE) ? " w " : " b ";
+
+    // 王車易位權：王與對應的車都還在原位且沒有移動過
+    auto unmoved = [this](int row, int col, PieceType type) {
+        ChessPiece* piece = m_board[row][col];
+        return piece && piece->getType() == type && !piece->hasMoved();
+    };
+    QString castling;
+    if (unmoved(7, 4, PieceType::KING)) {
+        if (unmoved(7, 7, PieceType::ROOK)) castling += 'K';
+        if (unmoved(7, 0, PieceType::ROOK)) castling += 'Q';
+    }
+    if (unmoved(0, 4, PieceType::KING)) {
+        if (unmoved(0, 7, PieceType::ROOK)) castling += 'k';
+        if (unmoved(0, 0, PieceType::ROOK)) castling += 'q';
+    }
+    fen += castling.isEmpty() ? QString("-") : castling;
+    fen += ' ';
+
+    // 吃過路兵目標格
+    if (isValidPosition(m_enPassantTarget)) {
+        fen += QChar(char('a' + m_enPassantTarget.x()));
+        fen += QChar(char('8' - m_enPassantTarget.y()));
+    } else {
+        fen += '-';
+    }
+
+    fen += QString(" %1 %2").arg(m_halfmoveClock).arg(m_moveHistory.size() / 2 + 1);
+    return fen;
+}
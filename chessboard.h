@@ -17,12 +17,13 @@ struct Move {
     PieceType promotedTo;
     bool movedPieceHadMoved;  // 追蹤移動的棋子在此移動前是否已移動過
     QPoint previousEnPassantTarget;  // 儲存此移動前的吃過路兵目標
+    int previousHalfmoveClock;  // 儲存此移動前的半回合計數（用於撤銷）
     PieceType movedPieceType;  // 儲存移動的棋子類型（用於撤銷升變）
     PieceColor movedPieceColor;  // 儲存移動的棋子顏色
 
     Move() : capturedPiece(nullptr), wasCastling(false), wasEnPassant(false),
         wasPromotion(false), promotedTo(PieceType::QUEEN), movedPieceHadMoved(false),
-        previousEnPassantTarget(-1, -1), movedPieceType(PieceType::PAWN), 
+        previousEnPassantTarget(-1, -1), previousHalfmoveClock(0), movedPieceType(PieceType::PAWN), 
         movedPieceColor(PieceColor::WHITE) {}
 } ;
 
@@ -49,7 +50,20 @@ public:
     bool isKingInCheck(PieceColor color) const;
     bool isCheckmate(PieceColor color);  // 檢查國王是否被將軍且無有效移動
     bool isStalemate(PieceColor color);  // 檢查是否未被將軍但無有效移動
-    bool isInsufficientMaterial() const;  // 檢查是否棋子不足以將死
+    bool isInsufficientMaterial() const;  // 檢查是否棋子不足以將死（只查子力計數）
+
+    // 子力計數在走子與撤銷時增量更新，查詢不需掃描棋盤
+    int getPieceCount(PieceColor color, PieceType type) const { return m_pieceCount[int(color)][int(type)]; }
+    int getTotalPieceCount() const;  // 包括雙王
+    // 子力組合簽名：每種棋子的數量各佔 4 位元，子力相同的局面簽名相同且不會碰撞
+    quint64 getMaterialKey() const { return m_materialKey; }
+    // count 個指定棋子在簽名中的值；子力組合的簽名是各棋子的值相加
+    static quint64 materialKeyOf(PieceColor color, PieceType type, int count = 1) {
+        return quint64(count) << (4 * (int(color) * 6 + int(type)));
+    }
+    bool isThreefoldRepetition() const;  // 目前局面是否已出現三次
+    bool isFiftyMoveRule() const { return m_halfmoveClock >= 100; }  // 雙方各 50 步沒有吃子或兵步
+    int getHalfmoveClock() const { return m_halfmoveClock; }
 
     PieceColor getCurrentTurn() const { return m_currentTurn; }
     void switchTurn();
@@ -70,6 +84,11 @@ public:
     bool undo();  // 撤銷上一步移動
     void getBoardStateAtMove(int moveIndex, ChessPiece* outputBoard[8][8], PieceColor& turn) const;
 
+    // 目前局面的 FEN（易位權由王車是否移動過判斷）
+    QString toFEN() const;
+    // 第一步之前的局面，搭配 getMoveHistory() 可重播整局
+    QString getStartFEN() const { return m_startFEN; }
+
 private:
     ChessPiece* m_board[8][8];
     PieceColor m_currentTurn;
@@ -78,11 +97,21 @@ private:
     QString m_gameStatus;
     bool m_isGameOver;
     PieceType m_promotionPieceType;  // 儲存玩家選擇的升變棋子類型
+    int m_halfmoveClock;  // 自上一次吃子或兵步以來的半回合數
+    QString m_startFEN;
+    QVector<quint64> m_positionKeys;  // 每個局面的雜湊鍵，第 0 筆為初始局面，最後一筆為目前局面
+    int m_pieceCount[2][6];  // [PieceColor][PieceType]
+    quint64 m_materialKey;
 
     void clearBoard();
     bool wouldBeInCheck(QPoint from, QPoint to, PieceColor color) const; // 常量查詢
     QPoint findKing(PieceColor color) const;
     bool hasAnyValidMoves(PieceColor color);
+    quint64 computePositionKey() const;
+    void recountMaterial();  // 從棋盤重新計算子力（只在擺好初始局面時使用）
+    void addMaterial(PieceColor color, PieceType type);
+    void removeMaterial(PieceColor color, PieceType type);
+    void finishMove(const Move& move);  // 記錄移動、切換回合並更新遊戲狀態
 
     // 在提供的棋盤陣列上操作的輔助函數：
     QPoint findKingOnBoard(ChessPiece* const board[8][8], PieceColor color) const;
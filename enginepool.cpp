@@ -0,0 +1,132 @@
+#include "enginepool.h"
+#include <QDebug>
+#include <QFileInfo>
+
+// 每個程序至少要有的置換表（Stockfish 的預設值）
+static const int MIN_HASH_MB = 16;
+
+EnginePool::EnginePool(QObject *parent)
+    : QObject(parent),
+      m_size(0),
+      m_totalThreads(1),
+      m_totalHashMb(16),
+      m_nextTicket(1)
+{
+}
+
+bool EnginePool::initialize(const QString& enginePath, int size, int totalThreads, int totalHashMb)
+{
+    if (!QFileInfo::exists(enginePath)) {
+        qDebug() << "Engine not found:" << enginePath;
+        return false;
+    }
+    m_enginePath = enginePath;
+    m_totalThreads = qMax(1, totalThreads);
+    m_totalHashMb = qMax(MIN_HASH_MB, totalHashMb);
+
+    // 預算不夠每個程序 1 個執行緒與 MIN_HASH_MB 時減少程序數，合計不會超出預算
+    const int affordable = qMin(m_totalThreads, m_totalHashMb / MIN_HASH_MB);
+    m_size = qBound(1, size, affordable);
+    if (m_size < size) {
+        qDebug() << "Engine pool reduced to" << m_size << "processes to fit its budget";
+    }
+    return true;
+}
+
+int EnginePool::threadsPerEngine() const
+{
+    return m_totalThreads / qMax(1, m_size);
+}
+
+int EnginePool::hashPerEngine() const
+{
+    return m_totalHashMb / qMax(1, m_size);
+}
+
+void EnginePool::setOption(const QString& name, const QString& value)
+{
+    if (name.compare("Threads", Qt::CaseInsensitive) == 0 || name.compare("Hash", Qt::CaseInsensitive) == 0) {
+        qDebug() << "Engine pool sets" << name << "from its budget";
+        return;
+    }
+    m_options.insert(name, value);
+    for (UCIEngine* engine : m_engines) {
+        engine->setOption(name, value);
+    }
+}
+
+int EnginePool::acquire(LeaseCallback onLeased, int priority)
+{
+    UCIEngine* engine = nullptr;
+    if (!m_idle.isEmpty()) {
+        engine = m_idle.takeFirst();
+    } else if (m_engines.size() < m_size) {
+        engine = startEngine();
+    }
+
+    const int ticket = m_nextTicket++;
+    if (engine) {
+        lease(engine, onLeased);
+        return ticket;
+    }
+
+    // 插在優先順序較低的請求之前
+    int index = 0;
+    while (index < m_waiting.size() && m_waiting[index].priority >= priority) {
+        ++index;
+    }
+    m_waiting.insert(index, { ticket, priority, onLeased });
+    return ticket;
+}
+
+void EnginePool::cancel(int ticket)
+{
+    for (int i = 0; i < m_waiting.size(); ++i) {
+        if (m_waiting[i].ticket == ticket) {
+            m_waiting.removeAt(i);
+            return;
+        }
+    }
+}
+
+void EnginePool::release(UCIEngine* engine)
+{
+    if (!engine || !m_engines.contains(engine) || m_idle.contains(engine)) {
+        return;
+    }
+
+    // 下一個工作從乾淨的狀態開始：借用者的連線與搜尋都不留下，ucinewgame 之後的請求等到 readyok
+    engine->disconnect();
+    engine->newGame();
+
+    if (!m_waiting.isEmpty()) {
+        const Request request = m_waiting.takeFirst();
+        lease(engine, request.onLeased);
+    } else {
+        m_idle.append(engine);
+    }
+}
+
+UCIEngine* EnginePool::startEngine()
+{
+    UCIEngine* engine = new UCIEngine(this);
+    for (auto it = m_options.constBegin(); it != m_options.constEnd(); ++it) {
+        engine->setOption(it.key(), it.value());
+    }
+    engine->setOption("Threads", QString::number(threadsPerEngine()));
+    engine->setOption("Hash", QString::number(hashPerEngine()));
+    engine->initialize(m_enginePath);
+    m_engines.append(engine);
+    return engine;
+}
+
+void EnginePool::lease(UCIEngine* engine, const LeaseCallback& onLeased)
+{
+    // 多次失敗而放棄的程序在交出前重新啟動
+    if (!engine->isAvailable()) {
+        engine->restart();
+    }
+    if (onLeased) {
+        onLeased(engine);
+    }
+}
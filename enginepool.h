@@ -0,0 +1,69 @@
+#ifndef ENGINEPOOL_H
+#define ENGINEPOOL_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <functional>
+#include "uciengine.h"
+
+// 同一個外部引擎的多個程序，借給需要同時分析的工作（提示、整盤覆盤、批次評估局面等）
+// 程序在第一次需要時才啟動，最多 size 個；整體的執行緒與置換表預算平均分給每個程序
+// 全部借出時請求依優先順序（數字大者先）與先後排隊，有程序歸還時交給下一個
+class EnginePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    using LeaseCallback = std::function<void(UCIEngine* engine)>;
+
+    explicit EnginePool(QObject *parent = nullptr);
+
+    // 設定執行檔與大小，不啟動程序；執行檔不存在時回傳 false
+    // totalThreads 與 totalHashMb 是所有程序合計的預算；不夠每個程序 1 個執行緒與 16 MB 時 size 會減少
+    bool initialize(const QString& enginePath, int size,
+                    int totalThreads = UCIEngine::defaultThreads(),
+                    int totalHashMb = UCIEngine::defaultHashMb());
+
+    int size() const { return m_size; }
+    int threadsPerEngine() const;
+    int hashPerEngine() const;  // MB
+
+    // 所有程序共用的選項（例如 SyzygyPath），之後啟動的程序也會套用；Threads 與 Hash 由預算決定
+    void setOption(const QString& name, const QString& value);
+
+    // 借用一個程序：有空閒的程序（或還能再啟動一個）時在呼叫中直接交給 onLeased，否則排隊
+    // 回傳的編號用於 cancel()；交出的程序可能還在握手，請求會排入它的佇列
+    int acquire(LeaseCallback onLeased, int priority = 0);
+    // 取消還在排隊的請求；已經交出的不受影響
+    void cancel(int ticket);
+    // 歸還：停止搜尋、斷開借用者對它的所有連線並送出 ucinewgame，再交給下一個排隊的請求
+    void release(UCIEngine* engine);
+
+    int idleCount() const { return m_idle.size(); }
+    int leasedCount() const { return m_engines.size() - m_idle.size(); }
+    int queuedCount() const { return m_waiting.size(); }
+
+private:
+    struct Request {
+        int ticket;
+        int priority;
+        LeaseCallback onLeased;
+    };
+
+    QString m_enginePath;
+    int m_size;
+    int m_totalThreads;
+    int m_totalHashMb;
+    QList<UCIEngine*> m_engines;         // 已啟動的程序（子物件，隨池刪除時結束）
+    QList<UCIEngine*> m_idle;            // 其中沒有借出的
+    QList<Request> m_waiting;            // 依優先順序排列，同優先順序依先後
+    QMap<QString, QString> m_options;
+    int m_nextTicket;
+
+    UCIEngine* startEngine();
+    void lease(UCIEngine* engine, const LeaseCallback& onLeased);
+};
+
+#endif // ENGINEPOOL_H
@@ -0,0 +1,148 @@
+// 由 tools/tuner 產生，請勿手動修改
+// 初始值：簡化評估表（Simplified Evaluation Function），尚未以資料調校
+#ifndef EVALPARAMS_H
+#define EVALPARAMS_H
+
+// 評估參數：每一項分為開局（Mg）與殘局（Eg）兩個值，依剩餘子力線性漸變
+// 位置表以白方視角、a8 在左上角書寫，順序為兵、馬、象、車、后、王
+namespace Engine {
+namespace EvalParams {
+
+const int MaterialMg[6] = { 100, 320, 330, 500, 900, 0 };
+const int MaterialEg[6] = { 100, 320, 330, 500, 900, 0 };
+
+const int PstMg[6][64] = {
+    {   // Pawn
+           0,    0,    0,    0,    0,    0,    0,    0,
+          50,   50,   50,   50,   50,   50,   50,   50,
+          10,   10,   20,   30,   30,   20,   10,   10,
+           5,    5,   10,   25,   25,   10,    5,    5,
+           0,    0,    0,   20,   20,    0,    0,    0,
+           5,   -5,  -10,    0,    0,  -10,   -5,    5,
+           5,   10,   10,  -20,  -20,   10,   10,    5,
+           0,    0,    0,    0,    0,    0,    0,    0
+    },
+    {   // Knight
+         -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+         -40,  -20,    0,    0,    0,    0,  -20,  -40,
+         -30,    0,   10,   15,   15,   10,    0,  -30,
+         -30,    5,   15,   20,   20,   15,    5,  -30,
+         -30,    0,   15,   20,   20,   15,    0,  -30,
+         -30,    5,   10,   15,   15,   10,    5,  -30,
+         -40,  -20,    0,    5,    5,    0,  -20,  -40,
+         -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50
+    },
+    {   // Bishop
+         -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+         -10,    0,    0,    0,    0,    0,    0,  -10,
+         -10,    0,    5,   10,   10,    5,    0,  -10,
+         -10,    5,    5,   10,   10,    5,    5,  -10,
+         -10,    0,   10,   10,   10,   10,    0,  -10,
+         -10,   10,   10,   10,   10,   10,   10,  -10,
+         -10,    5,    0,    0,    0,    0,    5,  -10,
+         -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20
+    },
+    {   // Rook
+           0,    0,    0,    0,    0,    0,    0,    0,
+           5,   10,   10,   10,   10,   10,   10,    5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+           0,    0,    0,    5,    5,    0,    0,    0
+    },
+    {   // Queen
+         -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+         -10,    0,    0,    0,    0,    0,    0,  -10,
+         -10,    0,    5,    5,    5,    5,    0,  -10,
+          -5,    0,    5,    5,    5,    5,    0,   -5,
+           0,    0,    5,    5,    5,    5,    0,   -5,
+         -10,    5,    5,    5,    5,    5,    0,  -10,
+         -10,    0,    5,    0,    0,    0,    0,  -10,
+         -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20
+    },
+    {   // King
+         -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+         -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+         -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+         -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+         -20,  -30,  -30,  -40,  -40,  -30,  -30,  -20,
+         -10,  -20,  -20,  -20,  -20,  -20,  -20,  -10,
+          20,   20,    0,    0,    0,    0,   20,   20,
+          20,   30,   10,    0,    0,   10,   30,   20
+    }
+};
+
+const int PstEg[6][64] = {
+    {   // Pawn
+           0,    0,    0,    0,    0,    0,    0,    0,
+          50,   50,   50,   50,   50,   50,   50,   50,
+          10,   10,   20,   30,   30,   20,   10,   10,
+           5,    5,   10,   25,   25,   10,    5,    5,
+           0,    0,    0,   20,   20,    0,    0,    0,
+           5,   -5,  -10,    0,    0,  -10,   -5,    5,
+           5,   10,   10,  -20,  -20,   10,   10,    5,
+           0,    0,    0,    0,    0,    0,    0,    0
+    },
+    {   // Knight
+         -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+         -40,  -20,    0,    0,    0,    0,  -20,  -40,
+         -30,    0,   10,   15,   15,   10,    0,  -30,
+         -30,    5,   15,   20,   20,   15,    5,  -30,
+         -30,    0,   15,   20,   20,   15,    0,  -30,
+         -30,    5,   10,   15,   15,   10,    5,  -30,
+         -40,  -20,    0,    5,    5,    0,  -20,  -40,
+         -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50
+    },
+    {   // Bishop
+         -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+         -10,    0,    0,    0,    0,    0,    0,  -10,
+         -10,    0,    5,   10,   10,    5,    0,  -10,
+         -10,    5,    5,   10,   10,    5,    5,  -10,
+         -10,    0,   10,   10,   10,   10,    0,  -10,
+         -10,   10,   10,   10,   10,   10,   10,  -10,
+         -10,    5,    0,    0,    0,    0,    5,  -10,
+         -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20
+    },
+    {   // Rook
+           0,    0,    0,    0,    0,    0,    0,    0,
+           5,   10,   10,   10,   10,   10,   10,    5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+          -5,    0,    0,    0,    0,    0,    0,   -5,
+           0,    0,    0,    5,    5,    0,    0,    0
+    },
+    {   // Queen
+         -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+         -10,    0,    0,    0,    0,    0,    0,  -10,
+         -10,    0,    5,    5,    5,    5,    0,  -10,
+          -5,    0,    5,    5,    5,    5,    0,   -5,
+           0,    0,    5,    5,    5,    5,    0,   -5,
+         -10,    5,    5,    5,    5,    5,    0,  -10,
+         -10,    0,    5,    0,    0,    0,    0,  -10,
+         -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20
+    },
+    {   // King
+         -50,  -40,  -30,  -20,  -20,  -30,  -40,  -50,
+         -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+         -30,  -10,   20,   30,   30,   20,  -10,  -30,
+         -30,  -10,   30,   40,   40,   30,  -10,  -30,
+         -30,  -10,   30,   40,   40,   30,  -10,  -30,
+         -30,  -10,   20,   30,   30,   20,  -10,  -30,
+         -30,  -30,    0,    0,    0,    0,  -30,  -30,
+         -50,  -30,  -30,  -30,  -30,  -30,  -30,  -50
+    }
+};
+
+const int BishopPairMg = 30;
+const int BishopPairEg = 30;
+const int TempoMg = 10;
+const int TempoEg = 10;
+
+}
+}
+
+#endif // EVALPARAMS_H
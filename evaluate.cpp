@@ -0,0 +1,68 @@
+#include "evaluate.h"
+#include "bitbase.h"
+#include "evalparams.h"
+
+namespace Engine {
+
+const int PieceValue[PIECE_KIND_NB] = { 100, 320, 330, 500, 900, 0 };
+
+namespace {
+
+// 階段：每方馬象各 1、車 2、后 4，滿值 24 為開局
+const int PhaseWeight[PIECE_KIND_NB] = { 0, 1, 1, 2, 4, 0 };
+const int MaxPhase = 24;
+
+// 白方的格子直接翻成表格索引（a8 = 0）；黑方上下鏡射後套用同一張表
+inline int tableIndex(Color c, int sq)
+{
+    return c == WHITE ? sq ^ 56 : sq;
+}
+
+}
+
+int evaluate(const Position& pos)
+{
+    if (pos.pieceCount() <= 4) {
+        int value;
+        if (Bitbases::evaluate(pos, &value)) {
+            return value;
+        }
+    }
+
+    using namespace EvalParams;
+
+    int mg = 0;
+    int eg = 0;
+    int phase = 0;
+
+    for (Color c : { WHITE, BLACK }) {
+        const int sign = c == WHITE ? 1 : -1;
+
+        for (int k = PAWN; k <= KING; ++k) {
+            Bitboard b = pos.pieces(c, PieceKind(k));
+            phase += PhaseWeight[k] * pos.count(c, PieceKind(k));
+            while (b) {
+                const int index = tableIndex(c, popLsb(b));
+                mg += sign * (MaterialMg[k] + PstMg[k][index]);
+                eg += sign * (MaterialEg[k] + PstEg[k][index]);
+            }
+        }
+
+        if (pos.count(c, BISHOP) >= 2) {
+            mg += sign * BishopPairMg;
+            eg += sign * BishopPairEg;
+        }
+    }
+
+    const int tempo = pos.sideToMove() == WHITE ? 1 : -1;
+    mg += tempo * TempoMg;
+    eg += tempo * TempoEg;
+
+    // 依剩餘子力在開局值與殘局值之間線性漸變
+    phase = qMin(phase, MaxPhase);
+    const int score = (mg * phase + eg * (MaxPhase - phase)) / MaxPhase;
+
+    return pos.sideToMove() == WHITE ? score : -score;
+}
+
+}
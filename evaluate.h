@@ -0,0 +1,56 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "position.h"
+#include <algorithm>
+#include <vector>
+
+namespace Engine {
+
+// 靜態評估：子力、位置表與雙象，開局/殘局漸變，參數在 evalparams.h（由 tools/tuner 產生）
+// 分數從輪走方角度，單位為百分兵
+// 三子殘局與 KBNK 改用內建殘局庫的結果
+int evaluate(const Position& pos);
+
+// 評估快取：以局面雜湊值直接對應的小表，每個搜尋執行緒一份，不需要同步
+// 置換表沒有存下評估值的節點（例如被取代的項目）可以省掉一次完整評估
+class EvalCache {
+public:
+    explicit EvalCache(int sizeLog2 = 14) : m_entries(size_t(1) << sizeLog2), m_mask((quint64(1) << sizeLog2) - 1) {}
+
+    void clear() { std::fill(m_entries.begin(), m_entries.end(), Entry()); }
+
+    // 找到時回傳 true 並填入 value
+    bool probe(quint64 key, int* value) const
+    {
+        const Entry& entry = m_entries[key & m_mask];
+        if (entry.key != key) {
+            return false;
+        }
+        *value = entry.value;
+        return true;
+    }
+
+    void save(quint64 key, int value)
+    {
+        Entry& entry = m_entries[key & m_mask];
+        entry.key = key;
+        entry.value = value;
+    }
+
+private:
+    struct Entry {
+        quint64 key = 0;
+        int value = 0;
+    };
+
+    std::vector<Entry> m_entries;
+    quint64 m_mask;
+};
+
+// 棋子的基本價值，供著法排序與剪枝使用，不隨調校改變
+extern const int PieceValue[PIECE_KIND_NB];
+
+}
+
+#endif // EVALUATE_H
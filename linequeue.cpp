@@ -0,0 +1,73 @@
+#include "linequeue.h"
+#include <cstring>
+
+LineQueue::LineQueue(int capacityBytes)
+    : m_head(0)
+    , m_tail(0)
+    , m_wakeupPending(false)
+{
+    quint32 capacity = 1024;
+    while (capacity < quint32(capacityBytes)) {
+        capacity <<= 1;
+    }
+    m_buffer = new char[capacity];
+    m_mask = capacity - 1;
+}
+
+LineQueue::~LineQueue()
+{
+    delete[] m_buffer;
+}
+
+void LineQueue::copyIn(quint32 position, const void* data, quint32 size)
+{
+    // 跨過緩衝區結尾時分兩段複製
+    const quint32 index = position & m_mask;
+    const quint32 first = qMin(size, m_mask + 1 - index);
+    std::memcpy(m_buffer + index, data, first);
+    std::memcpy(m_buffer, static_cast<const char*>(data) + first, size - first);
+}
+
+void LineQueue::copyOut(quint32 position, void* data, quint32 size) const
+{
+    const quint32 index = position & m_mask;
+    const quint32 first = qMin(size, m_mask + 1 - index);
+    std::memcpy(data, m_buffer + index, first);
+    std::memcpy(static_cast<char*>(data) + first, m_buffer, size - first);
+}
+
+bool LineQueue::tryPush(const char* line, int length)
+{
+    const quint32 size = quint32(qBound(0, length, MaxLineLength));
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    const quint32 tail = m_tail.load(std::memory_order_acquire);
+    if ((m_mask + 1) - (head - tail) < sizeof(quint32) + size) {
+        return false;
+    }
+    copyIn(head, &size, sizeof(quint32));
+    copyIn(head + sizeof(quint32), line, size);
+    // 內容寫完才公開新的位置
+    m_head.store(head + sizeof(quint32) + size, std::memory_order_release);
+    return true;
+}
+
+int LineQueue::pop(char* buffer)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    const quint32 head = m_head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return -1;
+    }
+    quint32 size;
+    copyOut(tail, &size, sizeof(quint32));
+    copyOut(tail + sizeof(quint32), buffer, size);
+    buffer[size] = '\0';
+    // 讀完才釋出空間給生產者
+    m_tail.store(tail + sizeof(quint32) + size, std::memory_order_release);
+    return int(size);
+}
+
+void LineQueue::clear()
+{
+    m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+}
@@ -0,0 +1,44 @@
+#ifndef LINEQUEUE_H
+#define LINEQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// 單一生產者、單一消費者的文字行佇列，不加鎖
+// 內容放在固定大小的環狀緩衝區，每行以 4 位元組長度開頭；push 與 pop 都不配置記憶體
+// 生產者為引擎 I/O 執行緒，消費者為 GUI 執行緒
+class LineQueue {
+public:
+    static constexpr int MaxLineLength = 4095;
+
+    explicit LineQueue(int capacityBytes = 1 << 20);  // 取 2 的次方
+    ~LineQueue();
+
+    LineQueue(const LineQueue&) = delete;
+    LineQueue& operator=(const LineQueue&) = delete;
+
+    // 生產者：空間不足時回傳 false，行的內容不會部分寫入；超過 MaxLineLength 的部分截掉
+    bool tryPush(const char* line, int length);
+    // 生產者：push 成功後呼叫，回傳 true 表示消費者需要被喚醒（上次喚醒之後它已經開始取出）
+    bool needsWakeup() { return !m_wakeupPending.exchange(true, std::memory_order_acq_rel); }
+
+    // 消費者：取出前先呼叫，之後 push 的行會再喚醒一次
+    void beginDrain() { m_wakeupPending.store(false, std::memory_order_release); }
+    // 消費者：取出一行到 buffer（至少 MaxLineLength + 1 位元組，結尾補 '\0'），沒有時回傳 -1
+    int pop(char* buffer);
+    // 消費者：丟棄目前所有內容
+    void clear();
+
+private:
+    char* m_buffer;
+    quint32 m_mask;
+    // 位置只增不減，取 m_mask 後為緩衝區索引；各自放在不同的快取列避免偽共享
+    alignas(64) std::atomic<quint32> m_head;  // 生產者寫入的位置
+    alignas(64) std::atomic<quint32> m_tail;  // 消費者讀取的位置
+    alignas(64) std::atomic<bool> m_wakeupPending;
+
+    void copyIn(quint32 position, const void* data, quint32 size);
+    void copyOut(quint32 position, void* data, quint32 size) const;
+};
+
+#endif // LINEQUEUE_H
@@ -0,0 +1,276 @@
+#include "movepick.h"
+#include "evaluate.h"
+#include <utility>
+
+namespace Engine {
+
+namespace {
+
+// MVV-LVA：先吃價值高的子，同樣的目標用價值低的子去吃；升后另加升變的價值
+int captureScore(const Position& pos, Move m)
+{
+    const int captured = moveType(m) == EN_PASSANT ? PAWN
+                       : pos.pieceOn(moveTo(m)) == NO_PIECE ? -1
+                       : kindOf(pos.pieceOn(moveTo(m)));
+    const int promotion = moveType(m) == PROMOTION ? PieceValue[promotionKind(m)] : 0;
+    return (captured >= 0 ? PieceValue[captured] * 16 : 0) + promotion - kindOf(pos.movedPiece(m));
+}
+
+// 與 generate(CAPTURES) 的範圍一致：吃子與升后；低升變（包括吃子的）屬於安靜著法
+bool isTactical(const Position& pos, Move m)
+{
+    return moveType(m) == PROMOTION ? promotionKind(m) == QUEEN : pos.isCapture(m);
+}
+
+}
+
+bool seeGe(const Position& pos, Move m, int threshold)
+{
+    if (moveType(m) != NORMAL) {
+        return 0 >= threshold;
+    }
+
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+
+    // swap 為目前輪到的一方要達到門檻還差多少
+    int swap = (pos.pieceOn(to) == NO_PIECE ? 0 : PieceValue[kindOf(pos.pieceOn(to))]) - threshold;
+    if (swap < 0) {
+        return false;
+    }
+    swap = PieceValue[kindOf(pos.pieceOn(from))] - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    Bitboard occupied = pos.pieces() ^ squareBB(from) ^ squareBB(to);
+    Bitboard attackers = pos.attackersTo(to, occupied);
+    const Bitboard diagonal = pos.pieces(BISHOP) | pos.pieces(QUEEN);
+    const Bitboard straight = pos.pieces(ROOK) | pos.pieces(QUEEN);
+    Color stm = pos.sideToMove();
+    int result = 1;
+
+    while (true) {
+        stm = ~stm;
+        attackers &= occupied;
+        const Bitboard stmAttackers = attackers & pos.pieces(stm);
+        if (!stmAttackers) {
+            break;
+        }
+        result ^= 1;
+
+        // 每次以最便宜的子吃回，並補上被它擋住的遠程攻擊
+        Bitboard b;
+        if ((b = stmAttackers & pos.pieces(PAWN))) {
+            if ((swap = PieceValue[PAWN] - swap) < result) {
+                break;
+            }
+            occupied ^= squareBB(lsb(b));
+            attackers |= Bitboards::bishopAttacks(to, occupied) & diagonal;
+        } else if ((b = stmAttackers & pos.pieces(KNIGHT))) {
+            if ((swap = PieceValue[KNIGHT] - swap) < result) {
+                break;
+            }
+            occupied ^= squareBB(lsb(b));
+        } else if ((b = stmAttackers & pos.pieces(BISHOP))) {
+            if ((swap = PieceValue[BISHOP] - swap) < result) {
+                break;
+            }
+            occupied ^= squareBB(lsb(b));
+            attackers |= Bitboards::bishopAttacks(to, occupied) & diagonal;
+        } else if ((b = stmAttackers & pos.pieces(ROOK))) {
+            if ((swap = PieceValue[ROOK] - swap) < result) {
+                break;
+            }
+            occupied ^= squareBB(lsb(b));
+            attackers |= Bitboards::rookAttacks(to, occupied) & straight;
+        } else if ((b = stmAttackers & pos.pieces(QUEEN))) {
+            if ((swap = PieceValue[QUEEN] - swap) < result) {
+                break;
+            }
+            occupied ^= squareBB(lsb(b));
+            attackers |= (Bitboards::bishopAttacks(to, occupied) & diagonal)
+                       | (Bitboards::rookAttacks(to, occupied) & straight);
+        } else {
+            // 國王只有在對方已經沒有子能吃回時才能吃
+            return (attackers & ~pos.pieces(stm)) ? result ^ 1 : result;
+        }
+    }
+
+    return result;
+}
+
+MovePicker::MovePicker(const Position& pos, Move ttMove, const Move* killers, const int (*history)[SQUARE_NB])
+    : m_pos(pos)
+    , m_ttMove(ttMove)
+    , m_history(history)
+    , m_stage(pos.inCheck() ? EVASION_TT : MAIN_TT)
+    , m_current(0)
+    , m_badCount(0)
+    , m_badCurrent(0)
+{
+    m_killers[0] = killers[0];
+    m_killers[1] = killers[1];
+    if (!pos.isPseudoLegal(ttMove)) {
+        m_ttMove = MOVE_NONE;
+        ++m_stage;
+    }
+}
+
+MovePicker::MovePicker(const Position& pos, Move ttMove)
+    : m_pos(pos)
+    , m_ttMove(ttMove)
+    , m_history(nullptr)
+    , m_stage(pos.inCheck() ? EVASION_TT : QSEARCH_TT)
+    , m_current(0)
+    , m_badCount(0)
+    , m_badCurrent(0)
+{
+    m_killers[0] = m_killers[1] = MOVE_NONE;
+    // 沒被將軍時靜止搜尋只看吃子，置換表著法也必須是吃子
+    if (!pos.isPseudoLegal(ttMove) || (!pos.inCheck() && !isTactical(pos, ttMove))) {
+        m_ttMove = MOVE_NONE;
+        ++m_stage;
+    }
+}
+
+void MovePicker::scoreCaptures()
+{
+    for (int i = 0; i < m_list.size; ++i) {
+        m_scores[i] = captureScore(m_pos, m_list.moves[i]);
+    }
+}
+
+void MovePicker::scoreQuiets()
+{
+    for (int i = 0; i < m_list.size; ++i) {
+        const Move m = m_list.moves[i];
+        m_scores[i] = m_history[moveFrom(m)][moveTo(m)];
+    }
+}
+
+void MovePicker::scoreEvasions()
+{
+    for (int i = 0; i < m_list.size; ++i) {
+        const Move m = m_list.moves[i];
+        if (m_pos.isCapture(m) || moveType(m) == PROMOTION) {
+            m_scores[i] = (1 << 20) + captureScore(m_pos, m);
+        } else if (m == m_killers[0]) {
+            m_scores[i] = (1 << 19) + 1;
+        } else if (m == m_killers[1]) {
+            m_scores[i] = 1 << 19;
+        } else {
+            m_scores[i] = m_history ? m_history[moveFrom(m)][moveTo(m)] : 0;
+        }
+    }
+}
+
+Move MovePicker::pickBest()
+{
+    int top = m_current;
+    for (int j = m_current + 1; j < m_list.size; ++j) {
+        if (m_scores[j] > m_scores[top]) {
+            top = j;
+        }
+    }
+    std::swap(m_list.moves[m_current], m_list.moves[top]);
+    std::swap(m_scores[m_current], m_scores[top]);
+    return m_list.moves[m_current++];
+}
+
+Move MovePicker::next()
+{
+    switch (m_stage) {
+    case MAIN_TT:
+    case EVASION_TT:
+    case QSEARCH_TT:
+        ++m_stage;
+        return m_ttMove;
+
+    case CAPTURE_INIT:
+    case QCAPTURE_INIT:
+        m_list.size = 0;
+        m_current = 0;
+        m_pos.generate(CAPTURES, m_list);
+        scoreCaptures();
+        ++m_stage;
+        return next();
+
+    case GOOD_CAPTURE:
+        while (m_current < m_list.size) {
+            const Move m = pickBest();
+            if (m == m_ttMove) {
+                continue;
+            }
+            // 交換後會虧的吃子留到安靜著法之後
+            if (!seeGe(m_pos, m, 0)) {
+                m_badCaptures[m_badCount++] = m;
+                continue;
+            }
+            return m;
+        }
+        ++m_stage;
+        return next();
+
+    case KILLER_1:
+    case KILLER_2: {
+        // 不適用的殺手著法清掉，安靜著法階段才不會把它當成已經走過
+        Move& m = m_killers[m_stage - KILLER_1];
+        ++m_stage;
+        if (m != MOVE_NONE && m != m_ttMove && !isTactical(m_pos, m) && m_pos.isPseudoLegal(m)) {
+            return m;
+        }
+        m = MOVE_NONE;
+        return next();
+    }
+
+    case QUIET_INIT:
+        m_list.size = 0;
+        m_current = 0;
+        m_pos.generate(QUIETS, m_list);
+        scoreQuiets();
+        ++m_stage;
+        return next();
+
+    case QUIET:
+        while (m_current < m_list.size) {
+            const Move m = pickBest();
+            if (m != m_ttMove && !isKiller(m)) {
+                return m;
+            }
+        }
+        ++m_stage;
+        return next();
+
+    case BAD_CAPTURE:
+        if (m_badCurrent < m_badCount) {
+            return m_badCaptures[m_badCurrent++];
+        }
+        m_stage = DONE;
+        return MOVE_NONE;
+
+    case EVASION_INIT:
+        m_list.size = 0;
+        m_current = 0;
+        m_pos.generate(ALL_MOVES, m_list);
+        scoreEvasions();
+        ++m_stage;
+        return next();
+
+    case EVASION:
+    case QCAPTURE:
+        while (m_current < m_list.size) {
+            const Move m = pickBest();
+            if (m != m_ttMove) {
+                return m;
+            }
+        }
+        m_stage = DONE;
+        return MOVE_NONE;
+
+    default:
+        return MOVE_NONE;
+    }
+}
+
+}
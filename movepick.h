@@ -0,0 +1,56 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "position.h"
+
+namespace Engine {
+
+// 靜態交換評估：在 to 格輪流以最便宜的子吃回，m 的交換結果是否至少為 threshold（百分兵）
+// 升變、吃過路兵與易位視為 0
+bool seeGe(const Position& pos, Move m, int threshold);
+
+// 分階段產生著法：前一階段沒有造成截斷才做下一階段的工作
+//   主搜尋：置換表著法 → 好的吃子（SEE >= 0，MVV-LVA）→ 殺手著法 → 安靜著法（歷史分數）→ 壞的吃子
+//   被將軍：置換表著法 → 所有應將著法（吃子優先，其次殺手與歷史分數）
+//   靜止搜尋：置換表著法（限吃子）→ 吃子（MVV-LVA）
+// 回傳的是虛擬合法著法，合法性仍由呼叫端以 Position::isLegal 檢查；沒有著法時回傳 MOVE_NONE
+class MovePicker {
+public:
+    // 主搜尋；killers 在建構時複製，history（輪走方的 [from][to] 表）到產生安靜著法時才讀取
+    MovePicker(const Position& pos, Move ttMove, const Move* killers, const int (*history)[SQUARE_NB]);
+    // 靜止搜尋
+    MovePicker(const Position& pos, Move ttMove);
+
+    Move next();
+
+private:
+    enum Stage {
+        MAIN_TT, CAPTURE_INIT, GOOD_CAPTURE, KILLER_1, KILLER_2, QUIET_INIT, QUIET, BAD_CAPTURE,
+        EVASION_TT, EVASION_INIT, EVASION,
+        QSEARCH_TT, QCAPTURE_INIT, QCAPTURE,
+        DONE
+    };
+
+    const Position& m_pos;
+    Move m_ttMove;
+    Move m_killers[2];
+    const int (*m_history)[SQUARE_NB];
+    int m_stage;
+
+    MoveList m_list;
+    int m_scores[256];
+    int m_current;
+    Move m_badCaptures[256];
+    int m_badCount;
+    int m_badCurrent;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    void scoreEvasions();
+    Move pickBest();  // 選擇排序：取出剩下分數最高的著法
+    bool isKiller(Move m) const { return m == m_killers[0] || m == m_killers[1]; }
+};
+
+}
+
+#endif // MOVEPICK_H
@@ -3,6 +3,7 @@
 #include "settingsdialog.h"
 #include "startdialog.h"
 #include "promotiondialog.h"
+#include "syzygy.h"
 #include <QApplication>
 #include <QCoreApplication>
 #include <QPainter>
@@ -309,6 +310,11 @@ myChess::myChess(QWidget *parent)
     , m_undoEnabled(true)
     , m_lightSquareColor("#F0D9B5")
     , m_darkSquareColor("#B58863")
+    , m_engineThreads(1)
+    , m_ponderEnabled(false)
+    , m_ponderCpuLimit(50)
+    , m_searchLimitMode(static_cast<int>(SearchLimitMode::Clock))
+    , m_searchLimitValue(1000)
     , m_viewingPosition(-1)
     , m_isViewingHistory(false)
     , m_timeControlEnabled(false)
@@ -320,6 +326,7 @@ myChess::myChess(QWidget *parent)
     , m_firstMoveMade(false)
     , m_isDragInProgress(false)
     , m_dragSourceSquare(-1, -1)
+    , m_uciEngine(nullptr)
     , m_chessAI(nullptr)
     , m_isComputerGame(false)
     , m_computerColor(PieceColor::BLACK)
@@ -359,6 +366,13 @@ myChess::myChess(QWidget *parent)
     m_castlingSound->setSource(QUrl("qrc:/sounds/sounds/castling.wav"));
     m_castlingSound->setVolume(1.0);
 
+    // 外部引擎在背景啟動一次，整個程式執行期間跨對局沿用；找不到執行檔時只用內建引擎
+    m_uciEngine = new UCIEngine(this);
+    const QString enginePath = QCoreApplication::applicationDirPath() + "/engine/stockfish-windows-x86-64-avx2.exe";
+    if (!m_uciEngine->initialize(enginePath)) {
+        qDebug() << "Failed to initialize engine, using built-in AI";
+    }
+
     loadSettings();
     setupUI();
     applySettings();
@@ -616,6 +630,11 @@ void myChess::onUndo() {
         return;
     }
     
+    // 悔棋後預先思考的局面不會出現
+    if (m_chessAI) {
+        m_chessAI->stopPondering();
+    }
+
     // 嘗試撤銷上一步移動
     if (m_chessBoard->undo()) {
         // 清除任何選擇
@@ -642,6 +661,9 @@ void myChess::onUndo() {
 
 void myChess::showGameOverDialog() {
     stopTimer();
+    if (m_chessAI) {
+        m_chessAI->stopPondering();
+    }
     
     // 延遲顯示對話框，讓將死音效有時間播放完畢
     QTimer::singleShot(500, this, [this]() {
@@ -1074,6 +1096,7 @@ void myChess::onSquareClicked() {
 
 void myChess::onSettings() {
     SettingsDialog dialog(this);
+    dialog.setEngineOptions(m_uciEngine->options());
     if (dialog.exec() == QDialog::Accepted) {
         loadSettings();
         applySettings();
@@ -1086,6 +1109,32 @@ void myChess::loadSettings() {
     m_undoEnabled = settings.value("undoEnabled", true).toBool();
     m_lightSquareColor = settings.value("lightSquareColor", QColor("#F0D9B5")).value<QColor>();
     m_darkSquareColor = settings.value("darkSquareColor", QColor("#B58863")).value<QColor>();
+
+    // 路徑改變時才重新掃描殘局庫；重新掃描會釋放舊的表格，內建引擎的搜尋（包括預先思考）要先停下
+    QString syzygyPath = settings.value("syzygyPath", QString()).toString();
+    if (syzygyPath != m_syzygyPath) {
+        if (m_chessAI) {
+            m_chessAI->stopSearch();
+        }
+        m_syzygyPath = syzygyPath;
+        int tableCount = Syzygy::init(m_syzygyPath);
+        qDebug() << "Syzygy tablebases found:" << tableCount
+                 << "max pieces:" << Syzygy::maxCardinality();
+    }
+
+    m_engineThreads = settings.value("engineThreads", 1).toInt();
+    m_ponderEnabled = settings.value("ponderEnabled", false).toBool();
+    m_ponderCpuLimit = settings.value("ponderCpuLimit", 50).toInt();
+    m_evalFile = settings.value("evalFile", QString()).toString();
+    m_searchLimitMode = settings.value("searchLimitMode", static_cast<int>(SearchLimitMode::Clock)).toInt();
+    m_searchLimitValue = settings.value("searchLimitValue", 1000).toInt();
+
+    m_engineOptions.clear();
+    settings.beginGroup("engineOptions");
+    for (const QString& name : settings.childKeys()) {
+        m_engineOptions.insert(name, settings.value(name).toString());
+    }
+    settings.endGroup();
 }
 
 void myChess::applySettings() {
@@ -1109,6 +1158,36 @@ void myChess::applySettings() {
     // 套用時間控制設定
     resetTimers();
     updateTimeDisplay();
+
+    applyEngineSettings();
+}
+
+void myChess::applyEngineSettings() {
+    // 外部引擎：Threads 與 Hash 沒有設定過時依主機決定，其餘選項只送出設定過的；
+    // 引擎不支援的選項在握手後略過，值沒變的不重送，改回預設值而不再儲存的選項送出引擎的預設值
+    m_uciEngine->setOption("Threads", m_engineOptions.value("Threads", QString::number(UCIEngine::defaultThreads())));
+    m_uciEngine->setOption("Hash", m_engineOptions.value("Hash", QString::number(UCIEngine::defaultHashMb())));
+    for (auto it = m_appliedEngineOptions.constBegin(); it != m_appliedEngineOptions.constEnd(); ++it) {
+        if (!m_engineOptions.contains(it.key()) && it.key() != "Threads" && it.key() != "Hash") {
+            m_uciEngine->resetOption(it.key());
+        }
+    }
+    for (auto it = m_engineOptions.constBegin(); it != m_engineOptions.constEnd(); ++it) {
+        m_uciEngine->setOption(it.key(), it.value());
+    }
+    m_appliedEngineOptions = m_engineOptions;
+
+    if (!m_chessAI) {
+        return;
+    }
+    // 改變執行緒數與網路要等搜尋結束，電腦正在思考時先不改，開新局時會再套用
+    if (!m_isComputerThinking) {
+        m_chessAI->setThreads(m_engineThreads);
+        m_chessAI->setEvalFile(m_evalFile);
+    }
+    m_chessAI->setPonderCpuLimit(m_ponderCpuLimit);
+    m_chessAI->setPonderEnabled(m_ponderEnabled);
+    m_chessAI->setSearchLimit(static_cast<SearchLimitMode>(m_searchLimitMode), m_searchLimitValue);
 }
 
 void myChess::showStartDialog() {
@@ -1141,41 +1220,32 @@ void myChess::showStartDialog() {
         GameMode gameMode = dialog.getGameMode();
         m_isComputerGame = (gameMode == GameMode::HUMAN_VS_COMPUTER);
         
+        // 上一局還在思考的著法會被 ChessAI::newGame 丟棄
+        m_isComputerThinking = false;
+
         if (m_isComputerGame) {
             // 電腦對戰模式
             int skillLevel = dialog.getDifficultyLevel();
             
-            // 建立或更新 AI
-            if (m_chessAI) {
-                delete m_chessAI;
-            }
-            m_chessAI = new ChessAI(AIDifficulty::MEDIUM, this);
-            
-            // 初始化引擎
-            QString enginePath = QCoreApplication::applicationDirPath() + "/engine/stockfish-windows-x86-64-avx2.exe";
-            bool engineInitialized = m_chessAI->initializeEngine(enginePath);
-            
-            if (!engineInitialized) {
-                qDebug() << "Failed to initialize engine, using built-in AI";
-                m_chessAI->setUseEngine(false);
+            // AI 只建立一次，之後每局沿用同一個外部引擎程序與內建引擎
+            if (!m_chessAI) {
+                m_chessAI = new ChessAI(AIDifficulty::MEDIUM, this);
+                m_chessAI->setEngine(m_uciEngine);
+                connect(m_chessAI, &ChessAI::moveReady, this, &myChess::onAIMoveReady);
+                connect(m_chessAI, &ChessAI::engineError, this, &myChess::onAIEngineError);
             }
-            
+            m_chessAI->newGame();
+
             // 設定技能等級
             m_chessAI->setSkillLevel(skillLevel);
-            
-            // 連接 AI 訊號
-            connect(m_chessAI, &ChessAI::moveReady, this, &myChess::onAIMoveReady);
-            connect(m_chessAI, &ChessAI::engineError, this, &myChess::onAIEngineError);
+            applyEngineSettings();
             
             // 設定電腦顏色
             bool playerIsWhite = dialog.isPlayerWhite();
             m_computerColor = playerIsWhite ? PieceColor::BLACK : PieceColor::WHITE;
-        } else {
-            // 玩家對戰模式 - 清除 AI
-            if (m_chessAI) {
-                delete m_chessAI;
-                m_chessAI = nullptr;
-            }
+        } else if (m_chessAI) {
+            // 玩家對戰模式 - 保留 AI 與引擎程序，只停下上一局的搜尋
+            m_chessAI->newGame();
         }
         
         // 重設棋盤以開始新遊戲
@@ -1506,11 +1576,19 @@ void myChess::makeComputerMove() {
     m_statusLabel->setText(tr("Computer is thinking..."));
     QApplication::processEvents();
     
+    // 計時對局把雙方的剩餘時間與加秒交給引擎，由引擎自行分配思考時間
+    Engine::SearchLimits clock;
+    if (m_timeControlEnabled) {
+        clock.time[Engine::WHITE] = m_whiteTimeRemaining;
+        clock.time[Engine::BLACK] = m_blackTimeRemaining;
+        clock.inc[Engine::WHITE] = clock.inc[Engine::BLACK] = m_incrementSeconds * 1000;
+    }
+
     // 請求 AI 移動（非同步）
-    m_chessAI->getBestMove(m_chessBoard, m_computerColor);
+    m_chessAI->getBestMove(m_chessBoard, m_computerColor, clock);
 }
 
-void myChess::onAIMoveReady(QPoint from, QPoint to) {
+void myChess::onAIMoveReady(QPoint from, QPoint to, PieceType promotion) {
     // 檢查是否會吃子（用於音效）
     ChessPiece* targetPiece = m_chessBoard->getPieceAt(to);
     bool isCapture = (targetPiece != nullptr);
@@ -1518,8 +1596,8 @@ void myChess::onAIMoveReady(QPoint from, QPoint to) {
     // 檢查是否會導致升變
     if (m_chessBoard->wouldBePromotion(from, to) &&
         m_chessBoard->canMove(from, to)) {
-        // 電腦總是升變為后
-        m_chessBoard->setPromotionPieceType(PieceType::QUEEN);
+        // 升變為 AI 指定的棋子（殘局庫可能選擇升變為車或馬）
+        m_chessBoard->setPromotionPieceType(promotion);
     }
     
     // 執行移動
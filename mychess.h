@@ -20,6 +20,7 @@
 #include <QTimer>
 #include <QSettings>
 #include <QTranslator>
+#include <QMap>
 #include "chessboard.h"
 #include "chessai.h"
 
@@ -154,7 +155,7 @@ private slots:
     void onBackToCurrent();
     void onTimerTick();
     void makeComputerMove();  // 新增：電腦移動
-    void onAIMoveReady(QPoint from, QPoint to);  // 新增：AI 移動準備好
+    void onAIMoveReady(QPoint from, QPoint to, PieceType promotion);  // 新增：AI 移動準備好
     void onAIEngineError(QString error);  // 新增：AI 引擎錯誤
 
 private:
@@ -195,6 +196,15 @@ private:
     bool m_undoEnabled;
     QColor m_lightSquareColor;
     QColor m_darkSquareColor;
+    QString m_syzygyPath;  // 殘局庫目錄，空字串表示不使用
+    int m_engineThreads;    // 內建引擎的搜尋執行緒數
+    bool m_ponderEnabled;   // 玩家思考時內建引擎是否預先思考
+    int m_ponderCpuLimit;   // 預先思考的 CPU 上限（%）
+    QString m_evalFile;     // 內建引擎的 NNUE 網路檔，空字串表示傳統評估
+    int m_searchLimitMode;  // SearchLimitMode
+    int m_searchLimitValue; // 毫秒、深度或節點數
+    QMap<QString, QString> m_engineOptions;  // 外部引擎選項（名稱 → 值），只有和預設值不同的
+    QMap<QString, QString> m_appliedEngineOptions;  // 上次送給引擎的，移除的選項要改回預設值
     bool m_timeControlEnabled;
     int m_timeControlMinutes;
     int m_incrementSeconds;  // 每步移動增加的秒數
@@ -216,6 +226,7 @@ private:
     QPoint m_dragSourceSquare;
     
     // AI 相關
+    UCIEngine* m_uciEngine;  // 外部引擎程序，啟動一次後每局沿用
     ChessAI* m_chessAI;
     bool m_isComputerGame;
     PieceColor m_computerColor;
@@ -229,6 +240,7 @@ private:
     void playMoveSound(bool isCapture, bool isCheck, bool isCheckmate, bool isCastling = false);
     void loadSettings();
     void applySettings();
+    void applyEngineSettings();
     void updateNavigationButtons();
     void displayBoardAtPosition(int position);
     void clearTempViewBoard();
@@ -0,0 +1,363 @@
+#include "nnue.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+#include <memory>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NNUE_USE_SSE2
+#endif
+
+namespace Engine {
+namespace NNUE {
+
+namespace {
+
+const char Magic[4] = { 'C', 'N', 'U', 'E' };
+const quint32 Version = 1;
+const int HeaderSize = 16;
+
+struct Network {
+    int hidden = 0;
+    std::vector<qint16> featureWeights;  // [輸入][隱藏單元]，同一個輸入的權重連續存放
+    std::vector<qint16> featureBias;     // [隱藏單元]
+    std::vector<qint16> outputWeights;   // [輪走方的 H 個 | 另一方的 H 個]
+    int outputBias = 0;
+    QString path;
+};
+
+std::unique_ptr<Network> g_network;
+
+// 輸入編號：以 perspective 的角度看，棋子屬於己方或對方、種類、（黑方上下翻轉後的）格子
+inline int featureIndex(Color perspective, int piece, int sq)
+{
+    const int side = colorOf(piece) == perspective ? 0 : 1;
+    const int relative = perspective == WHITE ? sq : sq ^ 56;
+    return (side * PIECE_KIND_NB + kindOf(piece)) * SQUARE_NB + relative;
+}
+
+inline const qint16* featureColumn(const Network& net, Color perspective, int piece, int sq)
+{
+    return net.featureWeights.data() + size_t(featureIndex(perspective, piece, sq)) * net.hidden;
+}
+
+// 向量運算；每一種實作一次處理 VecSize 個 16 位元整數
+#if defined(NNUE_USE_AVX2)
+
+typedef __m256i Vec;
+const int VecSize = 16;
+
+inline Vec vecLoad(const qint16* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline void vecStore(qint16* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+inline Vec vecAdd16(Vec a, Vec b) { return _mm256_add_epi16(a, b); }
+inline Vec vecSub16(Vec a, Vec b) { return _mm256_sub_epi16(a, b); }
+inline Vec vecZero() { return _mm256_setzero_si256(); }
+inline Vec vecClamp(Vec v, Vec lo, Vec hi) { return _mm256_min_epi16(_mm256_max_epi16(v, lo), hi); }
+inline Vec vecSet16(int x) { return _mm256_set1_epi16(qint16(x)); }
+// 相鄰兩個 16 位元乘積相加為 32 位元，再累加到 sum
+inline Vec vecMulAdd(Vec sum, Vec a, Vec b) { return _mm256_add_epi32(sum, _mm256_madd_epi16(a, b)); }
+inline int vecSum32(Vec v)
+{
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+
+#elif defined(NNUE_USE_SSE2)
+
+typedef __m128i Vec;
+const int VecSize = 8;
+
+inline Vec vecLoad(const qint16* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline void vecStore(qint16* p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+inline Vec vecAdd16(Vec a, Vec b) { return _mm_add_epi16(a, b); }
+inline Vec vecSub16(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+inline Vec vecZero() { return _mm_setzero_si128(); }
+inline Vec vecClamp(Vec v, Vec lo, Vec hi) { return _mm_min_epi16(_mm_max_epi16(v, lo), hi); }
+inline Vec vecSet16(int x) { return _mm_set1_epi16(qint16(x)); }
+inline Vec vecMulAdd(Vec sum, Vec a, Vec b) { return _mm_add_epi32(sum, _mm_madd_epi16(a, b)); }
+inline int vecSum32(Vec v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+    return _mm_cvtsi128_si32(v);
+}
+
+#endif
+
+// dst = src + Σadd - Σsub；dst 可以等於 src
+void applyChanges(qint16* dst, const qint16* src, int hidden,
+                  const qint16* const* add, int addCount, const qint16* const* sub, int subCount)
+{
+#if defined(NNUE_USE_AVX2) || defined(NNUE_USE_SSE2)
+    for (int i = 0; i < hidden; i += VecSize) {
+        Vec v = vecLoad(src + i);
+        for (int a = 0; a < addCount; ++a) {
+            v = vecAdd16(v, vecLoad(add[a] + i));
+        }
+        for (int s = 0; s < subCount; ++s) {
+            v = vecSub16(v, vecLoad(sub[s] + i));
+        }
+        vecStore(dst + i, v);
+    }
+#else
+    for (int i = 0; i < hidden; ++i) {
+        int v = src[i];
+        for (int a = 0; a < addCount; ++a) {
+            v += add[a][i];
+        }
+        for (int s = 0; s < subCount; ++s) {
+            v -= sub[s][i];
+        }
+        dst[i] = qint16(v);
+    }
+#endif
+}
+
+// Σ clamp(acc, 0, QA) * weight
+int clippedDot(const qint16* acc, const qint16* weights, int hidden)
+{
+#if defined(NNUE_USE_AVX2) || defined(NNUE_USE_SSE2)
+    const Vec zero = vecZero();
+    const Vec qa = vecSet16(QA);
+    Vec sum = vecZero();
+    for (int i = 0; i < hidden; i += VecSize) {
+        sum = vecMulAdd(sum, vecClamp(vecLoad(acc + i), zero, qa), vecLoad(weights + i));
+    }
+    return vecSum32(sum);
+#else
+    int sum = 0;
+    for (int i = 0; i < hidden; ++i) {
+        sum += qBound(0, int(acc[i]), QA) * weights[i];
+    }
+    return sum;
+#endif
+}
+
+void refresh(const Network& net, const Position& pos, Color perspective, qint16* acc)
+{
+    std::memcpy(acc, net.featureBias.data(), sizeof(qint16) * net.hidden);
+    Bitboard b = pos.pieces();
+    while (b) {
+        const int sq = popLsb(b);
+        const qint16* column = featureColumn(net, perspective, pos.pieceOn(sq), sq);
+        applyChanges(acc, acc, net.hidden, &column, 1, nullptr, 0);
+    }
+}
+
+int output(const Network& net, const qint16* us, const qint16* them)
+{
+    const qint64 sum = qint64(clippedDot(us, net.outputWeights.data(), net.hidden))
+                     + clippedDot(them, net.outputWeights.data() + net.hidden, net.hidden)
+                     + net.outputBias;
+    return int(sum * OutputScale / (QA * QB));
+}
+
+}
+
+bool load(const QString& path, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("cannot open %1").arg(path));
+    }
+    const QByteArray data = file.readAll();
+    const char* p = data.constData();
+
+    if (data.size() < HeaderSize || std::memcmp(p, Magic, sizeof(Magic)) != 0) {
+        return fail("not a network file");
+    }
+    const quint32 version = qFromLittleEndian<quint32>(p + 4);
+    const quint32 inputs = qFromLittleEndian<quint32>(p + 8);
+    const quint32 hidden = qFromLittleEndian<quint32>(p + 12);
+    if (version != Version) {
+        return fail(QString("unsupported version %1").arg(version));
+    }
+    if (inputs != quint32(InputSize) || hidden == 0 || hidden > quint32(MaxHiddenSize) || hidden % 16 != 0) {
+        return fail(QString("unsupported architecture %1x%2").arg(inputs).arg(hidden));
+    }
+
+    const qint64 count = qint64(InputSize) * hidden + hidden + 2 * hidden + 1;
+    if (data.size() != HeaderSize + count * qint64(sizeof(qint16))) {
+        return fail("unexpected file size");
+    }
+
+    std::unique_ptr<Network> net(new Network);
+    net->hidden = int(hidden);
+    net->featureWeights.resize(size_t(InputSize) * hidden);
+    net->featureBias.resize(hidden);
+    net->outputWeights.resize(2 * size_t(hidden));
+
+    p += HeaderSize;
+    for (std::vector<qint16>* block : { &net->featureWeights, &net->featureBias, &net->outputWeights }) {
+        for (qint16& value : *block) {
+            value = qFromLittleEndian<qint16>(p);
+            p += sizeof(qint16);
+        }
+    }
+    net->outputBias = qFromLittleEndian<qint16>(p);
+    net->path = path;
+
+    g_network = std::move(net);
+    return true;
+}
+
+void unload()
+{
+    g_network.reset();
+}
+
+bool isLoaded()
+{
+    return g_network != nullptr;
+}
+
+QString loadedPath()
+{
+    return g_network ? g_network->path : QString();
+}
+
+int hiddenSize()
+{
+    return g_network ? g_network->hidden : 0;
+}
+
+const char* simdName()
+{
+#if defined(NNUE_USE_AVX2)
+    return "AVX2";
+#elif defined(NNUE_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+int evaluate(const Position& pos)
+{
+    const Network& net = *g_network;
+    std::vector<qint16> acc(2 * size_t(net.hidden));
+    const Color us = pos.sideToMove();
+    refresh(net, pos, us, acc.data());
+    refresh(net, pos, ~us, acc.data() + net.hidden);
+    return output(net, acc.data(), acc.data() + net.hidden);
+}
+
+AccumulatorStack::AccumulatorStack()
+    : m_hidden(0)
+    , m_top(0)
+{
+}
+
+void AccumulatorStack::reset(const Position& pos)
+{
+    const Network& net = *g_network;
+    if (m_hidden != net.hidden || m_entries.empty()) {
+        m_hidden = net.hidden;
+        m_entries.resize(256);
+        m_values.assign(m_entries.size() * COLOR_NB * m_hidden, 0);
+    }
+    m_top = 0;
+    refresh(net, pos, WHITE, accumulator(0, WHITE));
+    refresh(net, pos, BLACK, accumulator(0, BLACK));
+    m_entries[0].computed = true;
+}
+
+void AccumulatorStack::push(const Position& pos)
+{
+    if (++m_top == int(m_entries.size())) {
+        m_entries.resize(m_entries.size() * 2);
+        m_values.resize(m_entries.size() * COLOR_NB * m_hidden);
+    }
+
+    // 由走完之後的局面還原這一步移動了哪些棋子
+    Entry& entry = m_entries[m_top];
+    entry.removedCount = 0;
+    entry.addedCount = 0;
+    entry.computed = false;
+
+    const Move m = pos.lastMove();
+    if (m == MOVE_NULL) {
+        return;
+    }
+    const Color us = ~pos.sideToMove();
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+    const int piece = pos.pieceOn(to);
+
+    if (moveType(m) == CASTLING) {
+        const bool kingSide = to > from;
+        const int rookFrom = kingSide ? to + 1 : to - 2;
+        const int rookTo = kingSide ? to - 1 : to + 1;
+        const int rook = makePiece(us, ROOK);
+        entry.removed[entry.removedCount++] = { piece, from };
+        entry.removed[entry.removedCount++] = { rook, rookFrom };
+        entry.added[entry.addedCount++] = { piece, to };
+        entry.added[entry.addedCount++] = { rook, rookTo };
+        return;
+    }
+
+    const int moved = moveType(m) == PROMOTION ? makePiece(us, PAWN) : piece;
+    entry.removed[entry.removedCount++] = { moved, from };
+    entry.added[entry.addedCount++] = { piece, to };
+
+    const int captured = pos.capturedPiece();
+    if (captured != NO_PIECE) {
+        const int capsq = moveType(m) == EN_PASSANT ? (us == WHITE ? to - 8 : to + 8) : to;
+        entry.removed[entry.removedCount++] = { captured, capsq };
+    }
+}
+
+void AccumulatorStack::pop()
+{
+    --m_top;
+}
+
+void AccumulatorStack::update(int index)
+{
+    const Network& net = *g_network;
+    const Entry& entry = m_entries[index];
+    for (Color perspective : { WHITE, BLACK }) {
+        const qint16* add[2];
+        const qint16* sub[2];
+        for (int i = 0; i < entry.addedCount; ++i) {
+            add[i] = featureColumn(net, perspective, entry.added[i].piece, entry.added[i].square);
+        }
+        for (int i = 0; i < entry.removedCount; ++i) {
+            sub[i] = featureColumn(net, perspective, entry.removed[i].piece, entry.removed[i].square);
+        }
+        applyChanges(accumulator(index, perspective), accumulator(index - 1, perspective), m_hidden,
+                     add, entry.addedCount, sub, entry.removedCount);
+    }
+    m_entries[index].computed = true;
+}
+
+int AccumulatorStack::evaluate(const Position& pos)
+{
+    // 找到最近一個算好的累加器，依序補上之後每一步的變化
+    int first = m_top;
+    while (!m_entries[first].computed) {
+        --first;
+    }
+    for (int i = first + 1; i <= m_top; ++i) {
+        update(i);
+    }
+
+    const Color us = pos.sideToMove();
+    return output(*g_network, accumulator(m_top, us), accumulator(m_top, ~us));
+}
+
+}
+}
@@ -0,0 +1,76 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "position.h"
+#include <QString>
+#include <vector>
+
+// 可高效率增量更新的神經網路評估（NNUE），只用 CPU
+// 架構：768 個輸入（己方/對方 × 6 種棋子 × 64 格）→ 每個視角 H 個隱藏單元（CReLU）→ 1 個輸出
+// 兩個視角共用同一組輸入權重；黑方視角把棋盤上下翻轉，所以網路只需學「己方」與「對方」
+// 推論依編譯目標選用 AVX2 或 SSE2 指令，其他平台使用一般的 C++ 迴圈，結果完全相同
+namespace Engine {
+namespace NNUE {
+
+const int InputSize = 768;
+const int MaxHiddenSize = 2048;  // 須為 16 的倍數
+const int QA = 255;              // 隱藏層（輸入權重與偏值）的量化倍數，也是 CReLU 的上限
+const int QB = 64;               // 輸出權重的量化倍數
+const int OutputScale = 400;     // 網路輸出乘上此值換算為百分兵
+
+// 載入網路檔（格式見 docs/features/NNUE_EVALUATION.md）
+// 失敗時保留原本的網路並在 error 填入原因；不可在搜尋進行中呼叫
+bool load(const QString& path, QString* error = nullptr);
+void unload();
+bool isLoaded();
+QString loadedPath();
+int hiddenSize();
+
+// 推論使用的指令集："AVX2"、"SSE2" 或 "scalar"
+const char* simdName();
+
+// 從頭計算，分數從輪走方角度，單位為百分兵；必須已載入網路
+int evaluate(const Position& pos);
+
+// 搜尋用的累加器堆疊，每個搜尋執行緒一份
+// 每走一步 push 一次、退回時 pop；累加器要到 evaluate 時才依走過的著法補算，
+// 被置換表或剪枝略過的節點完全不需要更新
+class AccumulatorStack {
+public:
+    AccumulatorStack();
+
+    void reset(const Position& pos);  // 根節點，從頭計算
+    void push(const Position& pos);   // pos 為 doMove / doNullMove 之後的局面
+    void pop();
+    int evaluate(const Position& pos);
+
+private:
+    // 一步棋造成的輸入變化：最多兩個棋子離開、兩個棋子進入（易位、吃子升變）
+    struct Change {
+        int piece;
+        int square;
+    };
+    struct Entry {
+        Change removed[2];
+        Change added[2];
+        int removedCount;
+        int addedCount;
+        bool computed;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<qint16> m_values;  // [層][視角][隱藏單元]
+    int m_hidden;
+    int m_top;
+
+    qint16* accumulator(int index, Color perspective)
+    {
+        return m_values.data() + (size_t(index) * COLOR_NB + perspective) * m_hidden;
+    }
+    void update(int index);
+};
+
+}
+}
+
+#endif // NNUE_H
@@ -0,0 +1,108 @@
+#include "packedposition.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace Engine {
+
+namespace {
+
+const char PieceChars[] = "PNBRQKpnbrqk";
+
+}
+
+PackedPosition PackedPosition::pack(const Position& pos, int whiteScore, int whiteResult)
+{
+    PackedPosition packed;
+    std::memset(packed.data, 0, Size);
+
+    const Bitboard occupied = pos.pieces();
+    qToLittleEndian<quint64>(occupied, packed.data);
+
+    Bitboard b = occupied;
+    for (int i = 0; b; ++i) {
+        const int piece = pos.pieceOn(popLsb(b));
+        packed.data[8 + i / 2] |= quint8(piece << (4 * (i & 1)));
+    }
+
+    qToLittleEndian<qint16>(qint16(qBound(-32767, whiteScore, 32767)), packed.data + 24);
+    packed.data[26] = quint8((pos.sideToMove() == BLACK ? 0x80 : 0) | pos.epSquare());
+    packed.data[27] = quint8(pos.castlingRights());
+    packed.data[28] = quint8(qMin(pos.rule50(), 255));
+    packed.data[29] = quint8(whiteResult);
+    qToLittleEndian<quint16>(quint16(1 + pos.gamePly() / 2), packed.data + 30);
+    return packed;
+}
+
+bool PackedPosition::unpack(Position* pos) const
+{
+    const Bitboard occupied = qFromLittleEndian<quint64>(data);
+    if (popcount(occupied) > 32) {
+        return false;
+    }
+
+    int board[SQUARE_NB];
+    std::fill(board, board + SQUARE_NB, int(NO_PIECE));
+    Bitboard b = occupied;
+    for (int i = 0; b; ++i) {
+        const int piece = (data[8 + i / 2] >> (4 * (i & 1))) & 15;
+        if (piece >= PIECE_NB) {
+            return false;
+        }
+        board[popLsb(b)] = piece;
+    }
+
+    // 組成 FEN 交給 Position 檢查局面是否合法
+    QString fen;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            const int piece = board[makeSquare(file, rank)];
+            if (piece == NO_PIECE) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                fen += QString::number(empty);
+                empty = 0;
+            }
+            fen += QChar(PieceChars[piece]);
+        }
+        if (empty > 0) {
+            fen += QString::number(empty);
+        }
+        if (rank > 0) {
+            fen += '/';
+        }
+    }
+
+    fen += (data[26] & 0x80) ? " b " : " w ";
+
+    const int cr = data[27];
+    if (!cr) {
+        fen += '-';
+    } else {
+        if (cr & WHITE_OO) fen += 'K';
+        if (cr & WHITE_OOO) fen += 'Q';
+        if (cr & BLACK_OO) fen += 'k';
+        if (cr & BLACK_OOO) fen += 'q';
+    }
+
+    const int ep = data[26] & 0x7F;
+    if (ep >= SQ_NONE) {
+        fen += " -";
+    } else {
+        fen += ' ';
+        fen += QChar('a' + fileOf(ep));
+        fen += QChar('1' + rankOf(ep));
+    }
+
+    fen += QString(" %1 %2").arg(data[28]).arg(qFromLittleEndian<quint16>(data + 30));
+    return pos->setFen(fen);
+}
+
+int PackedPosition::score() const
+{
+    return qFromLittleEndian<qint16>(data + 24);
+}
+
+}
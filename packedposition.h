@@ -0,0 +1,36 @@
+#ifndef PACKEDPOSITION_H
+#define PACKEDPOSITION_H
+
+#include "position.h"
+
+namespace Engine {
+
+// 訓練資料的局面紀錄，固定 32 位元組、小端序，由 tools/datagen 產生，tools/tuner 與 NNUE 訓練讀取
+//
+//   0  uint64    佔用位元盤（a1 = 位元 0）
+//   8  uint8[16] 依佔用位元由低到高，每個棋子 4 位元（先低後高），編碼同 Engine::Piece（白兵 0 … 黑王 11）
+//  24  int16     搜尋分數，白方角度（百分兵）
+//  26  uint8     位元 7 為輪走方（1 = 黑），位元 0-6 為吃過路兵格（64 = 無）
+//  27  uint8     易位權（同 CastlingRight）
+//  28  uint8     五十步計數
+//  29  uint8     對局結果，白方角度：0 負、1 和、2 勝
+//  30  uint16    回合數
+struct PackedPosition {
+    static const int Size = 32;
+
+    quint8 data[Size];
+
+    static PackedPosition pack(const Position& pos, int whiteScore, int whiteResult);
+
+    // 棋盤或欄位不合法時回傳 false
+    bool unpack(Position* pos) const;
+    int score() const;
+    int result() const { return data[29]; }
+    void setResult(int whiteResult) { data[29] = quint8(whiteResult); }
+};
+
+static_assert(sizeof(PackedPosition) == PackedPosition::Size, "PackedPosition must stay 32 bytes");
+
+}
+
+#endif // PACKEDPOSITION_H
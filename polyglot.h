@@ -0,0 +1,39 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include "chessboard.h"
+#include <QtGlobal>
+#include <QIODevice>
+
+// Polyglot 開局庫（.bin）的單筆資料：16 位元組、大端序，檔案依 key 遞增排序
+struct PolyglotEntry {
+    quint64 key;
+    quint16 move;
+    quint16 weight;
+    quint32 learn;
+
+    PolyglotEntry() : key(0), move(0), weight(0), learn(0) {}
+};
+
+namespace Polyglot {
+
+static const int ENTRY_SIZE = 16;
+
+// 以 Polyglot 的 Zobrist 規則計算目前局面的雜湊值
+// （吃過路兵檔案只在輪走方確實能吃時才計入）
+quint64 hashBoard(const ChessBoard& board);
+
+// 將棋盤歷史中的一步編碼為 Polyglot 移動：
+// 位元 0-5 目的格、6-11 起始格、12-14 升變棋子；王車易位記為「王吃自己的車」
+quint16 encodeMove(const Move& move);
+
+// 讀寫單筆資料（大端序）
+bool writeEntry(QIODevice* device, const PolyglotEntry& entry);
+bool readEntry(QIODevice* device, PolyglotEntry& entry);
+
+// 以 Polyglot 規格文件中的參考局面驗證雜湊表，回傳是否與其他 Polyglot 工具相容
+bool selfTest();
+
+}
+
+#endif // POLYGLOT_H
@@ -0,0 +1,903 @@
+#include "position.h"
+#include <QStringList>
+#include <cstring>
+#include <mutex>
+
+namespace Engine {
+
+namespace Zobrist {
+
+quint64 PieceSquare[PIECE_NB][SQUARE_NB];
+quint64 Castling[16];
+quint64 EnPassant[8];
+quint64 Side;
+quint64 Material[PIECE_NB][16];
+
+namespace {
+
+void initKeys()
+{
+    // 固定種子，讓同一局面在每次執行都得到相同的雜湊值（置換表、開局資料可重現）
+    quint64 state = 1070372ULL;
+    auto next = [&state]() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    };
+
+    for (int p = 0; p < PIECE_NB; ++p) {
+        for (int sq = 0; sq < SQUARE_NB; ++sq) {
+            PieceSquare[p][sq] = next();
+        }
+    }
+    for (int cr = 0; cr < 16; ++cr) {
+        Castling[cr] = next();
+    }
+    for (int f = 0; f < 8; ++f) {
+        EnPassant[f] = next();
+    }
+    Side = next();
+    for (int p = 0; p < PIECE_NB; ++p) {
+        for (int n = 0; n < 16; ++n) {
+            Material[p][n] = next();
+        }
+    }
+}
+
+}
+
+void init()
+{
+    static std::once_flag once;
+    std::call_once(once, initKeys);
+}
+
+}
+
+namespace {
+
+const char PieceChars[] = "PNBRQKpnbrqk";
+
+// 起始格或目的格碰到王/車原位時要清除的易位權
+int castlingMask(int sq)
+{
+    switch (sq) {
+    case 0:  return WHITE_OOO;
+    case 4:  return WHITE_OO | WHITE_OOO;
+    case 7:  return WHITE_OO;
+    case 56: return BLACK_OOO;
+    case 60: return BLACK_OO | BLACK_OOO;
+    case 63: return BLACK_OO;
+    default: return 0;
+    }
+}
+
+inline int pawnPush(Color c)
+{
+    return c == WHITE ? 8 : -8;
+}
+
+}
+
+const char* Position::StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+Position::Position()
+{
+    Bitboards::init();
+    Zobrist::init();
+    m_states.reserve(256);
+    parseFen(StartFen);
+}
+
+void Position::clear()
+{
+    for (int sq = 0; sq < SQUARE_NB; ++sq) {
+        m_board[sq] = NO_PIECE;
+    }
+    for (int c = 0; c < COLOR_NB; ++c) {
+        m_byColor[c] = 0;
+    }
+    for (int k = 0; k < PIECE_KIND_NB; ++k) {
+        m_byKind[k] = 0;
+    }
+    for (int p = 0; p < PIECE_NB; ++p) {
+        m_pieceCount[p] = 0;
+    }
+    m_sideToMove = WHITE;
+    m_gamePly = 0;
+    m_states.clear();
+}
+
+void Position::putPiece(int piece, int sq)
+{
+    const Bitboard b = squareBB(sq);
+    m_board[sq] = piece;
+    m_byColor[colorOf(piece)] |= b;
+    m_byKind[kindOf(piece)] |= b;
+    ++m_pieceCount[piece];
+}
+
+void Position::removePiece(int sq)
+{
+    const int piece = m_board[sq];
+    const Bitboard b = squareBB(sq);
+    m_byColor[colorOf(piece)] ^= b;
+    m_byKind[kindOf(piece)] ^= b;
+    m_board[sq] = NO_PIECE;
+    --m_pieceCount[piece];
+}
+
+void Position::movePieceTo(int from, int to)
+{
+    const int piece = m_board[from];
+    const Bitboard fromTo = squareBB(from) | squareBB(to);
+    m_byColor[colorOf(piece)] ^= fromTo;
+    m_byKind[kindOf(piece)] ^= fromTo;
+    m_board[from] = NO_PIECE;
+    m_board[to] = piece;
+}
+
+quint64 Position::materialKeyOf(const int pieceCount[PIECE_NB])
+{
+    Zobrist::init();
+    quint64 key = 0;
+    for (int p = 0; p < PIECE_NB; ++p) {
+        for (int n = 0; n < pieceCount[p]; ++n) {
+            key ^= Zobrist::Material[p][n];
+        }
+    }
+    return key;
+}
+
+bool Position::setFen(const QString& fen)
+{
+    // 解析失敗時保留原本的局面
+    const Position backup = *this;
+    if (!parseFen(fen)) {
+        *this = backup;
+        return false;
+    }
+    return true;
+}
+
+bool Position::parseFen(const QString& fen)
+{
+    const QStringList fields = fen.trimmed().split(' ', Qt::SkipEmptyParts);
+    if (fields.size() < 2) {
+        return false;
+    }
+
+    clear();
+
+    int rank = 7;
+    int file = 0;
+    for (QChar qc : fields[0]) {
+        const char c = qc.toLatin1();
+        if (c == '/') {
+            if (file != 8 || rank == 0) {
+                return false;
+            }
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char* p = c ? strchr(PieceChars, c) : nullptr;
+            if (!p || file > 7) {
+                return false;
+            }
+            putPiece(int(p - PieceChars), makeSquare(file, rank));
+            ++file;
+        }
+        if (file > 8) {
+            return false;
+        }
+    }
+    if (rank != 0 || file != 8 || popcount(pieces(WHITE, KING)) != 1 || popcount(pieces(BLACK, KING)) != 1) {
+        return false;
+    }
+
+    if (fields[1] == "w") {
+        m_sideToMove = WHITE;
+    } else if (fields[1] == "b") {
+        m_sideToMove = BLACK;
+    } else {
+        return false;
+    }
+
+    StateInfo st;
+    st.castlingRights = 0;
+    st.epSquare = SQ_NONE;
+    st.rule50 = 0;
+    st.pliesFromNull = 0;
+    st.captured = NO_PIECE;
+    st.move = MOVE_NONE;
+
+    if (fields.size() > 2 && fields[2] != "-") {
+        // 只保留與王、車位置一致的易位權
+        for (QChar qc : fields[2]) {
+            switch (qc.toLatin1()) {
+            case 'K':
+                if (pieceOn(4) == makePiece(WHITE, KING) && pieceOn(7) == makePiece(WHITE, ROOK)) st.castlingRights |= WHITE_OO;
+                break;
+            case 'Q':
+                if (pieceOn(4) == makePiece(WHITE, KING) && pieceOn(0) == makePiece(WHITE, ROOK)) st.castlingRights |= WHITE_OOO;
+                break;
+            case 'k':
+                if (pieceOn(60) == makePiece(BLACK, KING) && pieceOn(63) == makePiece(BLACK, ROOK)) st.castlingRights |= BLACK_OO;
+                break;
+            case 'q':
+                if (pieceOn(60) == makePiece(BLACK, KING) && pieceOn(56) == makePiece(BLACK, ROOK)) st.castlingRights |= BLACK_OOO;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (fields.size() > 3 && fields[3] != "-" && fields[3].size() == 2) {
+        const int epFile = fields[3][0].toLatin1() - 'a';
+        const int epRank = fields[3][1].toLatin1() - '1';
+        if (epFile >= 0 && epFile < 8 && (epRank == 2 || epRank == 5)) {
+            const int sq = makeSquare(epFile, epRank);
+            if (epCapturePossible(sq, m_sideToMove)) {
+                st.epSquare = sq;
+            }
+        }
+    }
+
+    if (fields.size() > 4) {
+        st.rule50 = qMax(0, fields[4].toInt());
+    }
+    if (fields.size() > 5) {
+        m_gamePly = qMax(0, 2 * (fields[5].toInt() - 1)) + (m_sideToMove == BLACK ? 1 : 0);
+    } else {
+        m_gamePly = m_sideToMove == BLACK ? 1 : 0;
+    }
+
+    st.key = 0;
+    for (Bitboard b = pieces(); b;) {
+        const int sq = popLsb(b);
+        st.key ^= Zobrist::PieceSquare[m_board[sq]][sq];
+    }
+    st.key ^= Zobrist::Castling[st.castlingRights];
+    if (st.epSquare != SQ_NONE) {
+        st.key ^= Zobrist::EnPassant[fileOf(st.epSquare)];
+    }
+    if (m_sideToMove == WHITE) {
+        st.key ^= Zobrist::Side;
+    }
+    st.materialKey = materialKeyOf(m_pieceCount);
+
+    m_states.push_back(st);
+    m_states.back().checkers = computeCheckers();
+    m_states.back().pinned = pinnedPieces(m_sideToMove);
+
+    // 不輪走的一方不可處於被將軍狀態
+    return !isAttacked(kingSquare(~m_sideToMove), m_sideToMove);
+}
+
+QString Position::fen() const
+{
+    QString result;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            const int piece = m_board[makeSquare(file, rank)];
+            if (piece == NO_PIECE) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                result += QString::number(empty);
+                empty = 0;
+            }
+            result += QChar(PieceChars[piece]);
+        }
+        if (empty > 0) {
+            result += QString::number(empty);
+        }
+        if (rank > 0) {
+            result += '/';
+        }
+    }
+
+    result += m_sideToMove == WHITE ? " w " : " b ";
+
+    const int cr = castlingRights();
+    if (!cr) {
+        result += '-';
+    } else {
+        if (cr & WHITE_OO) result += 'K';
+        if (cr & WHITE_OOO) result += 'Q';
+        if (cr & BLACK_OO) result += 'k';
+        if (cr & BLACK_OOO) result += 'q';
+    }
+
+    if (epSquare() == SQ_NONE) {
+        result += " -";
+    } else {
+        result += ' ';
+        result += QChar('a' + fileOf(epSquare()));
+        result += QChar('1' + rankOf(epSquare()));
+    }
+
+    result += QString(" %1 %2").arg(rule50()).arg(1 + m_gamePly / 2);
+    return result;
+}
+
+Bitboard Position::attackersTo(int sq, Bitboard occupied) const
+{
+    return (Bitboards::PawnAttacks[BLACK][sq] & pieces(WHITE, PAWN))
+         | (Bitboards::PawnAttacks[WHITE][sq] & pieces(BLACK, PAWN))
+         | (Bitboards::KnightAttacks[sq] & pieces(KNIGHT))
+         | (Bitboards::rookAttacks(sq, occupied) & (pieces(ROOK) | pieces(QUEEN)))
+         | (Bitboards::bishopAttacks(sq, occupied) & (pieces(BISHOP) | pieces(QUEEN)))
+         | (Bitboards::KingAttacks[sq] & pieces(KING));
+}
+
+bool Position::isAttacked(int sq, Color by) const
+{
+    return attackersTo(sq, pieces()) & pieces(by);
+}
+
+Bitboard Position::computeCheckers() const
+{
+    return attackersTo(kingSquare(m_sideToMove), pieces()) & pieces(~m_sideToMove);
+}
+
+Bitboard Position::pinnedPieces(Color c) const
+{
+    const int ksq = kingSquare(c);
+    const Color them = ~c;
+    Bitboard snipers = (Bitboards::rookAttacks(ksq, 0) & (pieces(them, ROOK) | pieces(them, QUEEN)))
+                     | (Bitboards::bishopAttacks(ksq, 0) & (pieces(them, BISHOP) | pieces(them, QUEEN)));
+    Bitboard pinned = 0;
+    while (snipers) {
+        const int s = popLsb(snipers);
+        const Bitboard between = Bitboards::Between[ksq][s] & pieces();
+        if (between && !moreThanOne(between)) {
+            pinned |= between & pieces(c);
+        }
+    }
+    return pinned;
+}
+
+bool Position::epCapturePossible(int epSquare, Color us) const
+{
+    // 只有在輪走方確實有兵可吃時才記錄吃過路兵格，避免相同局面得到不同雜湊
+    return Bitboards::PawnAttacks[~us][epSquare] & pieces(us, PAWN);
+}
+
+bool Position::isCapture(Move m) const
+{
+    return (m_board[moveTo(m)] != NO_PIECE && moveType(m) != CASTLING) || moveType(m) == EN_PASSANT;
+}
+
+bool Position::isZeroing(Move m) const
+{
+    return isCapture(m) || kindOf(m_board[moveFrom(m)]) == PAWN;
+}
+
+bool Position::isLegal(Move m) const
+{
+    const Color us = m_sideToMove;
+    const Color them = ~us;
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+    const int ksq = kingSquare(us);
+
+    if (moveType(m) == EN_PASSANT) {
+        const int capsq = to - pawnPush(us);
+        const Bitboard occupied = (pieces() ^ squareBB(from) ^ squareBB(capsq)) | squareBB(to);
+        return !(attackersTo(ksq, occupied) & pieces(them) & ~squareBB(capsq));
+    }
+
+    // 易位的通過格已在產生時檢查
+    if (moveType(m) == CASTLING) {
+        return true;
+    }
+
+    if (kindOf(m_board[from]) == KING) {
+        return !(attackersTo(to, pieces() ^ squareBB(from)) & pieces(them));
+    }
+
+    const Bitboard checkers = state().checkers;
+    if (checkers) {
+        if (moreThanOne(checkers)) {
+            return false;
+        }
+        const int checker = lsb(checkers);
+        if (!((Bitboards::Between[ksq][checker] | checkers) & squareBB(to))) {
+            return false;
+        }
+    }
+
+    return !(state().pinned & squareBB(from)) || (Bitboards::Line[from][ksq] & squareBB(to));
+}
+
+bool Position::isPseudoLegal(Move m) const
+{
+    const Color us = m_sideToMove;
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+    const int piece = m_board[from];
+
+    if (m == MOVE_NONE || m == MOVE_NULL || piece == NO_PIECE || colorOf(piece) != us) {
+        return false;
+    }
+    // 產生的著法只有升變會用到升變棋子的欄位
+    if (moveType(m) != PROMOTION && promotionKind(m) != KNIGHT) {
+        return false;
+    }
+
+    // 易位的條件較多，直接比對產生的結果（最多兩步）
+    if (moveType(m) == CASTLING) {
+        MoveList list;
+        generateCastling(list);
+        return list.contains(m);
+    }
+
+    if (pieces(us) & squareBB(to)) {
+        return false;
+    }
+
+    if (kindOf(piece) != PAWN) {
+        return moveType(m) == NORMAL && (Bitboards::attacks(kindOf(piece), from, pieces()) & squareBB(to));
+    }
+
+    if (moveType(m) == EN_PASSANT) {
+        return to == epSquare() && (Bitboards::PawnAttacks[us][from] & squareBB(to));
+    }
+
+    // 走到底線的兵步一定是升變，其他的一定不是
+    const bool lastRank = squareBB(to) & (RANK_1_BB | RANK_8_BB);
+    if ((moveType(m) == PROMOTION) != lastRank) {
+        return false;
+    }
+
+    const int up = pawnPush(us);
+    const Bitboard empty = ~pieces();
+    if (Bitboards::PawnAttacks[us][from] & squareBB(to)) {
+        return pieces(~us) & squareBB(to);
+    }
+    if (to == from + up) {
+        return empty & squareBB(to);
+    }
+    const Bitboard rank2 = us == WHITE ? RANK_2_BB : RANK_7_BB;
+    return to == from + 2 * up && (rank2 & squareBB(from)) && (empty & squareBB(from + up)) && (empty & squareBB(to));
+}
+
+int Position::repetitions() const
+{
+    // 吃子與兵步不可逆，所以只需往回看到五十步計數歸零的地方；
+    // 同一方走棋的局面才可能相同，每次退兩步
+    const int last = int(m_states.size()) - 1;
+    const int end = qMin(qMin(state().rule50, state().pliesFromNull), last);
+    int count = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (m_states[last - i].key == state().key) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool Position::isDraw(int ply) const
+{
+    if (state().rule50 >= 100) {
+        if (!inCheck()) {
+            return true;
+        }
+        MoveList legal;
+        generateLegal(legal);
+        if (legal.size > 0) {
+            return true;
+        }
+    }
+
+    // 在搜尋樹內重複一次就當作和棋（對方可以一直重複下去）；
+    // 與根局面之前的對局歷史重複則要共出現三次
+    const int last = int(m_states.size()) - 1;
+    const int end = qMin(qMin(state().rule50, state().pliesFromNull), last);
+    int count = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (m_states[last - i].key == state().key && (i < ply || ++count == 2)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Position::isInsufficientMaterial() const
+{
+    const int count = pieceCount();
+    return count == 2 || (count == 3 && (pieces(KNIGHT) | pieces(BISHOP)));
+}
+
+void Position::generatePawnMoves(GenType type, MoveList& list) const
+{
+    const Color us = m_sideToMove;
+    const Color them = ~us;
+    const int up = pawnPush(us);
+    const Bitboard rank7 = us == WHITE ? RANK_7_BB : RANK_2_BB;
+    const Bitboard rank3 = us == WHITE ? (RANK_2_BB << 8) : (RANK_7_BB >> 8);
+    const Bitboard empty = ~pieces();
+    const Bitboard enemies = pieces(them);
+    const Bitboard pawns = pieces(us, PAWN);
+    const Bitboard promoting = pawns & rank7;
+    const Bitboard normal = pawns & ~rank7;
+
+    auto forward = [us](Bitboard b) { return us == WHITE ? shiftNorth(b) : shiftSouth(b); };
+
+    auto addPromotions = [&list, type](int from, int to) {
+        // 升后算作戰術著法；低升變歸在安靜著法，讓兩種產生方式不重疊
+        if (type != QUIETS) {
+            list.append(makeMove(from, to, PROMOTION, QUEEN));
+        }
+        if (type != CAPTURES) {
+            list.append(makeMove(from, to, PROMOTION, ROOK));
+            list.append(makeMove(from, to, PROMOTION, BISHOP));
+            list.append(makeMove(from, to, PROMOTION, KNIGHT));
+        }
+    };
+
+    if (type != CAPTURES) {
+        Bitboard single = forward(normal) & empty;
+        Bitboard twice = forward(single & rank3) & empty;
+        while (single) {
+            const int to = popLsb(single);
+            list.append(makeMove(to - up, to));
+        }
+        while (twice) {
+            const int to = popLsb(twice);
+            list.append(makeMove(to - 2 * up, to));
+        }
+    }
+
+    if (promoting) {
+        Bitboard pushes = forward(promoting) & empty;
+        Bitboard west = forward(shiftWest(promoting)) & enemies;
+        Bitboard east = forward(shiftEast(promoting)) & enemies;
+        while (pushes) {
+            const int to = popLsb(pushes);
+            addPromotions(to - up, to);
+        }
+        while (west) {
+            const int to = popLsb(west);
+            addPromotions(to - up + 1, to);
+        }
+        while (east) {
+            const int to = popLsb(east);
+            addPromotions(to - up - 1, to);
+        }
+    }
+
+    if (type != QUIETS) {
+        Bitboard west = forward(shiftWest(normal)) & enemies;
+        Bitboard east = forward(shiftEast(normal)) & enemies;
+        while (west) {
+            const int to = popLsb(west);
+            list.append(makeMove(to - up + 1, to));
+        }
+        while (east) {
+            const int to = popLsb(east);
+            list.append(makeMove(to - up - 1, to));
+        }
+
+        const int ep = epSquare();
+        if (ep != SQ_NONE) {
+            Bitboard attackers = Bitboards::PawnAttacks[them][ep] & normal;
+            while (attackers) {
+                list.append(makeMove(popLsb(attackers), ep, EN_PASSANT));
+            }
+        }
+    }
+}
+
+void Position::generateCastling(MoveList& list) const
+{
+    const Color us = m_sideToMove;
+    const int cr = castlingRights() & (us == WHITE ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+    if (!cr || inCheck()) {
+        return;
+    }
+
+    const int base = us == WHITE ? 0 : 56;
+    const Color them = ~us;
+    const Bitboard occupied = pieces();
+
+    if ((cr & (WHITE_OO | BLACK_OO))
+        && !(occupied & (squareBB(base + 5) | squareBB(base + 6)))
+        && !isAttacked(base + 5, them) && !isAttacked(base + 6, them)) {
+        list.append(makeMove(base + 4, base + 6, CASTLING));
+    }
+    if ((cr & (WHITE_OOO | BLACK_OOO))
+        && !(occupied & (squareBB(base + 1) | squareBB(base + 2) | squareBB(base + 3)))
+        && !isAttacked(base + 3, them) && !isAttacked(base + 2, them)) {
+        list.append(makeMove(base + 4, base + 2, CASTLING));
+    }
+}
+
+void Position::generate(GenType type, MoveList& list) const
+{
+    const Color us = m_sideToMove;
+    const Bitboard targets = type == CAPTURES ? pieces(~us)
+                           : type == QUIETS ? ~pieces()
+                           : ~pieces(us);
+    const Bitboard occupied = pieces();
+
+    generatePawnMoves(type, list);
+
+    for (int k = KNIGHT; k <= KING; ++k) {
+        Bitboard b = pieces(us, PieceKind(k));
+        while (b) {
+            const int from = popLsb(b);
+            Bitboard attacks = Bitboards::attacks(PieceKind(k), from, occupied) & targets;
+            while (attacks) {
+                list.append(makeMove(from, popLsb(attacks)));
+            }
+        }
+    }
+
+    if (type != CAPTURES) {
+        generateCastling(list);
+    }
+}
+
+void Position::generateLegal(MoveList& list) const
+{
+    MoveList pseudo;
+    generate(ALL_MOVES, pseudo);
+    list.size = 0;
+    for (int i = 0; i < pseudo.size; ++i) {
+        if (isLegal(pseudo.moves[i])) {
+            list.append(pseudo.moves[i]);
+        }
+    }
+}
+
+Position::StateInfo& Position::pushState()
+{
+    m_states.push_back(m_states.back());
+    return m_states.back();
+}
+
+void Position::doMove(Move m)
+{
+    StateInfo& st = pushState();
+    const Color us = m_sideToMove;
+    const Color them = ~us;
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+    const int piece = m_board[from];
+
+    quint64 key = st.key ^ Zobrist::Side;
+    st.move = m;
+    st.captured = NO_PIECE;
+    ++st.rule50;
+    ++st.pliesFromNull;
+
+    if (st.epSquare != SQ_NONE) {
+        key ^= Zobrist::EnPassant[fileOf(st.epSquare)];
+        st.epSquare = SQ_NONE;
+    }
+
+    if (moveType(m) == CASTLING) {
+        const bool kingSide = to > from;
+        const int rookFrom = kingSide ? to + 1 : to - 2;
+        const int rookTo = kingSide ? to - 1 : to + 1;
+        const int rook = m_board[rookFrom];
+        removePiece(from);
+        removePiece(rookFrom);
+        putPiece(piece, to);
+        putPiece(rook, rookTo);
+        key ^= Zobrist::PieceSquare[piece][from] ^ Zobrist::PieceSquare[piece][to]
+             ^ Zobrist::PieceSquare[rook][rookFrom] ^ Zobrist::PieceSquare[rook][rookTo];
+    } else {
+        const int capsq = moveType(m) == EN_PASSANT ? to - pawnPush(us) : to;
+        const int captured = m_board[capsq];
+        if (captured != NO_PIECE) {
+            removePiece(capsq);
+            key ^= Zobrist::PieceSquare[captured][capsq];
+            st.materialKey ^= Zobrist::Material[captured][m_pieceCount[captured]];
+            st.captured = captured;
+            st.rule50 = 0;
+        }
+
+        movePieceTo(from, to);
+        key ^= Zobrist::PieceSquare[piece][from] ^ Zobrist::PieceSquare[piece][to];
+
+        if (kindOf(piece) == PAWN) {
+            st.rule50 = 0;
+            if ((from ^ to) == 16 && epCapturePossible(from + pawnPush(us), them)) {
+                st.epSquare = from + pawnPush(us);
+                key ^= Zobrist::EnPassant[fileOf(st.epSquare)];
+            } else if (moveType(m) == PROMOTION) {
+                const int promoted = makePiece(us, promotionKind(m));
+                removePiece(to);
+                putPiece(promoted, to);
+                key ^= Zobrist::PieceSquare[piece][to] ^ Zobrist::PieceSquare[promoted][to];
+                st.materialKey ^= Zobrist::Material[piece][m_pieceCount[piece]]
+                                ^ Zobrist::Material[promoted][m_pieceCount[promoted] - 1];
+            }
+        }
+    }
+
+    const int mask = castlingMask(from) | castlingMask(to);
+    if (st.castlingRights && mask) {
+        key ^= Zobrist::Castling[st.castlingRights];
+        st.castlingRights &= ~mask;
+        key ^= Zobrist::Castling[st.castlingRights];
+    }
+
+    st.key = key;
+    m_sideToMove = them;
+    ++m_gamePly;
+    st.checkers = computeCheckers();
+    st.pinned = pinnedPieces(them);
+}
+
+void Position::undoMove()
+{
+    const StateInfo& st = state();
+    const Move m = st.move;
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+
+    m_sideToMove = ~m_sideToMove;
+    --m_gamePly;
+    const Color us = m_sideToMove;
+
+    if (moveType(m) == CASTLING) {
+        const bool kingSide = to > from;
+        const int rookFrom = kingSide ? to + 1 : to - 2;
+        const int rookTo = kingSide ? to - 1 : to + 1;
+        const int king = m_board[to];
+        const int rook = m_board[rookTo];
+        removePiece(to);
+        removePiece(rookTo);
+        putPiece(king, from);
+        putPiece(rook, rookFrom);
+    } else {
+        if (moveType(m) == PROMOTION) {
+            removePiece(to);
+            putPiece(makePiece(us, PAWN), to);
+        }
+        movePieceTo(to, from);
+        if (st.captured != NO_PIECE) {
+            const int capsq = moveType(m) == EN_PASSANT ? to - pawnPush(us) : to;
+            putPiece(st.captured, capsq);
+        }
+    }
+
+    m_states.pop_back();
+}
+
+void Position::doNullMove()
+{
+    StateInfo& st = pushState();
+    st.key ^= Zobrist::Side;
+    if (st.epSquare != SQ_NONE) {
+        st.key ^= Zobrist::EnPassant[fileOf(st.epSquare)];
+        st.epSquare = SQ_NONE;
+    }
+    st.move = MOVE_NULL;
+    st.captured = NO_PIECE;
+    ++st.rule50;
+    st.pliesFromNull = 0;
+    m_sideToMove = ~m_sideToMove;
+    ++m_gamePly;
+    st.checkers = 0;
+    st.pinned = pinnedPieces(m_sideToMove);
+}
+
+void Position::undoNullMove()
+{
+    m_sideToMove = ~m_sideToMove;
+    --m_gamePly;
+    m_states.pop_back();
+}
+
+QString Position::moveToUci(Move m) const
+{
+    if (m == MOVE_NONE) {
+        return "(none)";
+    }
+    if (m == MOVE_NULL) {
+        return "0000";
+    }
+    QString result;
+    result += QChar('a' + fileOf(moveFrom(m)));
+    result += QChar('1' + rankOf(moveFrom(m)));
+    result += QChar('a' + fileOf(moveTo(m)));
+    result += QChar('1' + rankOf(moveTo(m)));
+    if (moveType(m) == PROMOTION) {
+        result += QChar("nbrq"[promotionKind(m) - KNIGHT]);
+    }
+    return result;
+}
+
+QString Position::moveToSan(Move m) const
+{
+    if (m == MOVE_NONE || m == MOVE_NULL) {
+        return "--";
+    }
+
+    const int from = moveFrom(m);
+    const int to = moveTo(m);
+    const PieceKind kind = kindOf(m_board[from]);
+    QString result;
+
+    if (moveType(m) == CASTLING) {
+        result = to > from ? "O-O" : "O-O-O";
+    } else {
+        if (kind == PAWN) {
+            if (isCapture(m)) {
+                result += QChar('a' + fileOf(from));
+            }
+        } else {
+            result += QChar("PNBRQK"[kind]);
+
+            // 同種棋子也能走到同一格時，先以縱列區分，不夠再加橫列
+            MoveList list;
+            generateLegal(list);
+            bool ambiguous = false;
+            bool sameFile = false;
+            bool sameRank = false;
+            for (int i = 0; i < list.size; ++i) {
+                const Move other = list.moves[i];
+                if (other == m || moveTo(other) != to || kindOf(m_board[moveFrom(other)]) != kind) {
+                    continue;
+                }
+                ambiguous = true;
+                sameFile |= fileOf(moveFrom(other)) == fileOf(from);
+                sameRank |= rankOf(moveFrom(other)) == rankOf(from);
+            }
+            if (ambiguous) {
+                if (!sameFile) {
+                    result += QChar('a' + fileOf(from));
+                } else if (!sameRank) {
+                    result += QChar('1' + rankOf(from));
+                } else {
+                    result += QChar('a' + fileOf(from));
+                    result += QChar('1' + rankOf(from));
+                }
+            }
+        }
+        if (isCapture(m)) {
+            result += 'x';
+        }
+        result += QChar('a' + fileOf(to));
+        result += QChar('1' + rankOf(to));
+        if (moveType(m) == PROMOTION) {
+            result += '=';
+            result += QChar("PNBRQK"[promotionKind(m)]);
+        }
+    }
+
+    Position next = *this;
+    next.doMove(m);
+    if (next.inCheck()) {
+        MoveList replies;
+        next.generateLegal(replies);
+        result += replies.size == 0 ? '#' : '+';
+    }
+    return result;
+}
+
+Move Position::parseUciMove(const QString& uci) const
+{
+    MoveList list;
+    generateLegal(list);
+    const QString lower = uci.trimmed().toLower();
+    for (int i = 0; i < list.size; ++i) {
+        if (moveToUci(list.moves[i]) == lower) {
+            return list.moves[i];
+        }
+    }
+    return MOVE_NONE;
+}
+
+}
@@ -0,0 +1,163 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "bitboard.h"
+#include <QString>
+#include <vector>
+
+namespace Engine {
+
+// 16 位元著法：位元 0-5 起始格、6-11 目的格、12-13 升變棋子（馬=0 … 后=3）、14-15 特殊類型
+typedef quint16 Move;
+
+enum MoveType {
+    NORMAL = 0,
+    PROMOTION = 1 << 14,
+    EN_PASSANT = 2 << 14,
+    CASTLING = 3 << 14
+};
+
+const Move MOVE_NONE = 0;
+const Move MOVE_NULL = 65;
+
+inline Move makeMove(int from, int to) { return Move(from | (to << 6)); }
+inline Move makeMove(int from, int to, MoveType type, PieceKind promotion = KNIGHT)
+{
+    return Move(from | (to << 6) | ((int(promotion) - KNIGHT) << 12) | type);
+}
+inline int moveFrom(Move m) { return m & 63; }
+inline int moveTo(Move m) { return (m >> 6) & 63; }
+inline MoveType moveType(Move m) { return MoveType(m & (3 << 14)); }
+inline PieceKind promotionKind(Move m) { return PieceKind(((m >> 12) & 3) + KNIGHT); }
+
+// 產生著法的種類：吃子與升后、其餘安靜著法、全部
+enum GenType { CAPTURES, QUIETS, ALL_MOVES };
+
+struct MoveList {
+    Move moves[256];
+    int size;
+
+    MoveList() : size(0) {}
+    void append(Move m) { moves[size++] = m; }
+    bool contains(Move m) const
+    {
+        for (int i = 0; i < size; ++i) {
+            if (moves[i] == m) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// 引擎內部使用的位元棋盤局面，支援 FEN、合法著法產生與走子/還原
+// 與 ChessBoard 不同，這裡不處理 UI 狀態，只求快速且可複製
+class Position {
+public:
+    Position();
+
+    static const char* StartFen;
+
+    bool setFen(const QString& fen);  // 格式錯誤或局面不合法時回傳 false，局面維持不變
+    QString fen() const;
+
+    Color sideToMove() const { return m_sideToMove; }
+    int pieceOn(int sq) const { return m_board[sq]; }
+    Bitboard pieces() const { return m_byColor[WHITE] | m_byColor[BLACK]; }
+    Bitboard pieces(Color c) const { return m_byColor[c]; }
+    Bitboard pieces(PieceKind k) const { return m_byKind[k]; }
+    Bitboard pieces(Color c, PieceKind k) const { return m_byColor[c] & m_byKind[k]; }
+    int count(Color c, PieceKind k) const { return m_pieceCount[makePiece(c, k)]; }
+    int pieceCount() const { return popcount(pieces()); }
+    int kingSquare(Color c) const { return lsb(pieces(c, KING)); }
+
+    int castlingRights() const { return state().castlingRights; }
+    int epSquare() const { return state().epSquare; }
+    int rule50() const { return state().rule50; }
+    int gamePly() const { return m_gamePly; }
+    quint64 key() const { return state().key; }
+    quint64 materialKey() const { return state().materialKey; }
+    int capturedPiece() const { return state().captured; }
+    Move lastMove() const { return state().move; }  // 空著為 MOVE_NULL
+
+    Bitboard checkers() const { return state().checkers; }
+    bool inCheck() const { return state().checkers != 0; }
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    bool isAttacked(int sq, Color by) const;
+
+    bool isCapture(Move m) const;
+    bool isZeroing(Move m) const;  // 吃子或兵步，會重設五十步計數
+    bool isLegal(Move m) const;    // m 必須是虛擬合法著法
+    bool isPseudoLegal(Move m) const;  // 不產生著法，直接檢查任意著法（例如置換表著法）在本局面是否虛擬合法
+
+    // 目前局面在最後一次吃子、兵步或空著之後已經出現過幾次（不含目前這一次）
+    int repetitions() const;
+    // 搜尋用的和棋判斷，ply 為與根局面的距離：五十步（除非被將死）、在搜尋樹內重複一次、或加上對局歷史共出現三次
+    bool isDraw(int ply) const;
+    bool isInsufficientMaterial() const;  // 雙王，或只多一個輕子
+    int movedPiece(Move m) const { return m_board[moveFrom(m)]; }
+
+    void generate(GenType type, MoveList& list) const;  // 虛擬合法著法
+    void generateLegal(MoveList& list) const;
+
+    void doMove(Move m);
+    void undoMove();
+    void doNullMove();
+    void undoNullMove();
+
+    QString moveToUci(Move m) const;
+    QString moveToSan(Move m) const;  // 標準代數記譜（PGN 用），m 必須是合法著法
+    Move parseUciMove(const QString& uci) const;  // 不合法時回傳 MOVE_NONE
+
+    // 以 Zobrist 方式計算的子力組合鍵：只與各種棋子的數量有關
+    static quint64 materialKeyOf(const int pieceCount[PIECE_NB]);
+
+private:
+    struct StateInfo {
+        quint64 key;
+        quint64 materialKey;
+        Bitboard checkers;
+        Bitboard pinned;  // 輪走方被釘住、不可離開釘線的棋子
+        int castlingRights;
+        int epSquare;
+        int rule50;
+        int pliesFromNull;  // 重複只檢查到上一個空著，空著前後的局面不算同一盤棋的延續
+        int captured;
+        Move move;
+    };
+
+    int m_board[SQUARE_NB];
+    Bitboard m_byColor[COLOR_NB];
+    Bitboard m_byKind[PIECE_KIND_NB];
+    int m_pieceCount[PIECE_NB];
+    Color m_sideToMove;
+    int m_gamePly;
+    std::vector<StateInfo> m_states;  // 每一步一筆，最後一筆為目前狀態
+
+    const StateInfo& state() const { return m_states.back(); }
+
+    void clear();
+    bool parseFen(const QString& fen);
+    void putPiece(int piece, int sq);
+    void removePiece(int sq);
+    void movePieceTo(int from, int to);
+    Bitboard computeCheckers() const;
+    Bitboard pinnedPieces(Color c) const;
+    bool epCapturePossible(int epSquare, Color us) const;
+    StateInfo& pushState();
+    void generatePawnMoves(GenType type, MoveList& list) const;
+    void generateCastling(MoveList& list) const;
+};
+
+namespace Zobrist {
+void init();
+extern quint64 PieceSquare[PIECE_NB][SQUARE_NB];
+extern quint64 Castling[16];
+extern quint64 EnPassant[8];
+extern quint64 Side;
+extern quint64 Material[PIECE_NB][16];  // 依棋子種類與序號（第幾個）累加的子力鍵
+}
+
+}
+
+#endif // POSITION_H
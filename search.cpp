@@ -0,0 +1,922 @@
+#include "search.h"
+#include "bitbase.h"
+#include "evaluate.h"
+#include "movepick.h"
+#include "nnue.h"
+#include "syzygy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace Engine {
+
+namespace {
+
+// 預留給 GUI 或通訊的時間（毫秒）
+const int MoveOverhead = 30;
+
+int Reductions[64][64];
+
+void initReductions()
+{
+    for (int d = 1; d < 64; ++d) {
+        for (int m = 1; m < 64; ++m) {
+            Reductions[d][m] = int(0.75 + std::log(double(d)) * std::log(double(m)) / 2.25);
+        }
+    }
+}
+
+// 統計計數只由自己的執行緒寫入，不需要原子加法
+inline void bump(std::atomic<quint64>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline int matedIn(int ply) { return -VALUE_MATE + ply; }
+inline int mateIn(int ply) { return VALUE_MATE - ply; }
+
+// 置換表中的將死分數以「從該節點起算」儲存，讀出時再換回從根節點起算
+inline int valueToTT(int value, int ply)
+{
+    return value >= VALUE_TB_WIN_IN_MAX_PLY ? value + ply
+         : value <= -VALUE_TB_WIN_IN_MAX_PLY ? value - ply
+         : value;
+}
+
+inline int valueFromTT(int value, int ply)
+{
+    return value == VALUE_NONE ? VALUE_NONE
+         : value >= VALUE_TB_WIN_IN_MAX_PLY ? value - ply
+         : value <= -VALUE_TB_WIN_IN_MAX_PLY ? value + ply
+         : value;
+}
+
+}
+
+struct Search::Worker {
+    Search* owner;
+    int id;
+    Position pos;
+    std::atomic<quint64> nodes;
+    std::atomic<quint64> qnodes;
+    std::atomic<quint64> ttProbes;
+    std::atomic<quint64> ttHits;
+    std::atomic<quint64> betaCutoffs;
+    std::atomic<quint64> firstMoveCutoffs;
+    std::atomic<quint64> evalCacheProbes;
+    std::atomic<quint64> evalCacheHits;
+    EvalCache evalCache;
+    NNUE::AccumulatorStack nnue;
+    bool useNnue;
+    int selDepth;
+    int completedDepth;
+    Move bestMove;
+    int bestScore;
+    std::vector<Move> bestPv;
+    QElapsedTimer busyTimer;
+
+    // MultiPV：每層依序搜尋多條主變化，後面的每條都排除前面已找到的根著法
+    struct RootLine {
+        Move move;
+        int score;
+        std::vector<Move> pv;
+    };
+    std::vector<RootLine> rootLines;  // 最近完成的一層，依分數由高到低
+    std::vector<Move> rootExcluded;
+    int pvIndex;
+
+    Move killers[MAX_PLY + 1][2];
+    int history[COLOR_NB][SQUARE_NB][SQUARE_NB];
+    bool nullMoved[MAX_PLY + 1];
+    Move pv[MAX_PLY + 1][MAX_PLY + 1];
+    int pvLength[MAX_PLY + 1];
+
+    Worker(Search* search, int index)
+        : owner(search)
+        , id(index)
+        , useNnue(false)
+        , pvIndex(0)
+    {
+        resetStats();
+        clearHistory();
+    }
+
+    void resetStats()
+    {
+        for (std::atomic<quint64>* counter : { &nodes, &qnodes, &ttProbes, &ttHits, &betaCutoffs,
+                                               &firstMoveCutoffs, &evalCacheProbes, &evalCacheHits }) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void clearHistory() { std::memset(history, 0, sizeof(history)); }
+
+    void countNode()
+    {
+        bump(nodes);
+        if ((nodes.load(std::memory_order_relaxed) & 1023) == 0) {
+            if (id == 0) {
+                owner->checkLimits();
+            }
+            if (owner->m_cpuLimit.load(std::memory_order_relaxed) < 100) {
+                throttle();
+            }
+        }
+    }
+
+    // CPU 上限：每工作一段時間就按比例休息
+    void throttle()
+    {
+        const qint64 busy = busyTimer.elapsed();
+        if (busy < 20) {
+            return;
+        }
+        const int limit = owner->m_cpuLimit.load(std::memory_order_relaxed);
+        std::this_thread::sleep_for(std::chrono::milliseconds(busy * (100 - limit) / limit));
+        busyTimer.restart();
+    }
+
+    TTEntry* probeTT(quint64 key, bool& found)
+    {
+        TTEntry* tte = owner->m_tt.probe(key, found);
+        bump(ttProbes);
+        if (found) {
+            bump(ttHits);
+        }
+        return tte;
+    }
+
+    int evaluatePosition()
+    {
+        const quint64 key = pos.key();
+        int value;
+        bump(evalCacheProbes);
+        if (evalCache.probe(key, &value)) {
+            bump(evalCacheHits);
+        } else {
+            value = useNnue ? evaluateNnue() : evaluate(pos);
+            evalCache.save(key, value);
+        }
+        // 快取裡存的是原始分數，技能等級的雜訊在取出後才加上
+        return owner->m_evalNoise > 0 ? value + evalNoise(key) : value;
+    }
+
+    // 由局面鍵雜湊出 ±m_evalNoise 的雜訊：同一次搜尋中同一局面的分數固定，置換表才不會互相矛盾
+    int evalNoise(quint64 key) const
+    {
+        quint64 h = (key ^ owner->m_noiseSeed) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 31;
+        const int range = 2 * owner->m_evalNoise + 1;
+        return int(h % quint64(range)) - owner->m_evalNoise;
+    }
+
+    // 三子殘局與 KBNK 仍以內建殘局庫為準
+    int evaluateNnue()
+    {
+        int value;
+        if (pos.pieceCount() <= 4 && Bitbases::evaluate(pos, &value)) {
+            return value;
+        }
+        return nnue.evaluate(pos);
+    }
+
+    // 走子時一併維護 NNUE 累加器
+    void doMove(Move move)
+    {
+        pos.doMove(move);
+        if (useNnue) {
+            nnue.push(pos);
+        }
+    }
+
+    void undoMove()
+    {
+        pos.undoMove();
+        if (useNnue) {
+            nnue.pop();
+        }
+    }
+
+    void doNullMove()
+    {
+        pos.doNullMove();
+        if (useNnue) {
+            nnue.push(pos);
+        }
+    }
+
+    void undoNullMove()
+    {
+        pos.undoNullMove();
+        if (useNnue) {
+            nnue.pop();
+        }
+    }
+
+    // 深度 1 一定要搜完，確保有著法可回報
+    bool stopped() const { return completedDepth > 0 && owner->m_stop.load(std::memory_order_relaxed); }
+
+    void iterate();
+    int search(int alpha, int beta, int depth, int ply, bool pvNode);
+    int qsearch(int alpha, int beta, int ply, bool pvNode);
+    void updateQuietStats(Move move, int ply, int depth, const Move* quiets, int quietCount);
+    void updatePv(int ply, Move move);
+};
+
+void Search::Worker::iterate()
+{
+    busyTimer.start();
+    selDepth = 0;
+    completedDepth = 0;
+    bestMove = MOVE_NONE;
+    bestScore = -VALUE_INFINITE;
+    bestPv.clear();
+    rootLines.clear();
+    rootExcluded.clear();
+    pvIndex = 0;
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(nullMoved, 0, sizeof(nullMoved));
+
+    MoveList legal;
+    pos.generateLegal(legal);
+    if (legal.size == 0) {
+        return;
+    }
+
+    const int maxDepth = owner->m_limits.depth > 0 ? qMin(owner->m_limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+
+    // MultiPV 只由主執行緒進行，輔助執行緒照常只找最佳著法
+    const int multiPv = id == 0 ? qMin(owner->m_multiPv, legal.size) : 1;
+
+    // 輔助執行緒錯開起始深度，讓各執行緒搜尋的樹不完全相同
+    for (int depth = 1 + (id & 1); depth <= maxDepth; ++depth) {
+        if (stopped()) {
+            break;
+        }
+
+        selDepth = 0;
+        std::vector<RootLine> lines;
+        rootExcluded.clear();
+
+        for (pvIndex = 0; pvIndex < multiPv; ++pvIndex) {
+            // 每條主變化以上一層同一條的分數作為期望視窗的中心
+            const int previous = pvIndex < int(rootLines.size()) ? rootLines[pvIndex].score : bestScore;
+            int delta = 25;
+            int alpha = -VALUE_INFINITE;
+            int beta = VALUE_INFINITE;
+            if (depth >= 5 && qAbs(previous) < VALUE_TB_WIN_IN_MAX_PLY) {
+                alpha = qMax(previous - delta, -VALUE_INFINITE);
+                beta = qMin(previous + delta, VALUE_INFINITE);
+            }
+
+            // 期望視窗：失敗時放寬後重搜
+            int value;
+            while (true) {
+                value = search(alpha, beta, depth, 0, true);
+                if (stopped()) {
+                    break;
+                }
+                if (value <= alpha) {
+                    beta = (alpha + beta) / 2;
+                    alpha = qMax(value - delta, -VALUE_INFINITE);
+                } else if (value >= beta) {
+                    beta = qMin(value + delta, VALUE_INFINITE);
+                } else {
+                    break;
+                }
+                delta += delta / 2;
+            }
+
+            if (stopped() || pvLength[0] == 0) {
+                break;
+            }
+            lines.push_back({ pv[0][0], value, std::vector<Move>(pv[0], pv[0] + pvLength[0]) });
+            rootExcluded.push_back(pv[0][0]);
+        }
+        pvIndex = 0;
+
+        // 沒搜完所有主變化的一層不採用
+        if (int(lines.size()) < multiPv) {
+            break;
+        }
+
+        std::stable_sort(lines.begin(), lines.end(),
+                         [](const RootLine& a, const RootLine& b) { return a.score > b.score; });
+        rootLines = lines;
+        completedDepth = depth;
+        bestScore = lines[0].score;
+        bestMove = lines[0].move;
+        bestPv = lines[0].pv;
+
+        if (id != 0) {
+            continue;
+        }
+
+        const qint64 elapsed = owner->m_timer.elapsed();
+        qint64 previous = 0;
+        for (qint64 t : owner->m_iterationTimes) {
+            previous += t;
+        }
+        owner->m_iterationTimes.push_back(elapsed - previous);
+
+        if (owner->m_infoCallback) {
+            for (size_t i = 0; i < rootLines.size(); ++i) {
+                SearchInfo info;
+                info.multiPv = int(i) + 1;
+                info.depth = depth;
+                info.selDepth = selDepth;
+                info.score = rootLines[i].score;
+                info.nodes = owner->totalNodes();
+                info.time = elapsed;
+                info.hashfull = owner->m_tt.hashfull();
+                info.pv = rootLines[i].pv;
+                info.stats = owner->stats();
+                owner->m_infoCallback(info);
+            }
+        }
+
+        // 已找到將死，或剩下的時間不夠再完成一層
+        if (qAbs(bestScore) >= VALUE_MATE_IN_MAX_PLY && VALUE_MATE - qAbs(bestScore) <= depth) {
+            break;
+        }
+        if (!owner->m_limits.infinite && !owner->m_ponder && owner->m_limits.useTimeManagement()
+            && (legal.size == 1 || owner->m_timer.elapsed() > owner->m_optimumTime / 2)) {
+            break;
+        }
+    }
+}
+
+int Search::Worker::search(int alpha, int beta, int depth, int ply, bool pvNode)
+{
+    if (depth <= 0) {
+        return qsearch(alpha, beta, ply, pvNode);
+    }
+
+    const bool rootNode = ply == 0;
+    pvLength[ply] = ply;
+
+    countNode();
+
+    if (!rootNode) {
+        if (stopped()) {
+            return VALUE_DRAW;
+        }
+        // 重複與五十步；根局面本身即使已重複過也要選出著法
+        if (pos.isDraw(ply)) {
+            return VALUE_DRAW;
+        }
+        if (ply >= MAX_PLY) {
+            return pos.inCheck() ? VALUE_DRAW : evaluatePosition();
+        }
+
+        // 已經有更快的將死時不必再找
+        alpha = qMax(matedIn(ply), alpha);
+        beta = qMin(mateIn(ply + 1), beta);
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    selDepth = qMax(selDepth, ply);
+    const bool inCheck = pos.inCheck();
+    const quint64 key = pos.key();
+
+    bool ttHit;
+    TTEntry* tte = probeTT(key, ttHit);
+    const int ttValue = ttHit ? valueFromTT(tte->value, ply) : VALUE_NONE;
+    const Move ttMove = rootNode ? (pvIndex < int(rootLines.size()) ? rootLines[pvIndex].move : bestMove)
+                      : ttHit ? tte->move : MOVE_NONE;
+
+    if (!pvNode && ttHit && tte->depth >= depth && ttValue != VALUE_NONE
+        && (tte->bound() & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+        return ttValue;
+    }
+
+    // 殘局庫：只在五十步計數歸零時查詢，此時 WDL 結果才精確
+    if (!rootNode && owner->m_tbCardinality > 0 && pos.pieceCount() <= owner->m_tbCardinality
+        && pos.rule50() == 0 && !pos.castlingRights()) {
+        Syzygy::ProbeState state;
+        const Syzygy::WDLScore wdl = Syzygy::probeWdl(pos, &state);
+        if (state != Syzygy::PROBE_FAIL) {
+            const int value = wdl < Syzygy::WDL_BLESSED_LOSS ? -VALUE_TB_WIN + ply
+                            : wdl > Syzygy::WDL_CURSED_WIN ? VALUE_TB_WIN - ply
+                            : int(wdl);
+            const Bound bound = wdl < Syzygy::WDL_BLESSED_LOSS ? BOUND_UPPER
+                              : wdl > Syzygy::WDL_CURSED_WIN ? BOUND_LOWER
+                              : BOUND_EXACT;
+            if (bound == BOUND_EXACT || (bound == BOUND_LOWER ? value >= beta : value <= alpha)) {
+                owner->m_tt.save(tte, key, valueToTT(value, ply), VALUE_NONE,
+                                 qMin(MAX_PLY - 1, depth + 6), bound, MOVE_NONE);
+                return value;
+            }
+        }
+    }
+
+    int staticEval = VALUE_NONE;
+    if (!inCheck) {
+        staticEval = ttHit && tte->eval != VALUE_NONE ? tte->eval : evaluatePosition();
+    }
+
+    if (!pvNode && !inCheck && qAbs(beta) < VALUE_TB_WIN_IN_MAX_PLY) {
+        // 反向無益剪枝：靜態評估遠高於 beta
+        if (depth <= 6 && staticEval - 80 * depth >= beta) {
+            return staticEval;
+        }
+
+        // 空著剪枝：讓對方連走兩步仍高於 beta；只剩兵時有迫移風險，不使用
+        const Color us = pos.sideToMove();
+        const bool hasPieces = pos.pieces(us) & ~(pos.pieces(us, PAWN) | pos.pieces(us, KING));
+        if (depth >= 3 && staticEval >= beta && hasPieces && !nullMoved[ply]) {
+            const int r = 3 + depth / 4;
+            doNullMove();
+            nullMoved[ply + 1] = true;
+            const int value = -search(-beta, -beta + 1, depth - r, ply + 1, false);
+            nullMoved[ply + 1] = false;
+            undoNullMove();
+            if (stopped()) {
+                return VALUE_DRAW;
+            }
+            if (value >= beta) {
+                return value >= VALUE_TB_WIN_IN_MAX_PLY ? beta : value;
+            }
+        }
+    }
+
+    // 著法分階段產生：置換表著法或好的吃子造成截斷時，安靜著法完全不必產生
+    MovePicker picker(pos, ttMove, killers[ply], history[pos.sideToMove()]);
+
+    const int originalAlpha = alpha;
+    int bestValue = -VALUE_INFINITE;
+    Move best = MOVE_NONE;
+    int moveCount = 0;
+    Move quiets[64];
+    int quietCount = 0;
+
+    Move move;
+    while ((move = picker.next()) != MOVE_NONE) {
+        if (rootNode && std::find(rootExcluded.begin(), rootExcluded.end(), move) != rootExcluded.end()) {
+            continue;
+        }
+        if (!pos.isLegal(move)) {
+            continue;
+        }
+
+        ++moveCount;
+        const bool quiet = !pos.isCapture(move) && moveType(move) != PROMOTION;
+        const bool isKiller = move == killers[ply][0] || move == killers[ply][1];
+
+        doMove(move);
+        const bool givesCheck = pos.inCheck();
+
+        // 淺層的安靜著法：排在很後面或評估遠低於 alpha 時跳過
+        if (!rootNode && !pvNode && !inCheck && !givesCheck && quiet && bestValue > -VALUE_TB_WIN_IN_MAX_PLY) {
+            if ((depth <= 3 && moveCount > 3 + 4 * depth)
+                || (depth <= 2 && staticEval + 150 * depth <= alpha)) {
+                undoMove();
+                continue;
+            }
+        }
+
+        const int newDepth = depth - 1 + (givesCheck ? 1 : 0);
+        int value;
+
+        if (moveCount == 1) {
+            value = -search(-beta, -alpha, newDepth, ply + 1, pvNode);
+        } else {
+            // 後面的安靜著法先以較淺的零視窗搜尋，超過 alpha 才補搜
+            int r = 0;
+            if (depth >= 3 && moveCount > 3 && quiet && !inCheck && !givesCheck) {
+                r = Reductions[qMin(depth, 63)][qMin(moveCount, 63)];
+                r -= pvNode ? 1 : 0;
+                r -= isKiller ? 1 : 0;
+                r = qBound(0, r, newDepth - 1);
+            }
+
+            value = -search(-alpha - 1, -alpha, newDepth - r, ply + 1, false);
+            if (r > 0 && value > alpha) {
+                value = -search(-alpha - 1, -alpha, newDepth, ply + 1, false);
+            }
+            if (pvNode && value > alpha && value < beta) {
+                value = -search(-beta, -alpha, newDepth, ply + 1, true);
+            }
+        }
+
+        undoMove();
+
+        if (stopped()) {
+            return VALUE_DRAW;
+        }
+
+        if (value > bestValue) {
+            bestValue = value;
+            if (value > alpha) {
+                best = move;
+                if (pvNode) {
+                    updatePv(ply, move);
+                }
+                if (value >= beta) {
+                    bump(betaCutoffs);
+                    if (moveCount == 1) {
+                        bump(firstMoveCutoffs);
+                    }
+                    if (quiet) {
+                        updateQuietStats(move, ply, depth, quiets, quietCount);
+                    }
+                    break;
+                }
+                alpha = value;
+            }
+        }
+
+        if (quiet && quietCount < 64) {
+            quiets[quietCount++] = move;
+        }
+    }
+
+    if (moveCount == 0) {
+        return inCheck ? matedIn(ply) : VALUE_DRAW;
+    }
+
+    // 排除了部分根著法的結果不是根局面真正的分數，不寫入置換表
+    if (!rootNode || pvIndex == 0) {
+        const Bound bound = bestValue >= beta ? BOUND_LOWER
+                          : bestValue > originalAlpha ? BOUND_EXACT
+                          : BOUND_UPPER;
+        owner->m_tt.save(tte, key, valueToTT(bestValue, ply), staticEval, depth, bound, best);
+    }
+
+    return bestValue;
+}
+
+int Search::Worker::qsearch(int alpha, int beta, int ply, bool pvNode)
+{
+    pvLength[ply] = ply;
+
+    countNode();
+    bump(qnodes);
+    if (stopped() || pos.isDraw(ply)) {
+        return VALUE_DRAW;
+    }
+
+    const bool inCheck = pos.inCheck();
+    if (ply >= MAX_PLY) {
+        return inCheck ? VALUE_DRAW : evaluatePosition();
+    }
+    selDepth = qMax(selDepth, ply);
+
+    const quint64 key = pos.key();
+    bool ttHit;
+    TTEntry* tte = probeTT(key, ttHit);
+    const int ttValue = ttHit ? valueFromTT(tte->value, ply) : VALUE_NONE;
+
+    if (!pvNode && ttHit && ttValue != VALUE_NONE
+        && (tte->bound() & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+        return ttValue;
+    }
+
+    // 被將軍時必須搜尋所有應將著法；否則可以選擇不吃子（stand pat）
+    int bestValue = -VALUE_INFINITE;
+    int staticEval = VALUE_NONE;
+    if (!inCheck) {
+        staticEval = ttHit && tte->eval != VALUE_NONE ? tte->eval : evaluatePosition();
+        bestValue = staticEval;
+        if (bestValue >= beta) {
+            if (!ttHit) {
+                owner->m_tt.save(tte, key, valueToTT(bestValue, ply), staticEval, 0, BOUND_LOWER, MOVE_NONE);
+            }
+            return bestValue;
+        }
+        alpha = qMax(alpha, bestValue);
+    }
+
+    // 被將軍時產生所有應將著法，否則只有吃子與升后
+    MovePicker picker(pos, ttHit ? tte->move : MOVE_NONE);
+
+    const int originalAlpha = alpha;
+    Move best = MOVE_NONE;
+    int moveCount = 0;
+
+    Move move;
+    while ((move = picker.next()) != MOVE_NONE) {
+        if (!pos.isLegal(move)) {
+            continue;
+        }
+        ++moveCount;
+
+        // 差值剪枝：吃到的子加上安全邊際仍追不上 alpha
+        if (!inCheck && moveType(move) != PROMOTION) {
+            const int captured = moveType(move) == EN_PASSANT ? PAWN : kindOf(pos.pieceOn(moveTo(move)));
+            if (staticEval + PieceValue[captured] + 200 <= alpha) {
+                continue;
+            }
+        }
+
+        doMove(move);
+        const int value = -qsearch(-beta, -alpha, ply + 1, pvNode);
+        undoMove();
+
+        if (stopped()) {
+            return VALUE_DRAW;
+        }
+
+        if (value > bestValue) {
+            bestValue = value;
+            if (value > alpha) {
+                best = move;
+                if (pvNode) {
+                    updatePv(ply, move);
+                }
+                if (value >= beta) {
+                    break;
+                }
+                alpha = value;
+            }
+        }
+    }
+
+    if (inCheck && moveCount == 0) {
+        return matedIn(ply);
+    }
+
+    const Bound bound = bestValue >= beta ? BOUND_LOWER
+                      : pvNode && bestValue > originalAlpha ? BOUND_EXACT
+                      : BOUND_UPPER;
+    owner->m_tt.save(tte, key, valueToTT(bestValue, ply), staticEval, 0, bound, best);
+
+    return bestValue;
+}
+
+void Search::Worker::updateQuietStats(Move move, int ply, int depth, const Move* quiets, int quietCount)
+{
+    if (killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    // 造成截斷的著法加分，之前試過但失敗的安靜著法扣分；數值自動衰減，維持在 ±16384 之內
+    const Color us = pos.sideToMove();
+    const int bonus = qMin(depth * depth, 400);
+    auto update = [this, us](Move m, int delta) {
+        int& entry = history[us][moveFrom(m)][moveTo(m)];
+        entry += delta - entry * qAbs(delta) / 16384;
+    };
+
+    update(move, bonus);
+    for (int i = 0; i < quietCount; ++i) {
+        update(quiets[i], -bonus);
+    }
+}
+
+void Search::Worker::updatePv(int ply, Move move)
+{
+    pv[ply][ply] = move;
+    for (int i = ply + 1; i < pvLength[ply + 1]; ++i) {
+        pv[ply][i] = pv[ply + 1][i];
+    }
+    pvLength[ply] = qMax(pvLength[ply + 1], ply + 1);
+}
+
+Search::Search()
+    : m_stop(false)
+    , m_searching(false)
+    , m_ponder(false)
+    , m_cpuLimit(100)
+    , m_elapsed(0)
+    , m_optimumTime(0)
+    , m_maximumTime(0)
+    , m_tbCardinality(0)
+    , m_multiPv(1)
+    , m_evalNoise(0)
+    , m_noiseSeed(0)
+    , m_rng(std::random_device()())
+{
+    static std::once_flag once;
+    std::call_once(once, initReductions);
+
+    setThreads(1);
+}
+
+Search::~Search()
+{
+    stop();
+    wait();
+}
+
+void Search::setHashSize(int megabytes)
+{
+    wait();
+    m_tt.resize(megabytes);
+}
+
+void Search::setThreads(int threads)
+{
+    wait();
+    threads = qBound(1, threads, 256);
+    m_workers.clear();
+    for (int i = 0; i < threads; ++i) {
+        m_workers.emplace_back(new Worker(this, i));
+    }
+}
+
+void Search::clearHash()
+{
+    wait();
+    m_tt.clear();
+    for (auto& worker : m_workers) {
+        worker->clearHistory();
+        worker->evalCache.clear();
+    }
+}
+
+void Search::setInfoCallback(InfoCallback callback)
+{
+    wait();
+    m_infoCallback = callback;
+}
+
+void Search::start(const Position& pos, const SearchLimits& limits, DoneCallback onDone)
+{
+    wait();
+
+    m_limits = limits;
+    m_stop = false;
+    m_searching = true;
+    m_ponder = limits.ponder;
+    m_cpuLimit = limits.ponder ? qBound(10, limits.cpuLimit, 100) : 100;
+    m_timer.start();
+    m_tbCardinality = Syzygy::maxCardinality();
+    m_tt.newSearch();
+    initTimeManagement(pos.sideToMove());
+
+    // 技能等級：等級 0 的雜訊約 ±200，每升一級少 10；至少搜尋 4 條主變化供抽選
+    m_multiPv = qMax(1, limits.multiPv);
+    m_evalNoise = 0;
+    if (limits.skillLevel < MAX_SKILL_LEVEL) {
+        m_multiPv = qMax(m_multiPv, 4);
+        m_evalNoise = (MAX_SKILL_LEVEL - qMax(0, limits.skillLevel)) * 10;
+        m_noiseSeed = m_rng();
+    }
+
+    // 評估函數改變時快取裡的分數不能再用
+    const bool useNnue = NNUE::isLoaded();
+    m_iterationTimes.clear();
+    for (auto& worker : m_workers) {
+        worker->pos = pos;
+        worker->resetStats();
+        if (worker->useNnue != useNnue) {
+            worker->useNnue = useNnue;
+            worker->evalCache.clear();
+        }
+        if (useNnue) {
+            worker->nnue.reset(pos);
+        }
+    }
+
+    m_thread = std::thread(&Search::mainThread, this, onDone);
+}
+
+void Search::stop()
+{
+    m_stop = true;
+}
+
+void Search::ponderhit()
+{
+    m_cpuLimit = 100;
+    m_ponder = false;
+}
+
+void Search::wait()
+{
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+QString Search::scoreToUci(int value)
+{
+    if (qAbs(value) >= VALUE_MATE_IN_MAX_PLY) {
+        const int moves = value > 0 ? (VALUE_MATE - value + 1) / 2 : -(VALUE_MATE + value) / 2;
+        return QString("mate %1").arg(moves);
+    }
+    return QString("cp %1").arg(value);
+}
+
+void Search::mainThread(DoneCallback onDone)
+{
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        helpers.emplace_back(&Worker::iterate, m_workers[i].get());
+    }
+
+    Worker* main = m_workers[0].get();
+    main->iterate();
+
+    // UCI 規定 go infinite 與 go ponder 必須等到 stop（或 ponderhit）才回報
+    while ((m_limits.infinite || m_ponder) && !m_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    m_stop = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    Move bestMove = main->bestMove;
+    Move ponderMove = main->bestPv.size() > 1 ? main->bestPv[1] : MOVE_NONE;
+    if (m_limits.skillLevel < MAX_SKILL_LEVEL && main->rootLines.size() > 1) {
+        bestMove = pickSkillMove(&ponderMove);
+    }
+    m_elapsed = m_timer.elapsed();
+    m_searching = false;
+
+    if (onDone) {
+        onDone(bestMove, ponderMove);
+    }
+}
+
+// 分數較差的主變化加上隨機加成，等級越低加成越大；與最佳著法的差距超過一兵時幾乎不會被選到，
+// 所以低等級會走次佳的著法，但不會隨便送子
+Move Search::pickSkillMove(Move* ponderMove)
+{
+    const auto& lines = m_workers[0]->rootLines;
+    const int weakness = 120 - 2 * qBound(0, m_limits.skillLevel, MAX_SKILL_LEVEL);
+    const int top = lines.front().score;
+    const int delta = qMin(top - lines.back().score, PieceValue[PAWN]);
+
+    size_t chosen = 0;
+    int maxScore = -VALUE_INFINITE;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const int push = (weakness * (top - lines[i].score) + delta * int(m_rng() % quint64(weakness))) / 128;
+        if (lines[i].score + push >= maxScore) {
+            maxScore = lines[i].score + push;
+            chosen = i;
+        }
+    }
+
+    *ponderMove = lines[chosen].pv.size() > 1 ? lines[chosen].pv[1] : MOVE_NONE;
+    return lines[chosen].move;
+}
+
+void Search::initTimeManagement(Color us)
+{
+    m_optimumTime = m_maximumTime = 0;
+
+    if (m_limits.movetime > 0) {
+        m_optimumTime = m_maximumTime = m_limits.movetime;
+    } else if (m_limits.useTimeManagement()) {
+        // 平均分配剩餘時間（預設還有 40 步），加上大部分的加秒；單步最多用掉剩餘時間的 3/4
+        const int movesToGo = m_limits.movestogo > 0 ? qMin(m_limits.movestogo, 40) : 40;
+        const qint64 remaining = qMax(1, m_limits.time[us] - MoveOverhead);
+        m_maximumTime = qMax<qint64>(1, remaining * 3 / 4);
+        m_optimumTime = qMin(remaining / movesToGo + m_limits.inc[us] * 3 / 4, m_maximumTime);
+        m_maximumTime = qMin(m_optimumTime * 4, m_maximumTime);
+    }
+}
+
+void Search::checkLimits()
+{
+    if (m_limits.infinite || m_ponder) {
+        return;
+    }
+    if ((m_maximumTime > 0 && m_timer.elapsed() >= m_maximumTime)
+        || (m_limits.nodes > 0 && totalNodes() >= m_limits.nodes)) {
+        m_stop = true;
+    }
+}
+
+SearchStats Search::stats() const
+{
+    SearchStats stats;
+    for (const auto& worker : m_workers) {
+        stats.nodes += worker->nodes.load(std::memory_order_relaxed);
+        stats.qnodes += worker->qnodes.load(std::memory_order_relaxed);
+        stats.ttProbes += worker->ttProbes.load(std::memory_order_relaxed);
+        stats.ttHits += worker->ttHits.load(std::memory_order_relaxed);
+        stats.betaCutoffs += worker->betaCutoffs.load(std::memory_order_relaxed);
+        stats.firstMoveCutoffs += worker->firstMoveCutoffs.load(std::memory_order_relaxed);
+        stats.evalCacheProbes += worker->evalCacheProbes.load(std::memory_order_relaxed);
+        stats.evalCacheHits += worker->evalCacheHits.load(std::memory_order_relaxed);
+    }
+
+    const Worker* main = m_workers[0].get();
+    stats.depth = main->completedDepth;
+    stats.selDepth = main->selDepth;
+    stats.time = m_searching ? m_timer.elapsed() : m_elapsed;
+    stats.nps = stats.nodes * 1000 / quint64(qMax<qint64>(1, stats.time));
+    stats.iterationTimes = m_iterationTimes;
+    return stats;
+}
+
+quint64 Search::totalNodes() const
+{
+    quint64 total = 0;
+    for (const auto& worker : m_workers) {
+        total += worker->nodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+}
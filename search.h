@@ -0,0 +1,146 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "position.h"
+#include "tt.h"
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Engine {
+
+const int MAX_PLY = 128;
+
+const int VALUE_DRAW = 0;
+const int VALUE_MATE = 32000;
+const int VALUE_INFINITE = 32001;
+const int VALUE_NONE = 32002;
+const int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+// 殘局庫確定的勝負排在將死之後、任何評估分數之前
+const int VALUE_TB_WIN = VALUE_MATE_IN_MAX_PLY - 1;
+const int VALUE_TB_WIN_IN_MAX_PLY = VALUE_TB_WIN - MAX_PLY;
+
+// 技能等級 0-20；20 為全力
+const int MAX_SKILL_LEVEL = 20;
+
+// 搜尋限制；全部為 0 時搜尋到 MAX_PLY 或收到 stop 為止
+struct SearchLimits {
+    int depth = 0;
+    int movetime = 0;             // 毫秒
+    int time[COLOR_NB] = { 0, 0 };  // 剩餘時間（毫秒），有設定時由搜尋自行分配
+    int inc[COLOR_NB] = { 0, 0 };
+    int movestogo = 0;
+    quint64 nodes = 0;
+    bool infinite = false;        // 搜尋結束後仍等待 stop 才回報（UCI go infinite）
+    bool ponder = false;          // 在對方的時間思考：不計時，等待 ponderhit 或 stop
+    int cpuLimit = 100;           // 每個執行緒最多使用的 CPU 百分比（10-100），ponderhit 後恢復 100
+    int multiPv = 1;              // 同時回報的主變化條數
+    int skillLevel = MAX_SKILL_LEVEL;  // 低於 20 時評估加入雜訊，並從至少 4 條主變化中抽選著法
+
+    bool useTimeManagement() const { return time[WHITE] > 0 || time[BLACK] > 0; }
+};
+
+// 搜尋統計（所有執行緒合計），用來量測搜尋效率的變化
+struct SearchStats {
+    quint64 nodes = 0;             // 含靜止搜尋節點
+    quint64 qnodes = 0;            // 靜止搜尋節點
+    quint64 nps = 0;
+    int depth = 0;                 // 已完成的深度
+    int selDepth = 0;              // 實際到達的最大層數
+    quint64 ttProbes = 0;
+    quint64 ttHits = 0;
+    quint64 betaCutoffs = 0;
+    quint64 firstMoveCutoffs = 0;  // 第一個著法就造成截斷，比例越高表示排序越好
+    quint64 evalCacheProbes = 0;
+    quint64 evalCacheHits = 0;
+    qint64 time = 0;               // 毫秒
+    std::vector<qint64> iterationTimes;  // 各層迭代花費的毫秒數，索引 0 為深度 1
+
+    double ttHitRate() const { return ttProbes ? double(ttHits) / ttProbes : 0.0; }
+    double firstMoveCutoffRate() const { return betaCutoffs ? double(firstMoveCutoffs) / betaCutoffs : 0.0; }
+    double evalCacheHitRate() const { return evalCacheProbes ? double(evalCacheHits) / evalCacheProbes : 0.0; }
+};
+
+// 每完成一層迭代回報一次
+struct SearchInfo {
+    int multiPv = 1;  // 第幾條主變化（1 起算），MultiPV 時每層依分數高低各回報一次
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;
+    quint64 nodes = 0;
+    qint64 time = 0;  // 毫秒
+    int hashfull = 0;
+    std::vector<Move> pv;
+    SearchStats stats;
+};
+
+// 內建引擎的搜尋：迭代加深 alpha-beta（PVS）、靜止搜尋、置換表
+// 多執行緒時以共用置換表的方式平行搜尋（Lazy SMP），由第一個執行緒決定結果
+// 搜尋在背景執行緒進行，結束時呼叫 DoneCallback（在搜尋執行緒上）
+class Search {
+public:
+    typedef std::function<void(const SearchInfo&)> InfoCallback;
+    typedef std::function<void(Move bestMove, Move ponderMove)> DoneCallback;
+
+    Search();
+    ~Search();
+
+    // 以下設定會先等待進行中的搜尋結束
+    void setHashSize(int megabytes);
+    void setThreads(int threads);
+    void clearHash();  // 也清除評估快取；更換 NNUE 網路後必須呼叫
+    void setInfoCallback(InfoCallback callback);
+
+    int threads() const { return int(m_workers.size()); }
+
+    void start(const Position& pos, const SearchLimits& limits, DoneCallback onDone);
+    void stop();
+    void ponderhit();  // 對方走了預測的著法：改為正常計時（時間從搜尋開始算起）
+    void wait();  // 不可在 DoneCallback 內呼叫
+    bool isSearching() const { return m_searching; }
+
+    // 最近一次搜尋的統計；搜尋進行中請改用 InfoCallback 收到的 SearchInfo::stats
+    SearchStats stats() const;
+
+    // UCI 格式的分數："cp 35" 或 "mate -3"
+    static QString scoreToUci(int value);
+
+private:
+    struct Worker;
+    friend struct Worker;
+
+    TranspositionTable m_tt;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<qint64> m_iterationTimes;  // 只由主執行緒寫入
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_searching;
+    std::atomic<bool> m_ponder;
+    std::atomic<int> m_cpuLimit;
+
+    SearchLimits m_limits;
+    QElapsedTimer m_timer;
+    qint64 m_elapsed;  // 搜尋結束時的耗時
+    qint64 m_optimumTime;
+    qint64 m_maximumTime;
+    int m_tbCardinality;
+    InfoCallback m_infoCallback;
+    int m_multiPv;
+    int m_evalNoise;       // 評估雜訊的幅度（百分兵），0 表示不加
+    quint64 m_noiseSeed;   // 每次搜尋換一次，同一次搜尋內同一局面的雜訊固定
+    std::mt19937_64 m_rng;
+
+    void mainThread(DoneCallback onDone);
+    Move pickSkillMove(Move* ponderMove);
+    void initTimeManagement(Color us);
+    void checkLimits();
+    quint64 totalNodes() const;
+};
+
+}
+
+#endif // SEARCH_H
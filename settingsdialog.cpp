@@ -1,12 +1,17 @@
 #include "settingsdialog.h"
+#include "chessai.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QLabel>
 #include <QColorDialog>
+#include <QFileDialog>
+#include <QDir>
 #include <QDialogButtonBox>
 #include <QMessageBox>
+#include <QThread>
+#include <QScrollArea>
 
 const QColor SettingsDialog::DEFAULT_LIGHT_COLOR = QColor("#F0D9B5");
 const QColor SettingsDialog::DEFAULT_DARK_COLOR = QColor("#B58863");
@@ -61,6 +66,79 @@ void SettingsDialog::setupUI()
     colorLayout->addRow(m_resetColorsButton);
     mainLayout->addWidget(colorGroup);
 
+    // 殘局庫群組
+    QGroupBox* tablebaseGroup = new QGroupBox(tr("Endgame Tablebases"), this);
+    QVBoxLayout* tablebaseLayout = new QVBoxLayout(tablebaseGroup);
+    QHBoxLayout* pathLayout = new QHBoxLayout();
+    m_syzygyPathEdit = new QLineEdit(this);
+    m_syzygyPathEdit->setPlaceholderText(tr("Folder containing Syzygy .rtbw/.rtbz files"));
+    m_syzygyBrowseButton = new QPushButton(tr("Browse..."), this);
+    connect(m_syzygyBrowseButton, &QPushButton::clicked, this, &SettingsDialog::onBrowseSyzygyClicked);
+    pathLayout->addWidget(m_syzygyPathEdit);
+    pathLayout->addWidget(m_syzygyBrowseButton);
+    tablebaseLayout->addLayout(pathLayout);
+    QLabel* tablebaseHint = new QLabel(tr("Used by the built-in AI. Separate multiple folders with '%1'.")
+                                           .arg(QDir::listSeparator()), this);
+    tablebaseHint->setWordWrap(true);
+    tablebaseLayout->addWidget(tablebaseHint);
+    mainLayout->addWidget(tablebaseGroup);
+
+    // 內建引擎群組
+    QGroupBox* engineGroup = new QGroupBox(tr("Built-in Engine"), this);
+    QFormLayout* engineLayout = new QFormLayout(engineGroup);
+    m_engineThreadsSpinBox = new QSpinBox(this);
+    m_engineThreadsSpinBox->setRange(1, qMax(1, QThread::idealThreadCount()));
+    m_engineThreadsSpinBox->setValue(1);
+    m_ponderCheckBox = new QCheckBox(tr("Think during your turn (pondering)"), this);
+    m_ponderCpuLimitSpinBox = new QSpinBox(this);
+    m_ponderCpuLimitSpinBox->setRange(10, 100);
+    m_ponderCpuLimitSpinBox->setSingleStep(10);
+    m_ponderCpuLimitSpinBox->setSuffix("%");
+    m_ponderCpuLimitSpinBox->setValue(50);
+    m_ponderCpuLimitSpinBox->setEnabled(false);
+    connect(m_ponderCheckBox, &QCheckBox::toggled, m_ponderCpuLimitSpinBox, &QSpinBox::setEnabled);
+    QHBoxLayout* evalFileLayout = new QHBoxLayout();
+    m_evalFileEdit = new QLineEdit(this);
+    m_evalFileEdit->setPlaceholderText(tr("Empty = classical evaluation"));
+    m_evalFileBrowseButton = new QPushButton(tr("Browse..."), this);
+    connect(m_evalFileBrowseButton, &QPushButton::clicked, this, &SettingsDialog::onBrowseEvalFileClicked);
+    evalFileLayout->addWidget(m_evalFileEdit);
+    evalFileLayout->addWidget(m_evalFileBrowseButton);
+    m_searchLimitComboBox = new QComboBox(this);
+    m_searchLimitComboBox->addItem(tr("Game clock"), static_cast<int>(SearchLimitMode::Clock));
+    m_searchLimitComboBox->addItem(tr("Time per move"), static_cast<int>(SearchLimitMode::MoveTime));
+    m_searchLimitComboBox->addItem(tr("Depth"), static_cast<int>(SearchLimitMode::Depth));
+    m_searchLimitComboBox->addItem(tr("Nodes"), static_cast<int>(SearchLimitMode::Nodes));
+    m_searchLimitValueSpinBox = new QSpinBox(this);
+    connect(m_searchLimitComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &SettingsDialog::onSearchLimitModeChanged);
+    onSearchLimitModeChanged(0);
+    QLabel* searchLimitHint = new QLabel(tr("Timed games always pass both clocks to the engine; "
+                                            "the limit is applied on top of them."), this);
+    searchLimitHint->setWordWrap(true);
+    engineLayout->addRow(tr("Threads:"), m_engineThreadsSpinBox);
+    engineLayout->addRow(m_ponderCheckBox);
+    engineLayout->addRow(tr("CPU limit while pondering:"), m_ponderCpuLimitSpinBox);
+    engineLayout->addRow(tr("NNUE network:"), evalFileLayout);
+    engineLayout->addRow(tr("Search limit:"), m_searchLimitComboBox);
+    engineLayout->addRow(tr("Limit value:"), m_searchLimitValueSpinBox);
+    engineLayout->addRow(searchLimitHint);
+    mainLayout->addWidget(engineGroup);
+
+    // 外部引擎群組：欄位依引擎宣告的選項建立（setEngineOptions）
+    QGroupBox* uciGroup = new QGroupBox(tr("External Engine"), this);
+    QVBoxLayout* uciLayout = new QVBoxLayout(uciGroup);
+    QScrollArea* uciScrollArea = new QScrollArea(this);
+    uciScrollArea->setWidgetResizable(true);
+    uciScrollArea->setFrameShape(QFrame::NoFrame);
+    uciScrollArea->setMaximumHeight(200);
+    QWidget* uciOptionsWidget = new QWidget(uciScrollArea);
+    m_engineOptionsLayout = new QFormLayout(uciOptionsWidget);
+    m_engineOptionsLayout->addRow(new QLabel(tr("The external engine is not running."), this));
+    uciScrollArea->setWidget(uciOptionsWidget);
+    uciLayout->addWidget(uciScrollArea);
+    mainLayout->addWidget(uciGroup);
+
     // 重設為預設值按鈕
     m_resetDefaultsButton = new QPushButton(tr("Reset All Settings to Default"), this);
     m_resetDefaultsButton->setStyleSheet("QPushButton { background-color: #FFE4B5; }");
@@ -137,7 +215,161 @@ void SettingsDialog::onResetDefaultsClicked()
         m_darkSquareColor = DEFAULT_DARK_COLOR;
         updateColorButtonStyle(m_lightSquareColorButton, m_lightSquareColor);
         updateColorButtonStyle(m_darkSquareColorButton, m_darkSquareColor);
+        m_syzygyPathEdit->clear();
+        m_engineThreadsSpinBox->setValue(1);
+        m_ponderCheckBox->setChecked(false);
+        m_ponderCpuLimitSpinBox->setValue(50);
+        m_evalFileEdit->clear();
+        m_searchLimitComboBox->setCurrentIndex(0);
+        for (const auto& entry : m_engineOptionWidgets) {
+            setEngineOptionValue(entry.first, entry.second, engineOptionDefault(entry.first));
+        }
+    }
+}
+
+void SettingsDialog::onBrowseSyzygyClicked()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Choose Tablebase Folder"), m_syzygyPathEdit->text());
+    if (!dir.isEmpty()) {
+        m_syzygyPathEdit->setText(QDir::toNativeSeparators(dir));
+    }
+}
+
+void SettingsDialog::onBrowseEvalFileClicked()
+{
+    QString file = QFileDialog::getOpenFileName(this, tr("Choose Network File"), m_evalFileEdit->text(),
+                                                tr("NNUE networks (*.nnue);;All files (*)"));
+    if (!file.isEmpty()) {
+        m_evalFileEdit->setText(QDir::toNativeSeparators(file));
+    }
+}
+
+void SettingsDialog::onSearchLimitModeChanged(int index)
+{
+    // 每種限制的範圍與單位不同，切換時換成該模式的預設值
+    switch (static_cast<SearchLimitMode>(m_searchLimitComboBox->itemData(index).toInt())) {
+    case SearchLimitMode::Clock:
+        m_searchLimitValueSpinBox->setRange(0, 0);
+        m_searchLimitValueSpinBox->setSuffix(QString());
+        m_searchLimitValueSpinBox->setEnabled(false);
+        return;
+    case SearchLimitMode::MoveTime:
+        m_searchLimitValueSpinBox->setRange(50, 600000);
+        m_searchLimitValueSpinBox->setSingleStep(100);
+        m_searchLimitValueSpinBox->setSuffix(tr(" ms"));
+        m_searchLimitValueSpinBox->setValue(1000);
+        break;
+    case SearchLimitMode::Depth:
+        m_searchLimitValueSpinBox->setRange(1, Engine::MAX_PLY - 1);
+        m_searchLimitValueSpinBox->setSingleStep(1);
+        m_searchLimitValueSpinBox->setSuffix(QString());
+        m_searchLimitValueSpinBox->setValue(12);
+        break;
+    case SearchLimitMode::Nodes:
+        m_searchLimitValueSpinBox->setRange(1000, 1000000000);
+        m_searchLimitValueSpinBox->setSingleStep(100000);
+        m_searchLimitValueSpinBox->setSuffix(QString());
+        m_searchLimitValueSpinBox->setValue(1000000);
+        break;
+    }
+    m_searchLimitValueSpinBox->setEnabled(true);
+}
+
+void SettingsDialog::setEngineOptions(const QList<UCIEngine::Option>& options)
+{
+    while (m_engineOptionsLayout->rowCount() > 0) {
+        m_engineOptionsLayout->removeRow(0);
+    }
+    m_engineOptionWidgets.clear();
+
+    // 技能等級與預先思考由遊戲本身控制，UCI_ 開頭的選項保留給介面，button 不是設定
+    QList<UCIEngine::Option> shown;
+    for (const UCIEngine::Option& option : options) {
+        if (option.type == "button" || option.name.startsWith("UCI_")
+            || option.name == "Skill Level" || option.name == "Ponder") {
+            continue;
+        }
+        // Threads、Hash、MultiPV 排在最前面
+        if (option.name == "Threads" || option.name == "Hash" || option.name == "MultiPV") {
+            int i = 0;
+            while (i < shown.size() && (shown[i].name == "Threads" || shown[i].name == "Hash")) {
+                ++i;
+            }
+            shown.insert(option.name == "Threads" ? 0 : i, option);
+        } else {
+            shown.append(option);
+        }
+    }
+
+    if (shown.isEmpty()) {
+        m_engineOptionsLayout->addRow(new QLabel(tr("The external engine is not running."), this));
+        return;
+    }
+
+    QSettings settings("ChessGame", "Settings");
+    settings.beginGroup("engineOptions");
+    for (const UCIEngine::Option& option : shown) {
+        QWidget* widget = nullptr;
+        if (option.type == "check") {
+            widget = new QCheckBox(this);
+        } else if (option.type == "spin") {
+            QSpinBox* spinBox = new QSpinBox(this);
+            spinBox->setRange(option.min, option.max);
+            if (option.name == "Hash") {
+                spinBox->setSuffix(tr(" MB"));
+            }
+            widget = spinBox;
+        } else if (option.type == "combo") {
+            QComboBox* comboBox = new QComboBox(this);
+            comboBox->addItems(option.vars);
+            widget = comboBox;
+        } else {
+            widget = new QLineEdit(this);
+        }
+        setEngineOptionValue(option, widget, settings.value(option.name, engineOptionDefault(option)).toString());
+        m_engineOptionsLayout->addRow(option.name + ":", widget);
+        m_engineOptionWidgets.append(qMakePair(option, widget));
     }
+    settings.endGroup();
+}
+
+QString SettingsDialog::engineOptionDefault(const UCIEngine::Option& option) const
+{
+    // 引擎的預設值是為最小的機器準備的（Stockfish 為 1 個執行緒、16 MB），這兩項改依主機決定
+    if (option.name == "Threads") {
+        return QString::number(qBound(option.min, UCIEngine::defaultThreads(), option.max));
+    }
+    if (option.name == "Hash") {
+        return QString::number(qBound(option.min, UCIEngine::defaultHashMb(), option.max));
+    }
+    return option.defaultValue;
+}
+
+void SettingsDialog::setEngineOptionValue(const UCIEngine::Option& option, QWidget* widget, const QString& value)
+{
+    if (option.type == "check") {
+        static_cast<QCheckBox*>(widget)->setChecked(value == "true");
+    } else if (option.type == "spin") {
+        static_cast<QSpinBox*>(widget)->setValue(value.toInt());
+    } else if (option.type == "combo") {
+        static_cast<QComboBox*>(widget)->setCurrentText(value);
+    } else {
+        static_cast<QLineEdit*>(widget)->setText(value);
+    }
+}
+
+QString SettingsDialog::engineOptionValue(const UCIEngine::Option& option, QWidget* widget) const
+{
+    if (option.type == "check") {
+        return static_cast<QCheckBox*>(widget)->isChecked() ? "true" : "false";
+    }
+    if (option.type == "spin") {
+        return QString::number(static_cast<QSpinBox*>(widget)->value());
+    }
+    if (option.type == "combo") {
+        return static_cast<QComboBox*>(widget)->currentText();
+    }
+    return static_cast<QLineEdit*>(widget)->text();
 }
 
 void SettingsDialog::onOkClicked()
@@ -166,6 +398,41 @@ QColor SettingsDialog::getDarkSquareColor() const
     return m_darkSquareColor;
 }
 
+QString SettingsDialog::getSyzygyPath() const
+{
+    return m_syzygyPathEdit->text().trimmed();
+}
+
+bool SettingsDialog::isPonderEnabled() const
+{
+    return m_ponderCheckBox->isChecked();
+}
+
+int SettingsDialog::getEngineThreads() const
+{
+    return m_engineThreadsSpinBox->value();
+}
+
+int SettingsDialog::getPonderCpuLimit() const
+{
+    return m_ponderCpuLimitSpinBox->value();
+}
+
+QString SettingsDialog::getEvalFile() const
+{
+    return m_evalFileEdit->text().trimmed();
+}
+
+int SettingsDialog::getSearchLimitMode() const
+{
+    return m_searchLimitComboBox->currentData().toInt();
+}
+
+int SettingsDialog::getSearchLimitValue() const
+{
+    return m_searchLimitValueSpinBox->value();
+}
+
 void SettingsDialog::loadSettings()
 {
     QSettings settings("ChessGame", "Settings");
@@ -176,6 +443,19 @@ void SettingsDialog::loadSettings()
     m_darkSquareColor = settings.value("darkSquareColor", DEFAULT_DARK_COLOR).value<QColor>();
     updateColorButtonStyle(m_lightSquareColorButton, m_lightSquareColor);
     updateColorButtonStyle(m_darkSquareColorButton, m_darkSquareColor);
+
+    m_syzygyPathEdit->setText(settings.value("syzygyPath", QString()).toString());
+
+    m_engineThreadsSpinBox->setValue(settings.value("engineThreads", 1).toInt());
+    m_ponderCheckBox->setChecked(settings.value("ponderEnabled", false).toBool());
+    m_ponderCpuLimitSpinBox->setValue(settings.value("ponderCpuLimit", 50).toInt());
+    m_evalFileEdit->setText(settings.value("evalFile", QString()).toString());
+    // 先切換模式（會套用預設值），再還原儲存的數值
+    int limitIndex = m_searchLimitComboBox->findData(settings.value("searchLimitMode", static_cast<int>(SearchLimitMode::Clock)).toInt());
+    m_searchLimitComboBox->setCurrentIndex(qMax(0, limitIndex));
+    if (m_searchLimitValueSpinBox->isEnabled()) {
+        m_searchLimitValueSpinBox->setValue(settings.value("searchLimitValue", m_searchLimitValueSpinBox->value()).toInt());
+    }
 }
 
 void SettingsDialog::saveSettings()
@@ -185,4 +465,26 @@ void SettingsDialog::saveSettings()
     settings.setValue("undoEnabled", m_undoEnabledCheckBox->isChecked());
     settings.setValue("lightSquareColor", m_lightSquareColor);
     settings.setValue("darkSquareColor", m_darkSquareColor);
+    settings.setValue("syzygyPath", getSyzygyPath());
+    settings.setValue("engineThreads", getEngineThreads());
+    settings.setValue("ponderEnabled", isPonderEnabled());
+    settings.setValue("ponderCpuLimit", getPonderCpuLimit());
+    settings.setValue("evalFile", getEvalFile());
+    settings.setValue("searchLimitMode", getSearchLimitMode());
+    settings.setValue("searchLimitValue", getSearchLimitValue());
+
+    // 引擎沒有執行時沒有欄位，保留之前儲存的選項
+    // 只儲存和預設值不同的選項，改回預設值時移除：Threads 與 Hash 才會繼續依主機決定
+    if (!m_engineOptionWidgets.isEmpty()) {
+        settings.beginGroup("engineOptions");
+        for (const auto& entry : m_engineOptionWidgets) {
+            const QString value = engineOptionValue(entry.first, entry.second);
+            if (value == engineOptionDefault(entry.first)) {
+                settings.remove(entry.first.name);
+            } else {
+                settings.setValue(entry.first.name, value);
+            }
+        }
+        settings.endGroup();
+    }
 }
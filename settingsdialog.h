@@ -8,7 +8,12 @@
 #include <QColor>
 #include <QSettings>
 #include <QComboBox>
+#include <QLineEdit>
 #include <QTranslator>
+#include <QFormLayout>
+#include <QList>
+#include <QPair>
+#include "uciengine.h"
 
 class SettingsDialog : public QDialog
 {
@@ -22,6 +27,16 @@ public:
     bool isUndoEnabled() const;
     QColor getLightSquareColor() const;
     QColor getDarkSquareColor() const;
+    QString getSyzygyPath() const;
+    bool isPonderEnabled() const;
+    int getEngineThreads() const;
+    int getPonderCpuLimit() const;
+    QString getEvalFile() const;
+    int getSearchLimitMode() const;   // SearchLimitMode
+    int getSearchLimitValue() const;
+
+    // 外部引擎宣告的選項，建立對應的欄位並載入儲存的值；引擎沒有執行時傳入空清單
+    void setEngineOptions(const QList<UCIEngine::Option>& options);
 
     // Load/Save settings
     void loadSettings();
@@ -32,18 +47,35 @@ private slots:
     void onDarkColorButtonClicked();
     void onResetColorsClicked();
     void onResetDefaultsClicked();
+    void onBrowseSyzygyClicked();
+    void onBrowseEvalFileClicked();
+    void onSearchLimitModeChanged(int index);
     void onOkClicked();
     void onCancelClicked();
 
 private:
     void setupUI();
     void updateColorButtonStyle(QPushButton* button, const QColor& color);
+    QString engineOptionDefault(const UCIEngine::Option& option) const;
+    void setEngineOptionValue(const UCIEngine::Option& option, QWidget* widget, const QString& value);
+    QString engineOptionValue(const UCIEngine::Option& option, QWidget* widget) const;
 
     QCheckBox* m_undoEnabledCheckBox;
     QPushButton* m_lightSquareColorButton;
     QPushButton* m_darkSquareColorButton;
     QPushButton* m_resetColorsButton;
     QPushButton* m_resetDefaultsButton;
+    QLineEdit* m_syzygyPathEdit;
+    QPushButton* m_syzygyBrowseButton;
+    QCheckBox* m_ponderCheckBox;
+    QSpinBox* m_engineThreadsSpinBox;
+    QSpinBox* m_ponderCpuLimitSpinBox;
+    QLineEdit* m_evalFileEdit;
+    QPushButton* m_evalFileBrowseButton;
+    QComboBox* m_searchLimitComboBox;
+    QSpinBox* m_searchLimitValueSpinBox;
+    QFormLayout* m_engineOptionsLayout;
+    QList<QPair<UCIEngine::Option, QWidget*>> m_engineOptionWidgets;
     
     QColor m_lightSquareColor;
     QColor m_darkSquareColor;
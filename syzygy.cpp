@@ -0,0 +1,1111 @@
+#include "syzygy.h"
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// 索引計算與解壓縮依照 Ronald de Man 的 Syzygy 格式（與 Stockfish / Fathom 的實作相容）
+
+using namespace Engine;
+
+namespace Syzygy {
+
+namespace {
+
+const int TBPIECES = 7;
+
+enum TBFlag { STM = 1, Mapped = 2, WinPlies = 4, LossPlies = 8, Wide = 16, SingleValue = 128 };
+
+const quint8 WdlMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+const quint8 DtzMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+int MapPawns[SQUARE_NB];
+int MapB1H1H7[SQUARE_NB];
+int MapA1D1D4[SQUARE_NB];
+int MapKK[10][SQUARE_NB];
+int Binomial[6][SQUARE_NB];
+int LeadPawnIdx[6][SQUARE_NB];
+int LeadPawnsSize[6][4];
+
+typedef quint16 Sym;
+
+// 殘局庫檔案中的棋子編碼：白兵 1 … 白王 6，黑方再加 8
+inline int tbPiece(int piece)
+{
+    return (kindOf(piece) + 1) + (colorOf(piece) == BLACK ? 8 : 0);
+}
+
+inline int offA1H8(int sq)
+{
+    return rankOf(sq) - fileOf(sq);
+}
+
+inline bool pawnsComp(int a, int b)
+{
+    return MapPawns[a] < MapPawns[b];
+}
+
+template<typename T>
+inline T readLE(const void* p)
+{
+    return qFromLittleEndian<T>(p);
+}
+
+template<typename T>
+inline T readBE(const void* p)
+{
+    return qFromBigEndian<T>(p);
+}
+
+// 遞迴配對（Recursive Pairing）樹的節點：左右子符號各 12 位元
+struct LR {
+    quint8 lr[3];
+
+    Sym left() const { return Sym(((lr[1] & 0xF) << 8) | lr[0]); }
+    Sym right() const { return Sym((lr[2] << 4) | (lr[1] >> 4)); }
+};
+
+struct SparseEntry {
+    quint8 block[4];
+    quint8 offset[2];
+};
+
+// 一組解壓縮資料：無兵殘局每方一組，有兵殘局每方再依領先兵的檔案（a-d）各一組
+struct PairsData {
+    quint8 flags;
+    quint8 maxSymLen;
+    quint8 minSymLen;
+    quint32 numBlocks;
+    size_t blockSize;
+    size_t span;
+    const quint8* lowestSym;
+    const LR* btree;
+    const quint8* blockLength;
+    quint32 blockLengthSize;
+    const SparseEntry* sparseIndex;
+    size_t sparseIndexSize;
+    const quint8* data;
+    QVector<quint64> base64;
+    QVector<quint8> symlen;
+    int pieces[TBPIECES];
+    quint64 groupIdx[TBPIECES + 1];
+    int groupLen[TBPIECES + 1];
+    quint16 mapIdx[4];
+
+    PairsData()
+        : flags(0), maxSymLen(0), minSymLen(0), numBlocks(0), blockSize(0), span(0),
+          lowestSym(nullptr), btree(nullptr), blockLength(nullptr), blockLengthSize(0),
+          sparseIndex(nullptr), sparseIndexSize(0), data(nullptr)
+    {
+        for (int i = 0; i < TBPIECES; ++i) {
+            pieces[i] = 0;
+        }
+        for (int i = 0; i <= TBPIECES; ++i) {
+            groupIdx[i] = 0;
+            groupLen[i] = 0;
+        }
+        for (int i = 0; i < 4; ++i) {
+            mapIdx[i] = 0;
+        }
+    }
+};
+
+struct TBTable {
+    bool isDtz;
+    QString path;
+    QFile file;
+    std::atomic<bool> ready;
+    const quint8* base;
+    const quint8* dtzMap;
+    quint64 key;
+    quint64 key2;
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    quint8 pawnCount[2];  // [領先方 / 另一方]
+    PairsData items[2][4];
+
+    TBTable() : isDtz(false), ready(false), base(nullptr), dtzMap(nullptr), key(0), key2(0),
+        pieceCount(0), hasPawns(false), hasUniquePieces(false)
+    {
+        pawnCount[0] = pawnCount[1] = 0;
+    }
+
+    int sides() const { return isDtz ? 1 : 2; }
+    PairsData* get(int stm, int f) { return &items[stm % sides()][hasPawns ? f : 0]; }
+};
+
+struct TablePair {
+    TBTable* wdl;
+    TBTable* dtz;
+};
+
+QList<TBTable*> g_tables;
+QHash<quint64, TablePair> g_byKey;
+QStringList g_paths;
+int g_maxCardinality = 0;
+QMutex g_mapMutex;
+
+void initIndexTables()
+{
+    static bool done = false;
+    if (done) {
+        return;
+    }
+    Bitboards::init();
+
+    int code = 0;
+    for (int s = 0; s < SQUARE_NB; ++s) {
+        if (offA1H8(s) < 0) {
+            MapB1H1H7[s] = code++;
+        }
+    }
+
+    // a1-d1-d4 三角形：先編對角線以下的格子，對角線上的排在最後
+    QVector<int> diagonal;
+    code = 0;
+    const int triangle[] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+    for (int s : triangle) {
+        if (offA1H8(s) < 0) {
+            MapA1D1D4[s] = code++;
+        } else if (!offA1H8(s)) {
+            diagonal.append(s);
+        }
+    }
+    for (int s : diagonal) {
+        MapA1D1D4[s] = code++;
+    }
+
+    // 雙王的 462 種合法且不重複的擺法
+    QVector<QPair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; ++idx) {
+        for (int s1 = 0; s1 <= 27; ++s1) {
+            if (MapA1D1D4[s1] != idx || (!idx && s1 != 1)) {
+                continue;
+            }
+            for (int s2 = 0; s2 < SQUARE_NB; ++s2) {
+                if ((Bitboards::KingAttacks[s1] | squareBB(s1)) & squareBB(s2)) {
+                    continue;
+                }
+                if (!offA1H8(s1) && offA1H8(s2) > 0) {
+                    continue;
+                }
+                if (!offA1H8(s1) && !offA1H8(s2)) {
+                    bothOnDiagonal.append(qMakePair(idx, s2));
+                } else {
+                    MapKK[idx][s2] = code++;
+                }
+            }
+        }
+    }
+    for (const auto& p : bothOnDiagonal) {
+        MapKK[p.first][p.second] = code++;
+    }
+
+    Binomial[0][0] = 1;
+    for (int n = 1; n < 64; ++n) {
+        for (int k = 0; k < 6 && k <= n; ++k) {
+            Binomial[k][n] = (k > 0 ? Binomial[k - 1][n - 1] : 0)
+                           + (k < n ? Binomial[k][n - 1] : 0);
+        }
+    }
+
+    // 兵只能在 a2-h7；MapPawns 越大代表越靠邊、越低的兵（領先兵）
+    int availableSquares = 47;
+    for (int leadPawnsCnt = 1; leadPawnsCnt <= 5; ++leadPawnsCnt) {
+        for (int f = 0; f < 4; ++f) {
+            int idx = 0;
+            for (int r = 1; r <= 6; ++r) {
+                const int sq = makeSquare(f, r);
+                if (leadPawnsCnt == 1) {
+                    MapPawns[sq] = availableSquares--;
+                    MapPawns[sq ^ 7] = availableSquares--;
+                }
+                LeadPawnIdx[leadPawnsCnt][sq] = idx;
+                idx += Binomial[leadPawnsCnt - 1][MapPawns[sq]];
+            }
+            LeadPawnsSize[leadPawnsCnt][f] = idx;
+        }
+    }
+
+    done = true;
+}
+
+// 將 "KRPvKN" 這類檔名轉為各棋子數量；格式不對時回傳 false
+bool parseCode(const QString& code, int counts[PIECE_NB])
+{
+    for (int p = 0; p < PIECE_NB; ++p) {
+        counts[p] = 0;
+    }
+    const QStringList sides = code.split('v');
+    if (sides.size() != 2) {
+        return false;
+    }
+    const char kinds[] = "PNBRQK";
+    for (int c = 0; c < 2; ++c) {
+        if (!sides[c].startsWith('K')) {
+            return false;
+        }
+        for (QChar qc : sides[c]) {
+            const char* k = strchr(kinds, qc.toLatin1());
+            if (!k || !qc.toLatin1()) {
+                return false;
+            }
+            ++counts[makePiece(Color(c), PieceKind(k - kinds))];
+        }
+    }
+    return counts[makePiece(WHITE, KING)] == 1 && counts[makePiece(BLACK, KING)] == 1;
+}
+
+QString findFile(const QString& name)
+{
+    for (const QString& dir : g_paths) {
+        const QString path = QDir(dir).filePath(name);
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+void addTable(const QString& code, const QString& wdlPath)
+{
+    int counts[PIECE_NB];
+    if (!parseCode(code, counts)) {
+        return;
+    }
+
+    int swapped[PIECE_NB];
+    for (int k = 0; k < PIECE_KIND_NB; ++k) {
+        swapped[makePiece(WHITE, PieceKind(k))] = counts[makePiece(BLACK, PieceKind(k))];
+        swapped[makePiece(BLACK, PieceKind(k))] = counts[makePiece(WHITE, PieceKind(k))];
+    }
+
+    const quint64 key = Position::materialKeyOf(counts);
+    if (g_byKey.contains(key)) {
+        return;  // 同一張表出現在多個目錄
+    }
+
+    int total = 0;
+    bool unique = false;
+    for (int p = 0; p < PIECE_NB; ++p) {
+        total += counts[p];
+        if (kindOf(p) != KING && counts[p] == 1) {
+            unique = true;
+        }
+    }
+    if (total > TBPIECES) {
+        return;
+    }
+
+    const int whitePawns = counts[makePiece(WHITE, PAWN)];
+    const int blackPawns = counts[makePiece(BLACK, PAWN)];
+
+    TBTable* wdl = new TBTable;
+    wdl->path = wdlPath;
+    wdl->key = key;
+    wdl->key2 = Position::materialKeyOf(swapped);
+    wdl->pieceCount = total;
+    wdl->hasPawns = whitePawns + blackPawns > 0;
+    wdl->hasUniquePieces = unique;
+
+    // 領先方：兵較少的一方（壓縮效果較好），只有一方有兵時就是那一方
+    const bool whiteLeads = !blackPawns || (whitePawns && blackPawns >= whitePawns);
+    wdl->pawnCount[0] = quint8(whiteLeads ? whitePawns : blackPawns);
+    wdl->pawnCount[1] = quint8(whiteLeads ? blackPawns : whitePawns);
+
+    TBTable* dtz = new TBTable;
+    dtz->isDtz = true;
+    dtz->path = findFile(code + ".rtbz");
+    dtz->key = wdl->key;
+    dtz->key2 = wdl->key2;
+    dtz->pieceCount = wdl->pieceCount;
+    dtz->hasPawns = wdl->hasPawns;
+    dtz->hasUniquePieces = wdl->hasUniquePieces;
+    dtz->pawnCount[0] = wdl->pawnCount[0];
+    dtz->pawnCount[1] = wdl->pawnCount[1];
+
+    g_tables.append(wdl);
+    g_tables.append(dtz);
+    g_byKey.insert(wdl->key, TablePair{ wdl, dtz });
+    g_byKey.insert(wdl->key2, TablePair{ wdl, dtz });
+    g_maxCardinality = qMax(g_maxCardinality, total);
+}
+
+// 解碼：每個區塊以標準霍夫曼碼存放符號，每個符號再遞迴展開為多個 WDL/DTZ 值
+int decompressPairs(PairsData* d, quint64 idx)
+{
+    if (d->flags & SingleValue) {
+        return d->minSymLen;
+    }
+
+    // 稀疏索引每 span 個值記錄一次所在區塊與區塊內的位移
+    const quint32 k = quint32(idx / d->span);
+    quint32 block = readLE<quint32>(d->sparseIndex[k].block);
+    int offset = readLE<quint16>(d->sparseIndex[k].offset);
+
+    const int diff = int(idx % d->span) - int(d->span / 2);
+    offset += diff;
+
+    auto blockLength = [d](quint32 i) { return int(readLE<quint16>(d->blockLength + 2 * i)); };
+
+    while (offset < 0) {
+        offset += blockLength(--block) + 1;
+    }
+    while (offset > blockLength(block)) {
+        offset -= blockLength(block++) + 1;
+    }
+
+    const quint8* ptr = d->data + quint64(block) * d->blockSize;
+
+    quint64 buf64 = readBE<quint64>(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    Sym sym;
+
+    while (true) {
+        int len = 0;
+
+        while (buf64 < d->base64[len]) {
+            ++len;
+        }
+
+        sym = Sym((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+        sym += readLE<Sym>(d->lowestSym + 2 * len);
+
+        if (offset < d->symlen[sym] + 1) {
+            break;
+        }
+
+        offset -= d->symlen[sym] + 1;
+        len += d->minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= quint64(readBE<quint32>(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    while (d->symlen[sym]) {
+        const Sym left = d->btree[sym].left();
+        if (offset < d->symlen[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d->symlen[left] + 1;
+            sym = d->btree[sym].right();
+        }
+    }
+
+    return d->btree[sym].left();
+}
+
+bool checkDtzStm(TBTable* entry, int stm, int f)
+{
+    if (!entry->isDtz) {
+        return true;
+    }
+    const int flags = entry->get(stm, f)->flags;
+    return (flags & STM) == stm || (entry->key == entry->key2 && !entry->hasPawns);
+}
+
+int mapScore(TBTable* entry, int f, int value, WDLScore wdl)
+{
+    if (!entry->isDtz) {
+        return value - 2;
+    }
+
+    static const int WDLMap[] = { 1, 3, 0, 2, 0 };
+
+    PairsData* d = entry->get(0, f);
+    const int flags = d->flags;
+    const quint16* idx = d->mapIdx;
+
+    if (flags & Mapped) {
+        if (flags & Wide) {
+            value = readLE<quint16>(entry->dtzMap + 2 * (idx[WDLMap[wdl + 2]] + value));
+        } else {
+            value = entry->dtzMap[idx[WDLMap[wdl + 2]] + value];
+        }
+    }
+
+    // 表中可能以「回合」儲存，統一轉為半回合
+    if ((wdl == WDL_WIN && !(flags & WinPlies))
+        || (wdl == WDL_LOSS && !(flags & LossPlies))
+        || wdl == WDL_CURSED_WIN
+        || wdl == WDL_BLESSED_LOSS) {
+        value *= 2;
+    }
+
+    return value + 1;
+}
+
+int doProbeTable(const Position& pos, TBTable* entry, WDLScore wdl, ProbeState* result)
+{
+    int squares[TBPIECES];
+    int pieces[TBPIECES];
+    quint64 idx;
+    int next = 0;
+    int size = 0;
+    int leadPawnsCnt = 0;
+    Bitboard b;
+    Bitboard leadPawns = 0;
+    int tbFile = 0;
+
+    // 表格以「白方為強方」儲存；雙方子力相同時只存白方走棋的局面
+    const bool symmetricBlackToMove = entry->key == entry->key2 && pos.sideToMove() == BLACK;
+    const bool blackStronger = pos.materialKey() != entry->key;
+    const int flip = (symmetricBlackToMove || blackStronger) ? 1 : 0;
+    const int flipColor = flip * 8;
+    const int flipSquares = flip * 56;
+    const int stm = flip ^ int(pos.sideToMove());
+
+    if (entry->hasPawns) {
+        const int pc = entry->get(0, 0)->pieces[0] ^ flipColor;
+        leadPawns = b = pos.pieces(Color(pc >> 3), PAWN);
+        do {
+            squares[size++] = popLsb(b) ^ flipSquares;
+        } while (b);
+
+        leadPawnsCnt = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, pawnsComp));
+        tbFile = qMin(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    if (!checkDtzStm(entry, stm, tbFile)) {
+        *result = PROBE_CHANGE_STM;
+        return 0;
+    }
+
+    b = pos.pieces() ^ leadPawns;
+    do {
+        const int s = popLsb(b);
+        squares[size] = s ^ flipSquares;
+        pieces[size++] = tbPiece(pos.pieceOn(s)) ^ flipColor;
+    } while (b);
+
+    PairsData* d = entry->get(stm, tbFile);
+
+    // 依檔案指定的順序排列棋子
+    for (int i = leadPawnsCnt; i < size - 1; ++i) {
+        for (int j = i + 1; j < size; ++j) {
+            if (d->pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // 鏡射讓領先棋子位於 a-d 檔
+    if (fileOf(squares[0]) > 3) {
+        for (int i = 0; i < size; ++i) {
+            squares[i] ^= 7;
+        }
+    }
+
+    if (entry->hasPawns) {
+        idx = LeadPawnIdx[leadPawnsCnt][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCnt, pawnsComp);
+        for (int i = 1; i < leadPawnsCnt; ++i) {
+            idx += Binomial[i][MapPawns[squares[i]]];
+        }
+    } else {
+        // 無兵時再上下鏡射，讓領先棋子位於第 1-4 橫列
+        if (rankOf(squares[0]) > 3) {
+            for (int i = 0; i < size; ++i) {
+                squares[i] ^= 56;
+            }
+        }
+
+        // 第一個不在 a1-h8 對角線上的領先棋子必須位於對角線下方
+        for (int i = 0; i < d->groupLen[0]; ++i) {
+            if (!offA1H8(squares[i])) {
+                continue;
+            }
+            if (offA1H8(squares[i]) > 0) {
+                for (int j = i; j < size; ++j) {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        if (entry->hasUniquePieces) {
+            const int adjust1 = squares[1] > squares[0];
+            const int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (offA1H8(squares[0])) {
+                idx = (MapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62
+                    + squares[2] - adjust2;
+            } else if (offA1H8(squares[1])) {
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62
+                    + squares[2] - adjust2;
+            } else if (offA1H8(squares[2])) {
+                idx = 6 * 63 * 62 + 4 * 28 * 62
+                    + rankOf(squares[0]) * 7 * 28
+                    + (rankOf(squares[1]) - adjust1) * 28
+                    + MapB1H1H7[squares[2]];
+            } else {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+                    + rankOf(squares[0]) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6
+                    + (rankOf(squares[2]) - adjust2);
+            }
+        } else {
+            idx = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    idx *= d->groupIdx[0];
+    int* groupSq = squares + d->groupLen[0];
+
+    // 其餘的兵與棋子依組編碼，每組內依格子排序
+    bool remainingPawns = entry->hasPawns && entry->pawnCount[1];
+
+    while (d->groupLen[++next]) {
+        std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+        quint64 n = 0;
+
+        for (int i = 0; i < d->groupLen[next]; ++i) {
+            int adjust = 0;
+            for (int* s = squares; s < groupSq; ++s) {
+                if (groupSq[i] > *s) {
+                    ++adjust;
+                }
+            }
+            n += Binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+        }
+
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    return mapScore(entry, tbFile, decompressPairs(d, idx), wdl);
+}
+
+void setGroups(TBTable* e, PairsData* d, const int order[2], int f)
+{
+    int n = 0;
+    int firstLen = e->hasPawns ? 0 : e->hasUniquePieces ? 3 : 2;
+    d->groupLen[n] = 1;
+
+    for (int i = 1; i < e->pieceCount; ++i) {
+        if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1]) {
+            d->groupLen[n]++;
+        } else {
+            d->groupLen[++n] = 1;
+        }
+    }
+    d->groupLen[++n] = 0;
+
+    const bool pp = e->hasPawns && e->pawnCount[1];
+    int nextGroup = pp ? 2 : 1;
+    int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+    quint64 idx = 1;
+
+    for (int k = 0; nextGroup < n || k == order[0] || k == order[1]; ++k) {
+        if (k == order[0]) {
+            d->groupIdx[0] = idx;
+            idx *= e->hasPawns ? LeadPawnsSize[d->groupLen[0]][f]
+                 : e->hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d->groupIdx[1] = idx;
+            idx *= Binomial[d->groupLen[1]][48 - d->groupLen[0]];
+        } else {
+            d->groupIdx[nextGroup] = idx;
+            idx *= Binomial[d->groupLen[nextGroup]][freeSquares];
+            freeSquares -= d->groupLen[nextGroup++];
+        }
+    }
+
+    d->groupIdx[n] = idx;
+}
+
+quint8 setSymlen(PairsData* d, Sym s, QVector<bool>& visited)
+{
+    visited[s] = true;
+    const Sym sr = d->btree[s].right();
+    if (sr == 0xFFF) {
+        return 0;
+    }
+
+    const Sym sl = d->btree[s].left();
+    if (!visited[sl]) {
+        d->symlen[sl] = setSymlen(d, sl, visited);
+    }
+    if (!visited[sr]) {
+        d->symlen[sr] = setSymlen(d, sr, visited);
+    }
+    return quint8(d->symlen[sl] + d->symlen[sr] + 1);
+}
+
+const quint8* setSizes(PairsData* d, const quint8* data)
+{
+    d->flags = *data++;
+
+    if (d->flags & SingleValue) {
+        d->numBlocks = 0;
+        d->span = 0;
+        d->blockLengthSize = 0;
+        d->sparseIndexSize = 0;
+        d->minSymLen = *data++;  // 唯一的值
+        return data;
+    }
+
+    int groups = 0;
+    while (groups < TBPIECES && d->groupLen[groups]) {
+        ++groups;
+    }
+    const quint64 tbSize = d->groupIdx[groups];
+
+    d->blockSize = size_t(1) << *data++;
+    d->span = size_t(1) << *data++;
+    d->sparseIndexSize = size_t((tbSize + d->span - 1) / d->span);
+    const int padding = *data++;
+    d->numBlocks = readLE<quint32>(data);
+    data += sizeof(quint32);
+    d->blockLengthSize = d->numBlocks + padding;
+    d->maxSymLen = *data++;
+    d->minSymLen = *data++;
+    d->lowestSym = data;
+    d->base64.resize(d->maxSymLen - d->minSymLen + 1);
+
+    // 標準霍夫曼碼：越長的碼數值越小，依此算出每種長度左對齊到 64 位元的下界
+    d->base64[d->base64.size() - 1] = 0;
+    for (int i = d->base64.size() - 2; i >= 0; --i) {
+        d->base64[i] = (d->base64[i + 1] + readLE<Sym>(d->lowestSym + 2 * i)
+                        - readLE<Sym>(d->lowestSym + 2 * (i + 1))) / 2;
+    }
+    for (int i = 0; i < d->base64.size(); ++i) {
+        d->base64[i] <<= 64 - i - d->minSymLen;
+    }
+
+    data += d->base64.size() * sizeof(Sym);
+    d->symlen.resize(readLE<quint16>(data));
+    data += sizeof(quint16);
+    d->btree = reinterpret_cast<const LR*>(data);
+
+    QVector<bool> visited(d->symlen.size(), false);
+    for (int sym = 0; sym < d->symlen.size(); ++sym) {
+        if (!visited[sym]) {
+            d->symlen[sym] = setSymlen(d, Sym(sym), visited);
+        }
+    }
+
+    return data + d->symlen.size() * sizeof(LR) + (d->symlen.size() & 1);
+}
+
+const quint8* setDtzMap(TBTable* e, const quint8* data, int maxFile)
+{
+    e->dtzMap = data;
+
+    for (int f = 0; f <= maxFile; ++f) {
+        PairsData* d = e->get(0, f);
+        if (!(d->flags & Mapped)) {
+            continue;
+        }
+        if (d->flags & Wide) {
+            data += quintptr(data) & 1;
+            for (int i = 0; i < 4; ++i) {
+                d->mapIdx[i] = quint16((data - e->dtzMap) / 2 + 1);
+                data += 2 * readLE<quint16>(data) + 2;
+            }
+        } else {
+            for (int i = 0; i < 4; ++i) {
+                d->mapIdx[i] = quint16(data - e->dtzMap + 1);
+                data += *data + 1;
+            }
+        }
+    }
+
+    return data + (quintptr(data) & 1);
+}
+
+void setup(TBTable* e, const quint8* data)
+{
+    data++;  // 旗標位元組
+
+    const int sides = (!e->isDtz && e->key != e->key2) ? 2 : 1;
+    const int maxFile = e->hasPawns ? 3 : 0;
+    const bool pp = e->hasPawns && e->pawnCount[1];
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            *e->get(i, f) = PairsData();
+        }
+
+        const int order[2][2] = {
+            { *data & 0xF, pp ? *(data + 1) & 0xF : 0xF },
+            { *data >> 4, pp ? *(data + 1) >> 4 : 0xF }
+        };
+        data += 1 + pp;
+
+        for (int k = 0; k < e->pieceCount; ++k, ++data) {
+            for (int i = 0; i < sides; ++i) {
+                e->get(i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+            }
+        }
+
+        for (int i = 0; i < sides; ++i) {
+            setGroups(e, e->get(i, f), order[i], f);
+        }
+    }
+
+    data += quintptr(data) & 1;
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            data = setSizes(e->get(i, f), data);
+        }
+    }
+
+    if (e->isDtz) {
+        data = setDtzMap(e, data, maxFile);
+    }
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData* d = e->get(i, f);
+            d->sparseIndex = reinterpret_cast<const SparseEntry*>(data);
+            data += d->sparseIndexSize * sizeof(SparseEntry);
+        }
+    }
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData* d = e->get(i, f);
+            d->blockLength = data;
+            data += d->blockLengthSize * sizeof(quint16);
+        }
+    }
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            data = reinterpret_cast<const quint8*>((quintptr(data) + 0x3F) & ~quintptr(0x3F));
+            PairsData* d = e->get(i, f);
+            d->data = data;
+            data += quint64(d->numBlocks) * d->blockSize;
+        }
+    }
+}
+
+// 第一次使用時才映射檔案；可由多個搜尋執行緒同時呼叫
+bool mapped(TBTable* e)
+{
+    if (e->ready.load(std::memory_order_acquire)) {
+        return e->base != nullptr;
+    }
+
+    QMutexLocker locker(&g_mapMutex);
+    if (e->ready.load(std::memory_order_relaxed)) {
+        return e->base != nullptr;
+    }
+
+    if (!e->path.isEmpty()) {
+        e->file.setFileName(e->path);
+        if (e->file.open(QIODevice::ReadOnly)) {
+            const qint64 size = e->file.size();
+            uchar* data = (size % 64 == 16) ? e->file.map(0, size) : nullptr;
+            if (data && !memcmp(data, e->isDtz ? DtzMagic : WdlMagic, 4)) {
+                e->base = data;
+                setup(e, data + 4);
+            } else {
+                qWarning("Corrupt tablebase file %s", qPrintable(e->path));
+                e->file.close();
+            }
+        }
+    }
+
+    e->ready.store(true, std::memory_order_release);
+    return e->base != nullptr;
+}
+
+int probeTable(const Position& pos, bool dtz, ProbeState* result, WDLScore wdl = WDL_DRAW)
+{
+    if (pos.pieceCount() == 2) {
+        return WDL_DRAW;  // 雙王
+    }
+
+    const auto it = g_byKey.constFind(pos.materialKey());
+    if (it == g_byKey.constEnd()) {
+        *result = PROBE_FAIL;
+        return 0;
+    }
+
+    TBTable* entry = dtz ? it->dtz : it->wdl;
+    if (!mapped(entry)) {
+        *result = PROBE_FAIL;
+        return 0;
+    }
+
+    return doProbeTable(pos, entry, wdl, result);
+}
+
+int dtzBeforeZeroing(WDLScore wdl)
+{
+    return wdl == WDL_WIN ? 1
+         : wdl == WDL_CURSED_WIN ? 101
+         : wdl == WDL_BLESSED_LOSS ? -101
+         : wdl == WDL_LOSS ? -1 : 0;
+}
+
+inline int signOf(int v)
+{
+    return (0 < v) - (v < 0);
+}
+
+// 表中不儲存「可以吃子取勝」的局面的正確值，因此先搜尋吃子（及兵步）再查表取較佳者
+WDLScore search(Position& pos, ProbeState* result, bool checkZeroingMoves)
+{
+    WDLScore value;
+    WDLScore bestValue = WDL_LOSS;
+
+    MoveList moves;
+    pos.generateLegal(moves);
+    int moveCount = 0;
+
+    for (int i = 0; i < moves.size; ++i) {
+        const Move m = moves.moves[i];
+        if (!pos.isCapture(m) && (!checkZeroingMoves || kindOf(pos.movedPiece(m)) != PAWN)) {
+            continue;
+        }
+
+        ++moveCount;
+
+        pos.doMove(m);
+        value = WDLScore(-search(pos, result, false));
+        pos.undoMove();
+
+        if (*result == PROBE_FAIL) {
+            return WDL_DRAW;
+        }
+
+        if (value > bestValue) {
+            bestValue = value;
+            if (value >= WDL_WIN) {
+                *result = PROBE_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    const bool noMoreMoves = moveCount && moveCount == moves.size;
+
+    if (noMoreMoves) {
+        value = bestValue;
+    } else {
+        value = WDLScore(probeTable(pos, false, result));
+        if (*result == PROBE_FAIL) {
+            return WDL_DRAW;
+        }
+    }
+
+    if (bestValue >= value) {
+        *result = (bestValue > WDL_DRAW || noMoreMoves) ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+        return bestValue;
+    }
+
+    *result = PROBE_OK;
+    return value;
+}
+
+}
+
+int init(const QString& paths)
+{
+    qDeleteAll(g_tables);
+    g_tables.clear();
+    g_byKey.clear();
+    g_maxCardinality = 0;
+
+    g_paths = paths.split(QDir::listSeparator(), Qt::SkipEmptyParts);
+    if (g_paths.isEmpty()) {
+        return 0;
+    }
+
+    initIndexTables();
+
+    int found = 0;
+    for (const QString& dir : g_paths) {
+        const QStringList files = QDir(dir).entryList(QStringList() << "*.rtbw", QDir::Files);
+        for (const QString& name : files) {
+            const int before = g_byKey.size();
+            addTable(name.left(name.length() - 5), QDir(dir).filePath(name));
+            if (g_byKey.size() != before) {
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+int maxCardinality()
+{
+    return g_maxCardinality;
+}
+
+bool canProbe(const Position& pos)
+{
+    return g_maxCardinality > 0
+        && pos.pieceCount() <= g_maxCardinality
+        && !pos.castlingRights();
+}
+
+WDLScore probeWdl(Position& pos, ProbeState* result)
+{
+    *result = PROBE_OK;
+    return search(pos, result, false);
+}
+
+int probeDtz(Position& pos, ProbeState* result)
+{
+    *result = PROBE_OK;
+    const WDLScore wdl = search(pos, result, true);
+
+    if (*result == PROBE_FAIL || wdl == WDL_DRAW) {
+        return 0;  // DTZ 表不儲存和棋
+    }
+
+    if (*result == PROBE_ZEROING_BEST_MOVE) {
+        return dtzBeforeZeroing(wdl);
+    }
+
+    int dtz = probeTable(pos, true, result, wdl);
+    if (*result == PROBE_FAIL) {
+        return 0;
+    }
+
+    if (*result != PROBE_CHANGE_STM) {
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+    }
+
+    // 表中只有對方走棋的資料：做一層搜尋，取對我方最有利的 DTZ
+    int minDtz = 0xFFFF;
+    MoveList moves;
+    pos.generateLegal(moves);
+
+    for (int i = 0; i < moves.size; ++i) {
+        const Move m = moves.moves[i];
+        const bool zeroing = pos.isZeroing(m);
+
+        pos.doMove(m);
+
+        dtz = zeroing ? -dtzBeforeZeroing(search(pos, result, false))
+                      : -probeDtz(pos, result);
+
+        if (dtz == 1 && pos.inCheck()) {
+            MoveList replies;
+            pos.generateLegal(replies);
+            if (replies.size == 0) {
+                minDtz = 1;  // 將死
+            }
+        }
+
+        if (!zeroing) {
+            dtz += signOf(dtz);
+        }
+
+        if (dtz < minDtz && signOf(dtz) == signOf(wdl)) {
+            minDtz = dtz;
+        }
+
+        pos.undoMove();
+
+        if (*result == PROBE_FAIL) {
+            return 0;
+        }
+    }
+
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+Move probeRoot(Position& pos, WDLScore* wdlOut, int* dtzOut)
+{
+    if (!canProbe(pos)) {
+        return MOVE_NONE;
+    }
+
+    MoveList moves;
+    pos.generateLegal(moves);
+    if (moves.size == 0) {
+        return MOVE_NONE;
+    }
+
+    const int cnt50 = pos.rule50();
+    Move bestMove = MOVE_NONE;
+    int bestRank = 0;
+    int bestDtz = 0;
+
+    for (int i = 0; i < moves.size; ++i) {
+        const Move m = moves.moves[i];
+        ProbeState result = PROBE_OK;
+        int dtz;
+
+        pos.doMove(m);
+
+        if (pos.rule50() == 0) {
+            // 吃子或兵步後重新計算：只需 WDL
+            dtz = dtzBeforeZeroing(WDLScore(-probeWdl(pos, &result)));
+        } else {
+            dtz = -probeDtz(pos, &result);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+
+        if (dtz == 2 && pos.inCheck()) {
+            MoveList replies;
+            pos.generateLegal(replies);
+            if (replies.size == 0) {
+                dtz = 1;
+            }
+        }
+
+        pos.undoMove();
+
+        if (result == PROBE_FAIL) {
+            return MOVE_NONE;
+        }
+
+        // 在五十步內可以贏的步最好；會超過五十步的勝利次之；和棋；能撐過五十步的敗局優於直接輸
+        const int rank = dtz > 0 ? (dtz + cnt50 <= 99 ? 1000 : 1000 - (dtz + cnt50))
+                       : dtz < 0 ? (-dtz * 2 + cnt50 < 100 ? -1000 : -1000 + (-dtz + cnt50))
+                       : 0;
+
+        // 同等級時，贏棋取 DTZ 最短，輸棋取 DTZ 最長
+        const bool better = bestMove == MOVE_NONE
+                         || rank > bestRank
+                         || (rank == bestRank && dtz > 0 && dtz < bestDtz)
+                         || (rank == bestRank && dtz < 0 && dtz < bestDtz);
+        if (better) {
+            bestMove = m;
+            bestRank = rank;
+            bestDtz = dtz;
+        }
+    }
+
+    if (wdlOut) {
+        *wdlOut = bestRank >= 1000 ? WDL_WIN
+                : bestRank > 0 ? WDL_CURSED_WIN
+                : bestRank == 0 ? WDL_DRAW
+                : bestRank > -1000 ? WDL_BLESSED_LOSS
+                : WDL_LOSS;
+    }
+    if (dtzOut) {
+        *dtzOut = bestDtz;
+    }
+    return bestMove;
+}
+
+}
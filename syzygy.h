@@ -0,0 +1,49 @@
+#ifndef SYZYGY_H
+#define SYZYGY_H
+
+#include "position.h"
+#include <QString>
+
+// Syzygy 殘局庫（.rtbw / .rtbz）查詢
+// 檔案以記憶體映射方式在第一次使用時載入，之後的查詢不需額外配置記憶體，可多執行緒同時呼叫
+namespace Syzygy {
+
+// 從輪走方角度的勝和負；CURSED_WIN / BLESSED_LOSS 表示受五十步規則影響而實際為和棋
+enum WDLScore {
+    WDL_LOSS = -2,
+    WDL_BLESSED_LOSS = -1,
+    WDL_DRAW = 0,
+    WDL_CURSED_WIN = 1,
+    WDL_WIN = 2
+};
+
+enum ProbeState {
+    PROBE_FAIL = 0,                // 缺少對應的殘局庫檔案
+    PROBE_OK = 1,
+    PROBE_CHANGE_STM = -1,         // DTZ 表只存另一方走棋的局面
+    PROBE_ZEROING_BEST_MOVE = 2    // 最佳著法是吃子或兵步
+};
+
+// 掃描目錄中的殘局庫檔案；多個目錄以 ';'（Windows）或 ':' 分隔。回傳找到的 WDL 表數
+// 會釋放之前的表格：呼叫前所有可能查詢的搜尋執行緒都必須已經結束
+int init(const QString& paths);
+
+// 已載入的殘局庫中最多的棋子數（含雙王），0 表示沒有任何殘局庫
+int maxCardinality();
+
+// 局面是否在殘局庫範圍內（棋子數足夠少且沒有易位權）
+bool canProbe(const Engine::Position& pos);
+
+// 查詢勝和負，不考慮五十步計數；*result 為 PROBE_FAIL 時回傳值無意義
+WDLScore probeWdl(Engine::Position& pos, ProbeState* result);
+
+// 查詢距離歸零步數（DTZ，以半回合計），正負號與 WDL 一致
+int probeDtz(Engine::Position& pos, ProbeState* result);
+
+// 根節點：依 DTZ 與目前的五十步計數為每一步排序，回傳最佳著法
+// 失敗（缺檔或超出範圍）時回傳 MOVE_NONE
+Engine::Move probeRoot(Engine::Position& pos, WDLScore* wdl = nullptr, int* dtz = nullptr);
+
+}
+
+#endif // SYZYGY_H
@@ -0,0 +1,430 @@
+#include "bookbuilder.h"
+#include "polyglot.h"
+#include <QDir>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+namespace {
+
+// 暫存段中每筆資料的大小：key 8、move 2、games 4、score 4
+const int RECORD_SIZE = 18;
+
+// 每筆彙總資料在 QHash 中的估計成本（含節點額外開銷）
+const int TABLE_BYTES_PER_ENTRY = 64;
+
+// 一次合併最多開啟的暫存段數量
+const int MAX_MERGE_FAN_IN = 64;
+
+bool writeRecord(QIODevice* device, const BookRecord& record)
+{
+    uchar buffer[RECORD_SIZE];
+    qToBigEndian(record.key, buffer);
+    qToBigEndian(record.move, buffer + 8);
+    qToBigEndian(record.games, buffer + 10);
+    qToBigEndian(record.score, buffer + 14);
+    return device->write(reinterpret_cast<const char*>(buffer), RECORD_SIZE) == RECORD_SIZE;
+}
+
+bool readRecord(QIODevice* device, BookRecord& record)
+{
+    uchar buffer[RECORD_SIZE];
+    if (device->read(reinterpret_cast<char*>(buffer), RECORD_SIZE) != RECORD_SIZE) {
+        return false;
+    }
+    record.key = qFromBigEndian<quint64>(buffer);
+    record.move = qFromBigEndian<quint16>(buffer + 8);
+    record.games = qFromBigEndian<quint32>(buffer + 10);
+    record.score = qFromBigEndian<quint32>(buffer + 14);
+    return true;
+}
+
+bool recordLess(const BookRecord& a, const BookRecord& b)
+{
+    return a.key < b.key || (a.key == b.key && a.move < b.move);
+}
+
+}
+
+BookBuilder::BookBuilder(const BookBuilderOptions& options)
+    : m_options(options),
+      m_tableCapacity(static_cast<int>(qBound<qint64>(1024, options.memoryBytes / TABLE_BYTES_PER_ENTRY, 1 << 28))),
+      m_gamesRead(0),
+      m_gamesUsed(0),
+      m_positionsAdded(0),
+      m_entriesWritten(0)
+{
+    if (m_options.tempDir.isEmpty()) {
+        m_options.tempDir = QDir::tempPath();
+    }
+    m_table.reserve(m_tableCapacity);
+}
+
+BookBuilder::~BookBuilder()
+{
+    qDeleteAll(m_runs);
+}
+
+bool BookBuilder::addPgnFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("Cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    PgnReader reader(&file);
+    PgnGame game;
+    while (reader.readGame(game)) {
+        ++m_gamesRead;
+        addGame(game);
+
+        if (m_table.size() >= m_tableCapacity && !spill()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BookBuilder::addGame(const PgnGame& game)
+{
+    // 以白方觀點的得分（半分）
+    int whiteScore;
+    if (game.result == "1-0") {
+        whiteScore = 2;
+    } else if (game.result == "0-1") {
+        whiteScore = 0;
+    } else if (game.result == "1/2-1/2") {
+        whiteScore = 1;
+    } else {
+        return;  // 未完成的對局不列入統計
+    }
+
+    // ChessBoard 只能從標準初始局面重播
+    if (game.tags.contains("FEN") || game.tags.value("SetUp") == "1") {
+        return;
+    }
+    QByteArray variant = game.tags.value("Variant").toLower();
+    if (!variant.isEmpty() && variant != "standard") {
+        return;
+    }
+
+    m_board.reset();
+    int ply = 0;
+    for (const QByteArray& san : game.moves) {
+        if (ply >= m_options.maxPly) {
+            break;
+        }
+
+        quint64 key = Polyglot::hashBoard(m_board);
+        PieceColor mover = m_board.getCurrentTurn();
+        if (!applySan(san)) {
+            break;  // 無法解析的著法：捨棄本局其餘部分
+        }
+
+        quint16 move = Polyglot::encodeMove(m_board.getMoveHistory().last());
+        Stats& stats = m_table[qMakePair(key, move)];
+        stats.games += 1;
+        stats.score += (mover == PieceColor::WHITE) ? whiteScore : 2 - whiteScore;
+        ++m_positionsAdded;
+        ++ply;
+    }
+
+    if (ply > 0) {
+        ++m_gamesUsed;
+    }
+}
+
+bool BookBuilder::applySan(const QByteArray& san)
+{
+    QByteArray s = san;
+    while (!s.isEmpty() && (s.endsWith('+') || s.endsWith('#') || s.endsWith('!') || s.endsWith('?'))) {
+        s.chop(1);
+    }
+
+    PieceColor color = m_board.getCurrentTurn();
+    int homeRow = (color == PieceColor::WHITE) ? 7 : 0;
+    if (s == "O-O" || s == "0-0") {
+        return m_board.movePiece(QPoint(4, homeRow), QPoint(6, homeRow));
+    }
+    if (s == "O-O-O" || s == "0-0-0") {
+        return m_board.movePiece(QPoint(4, homeRow), QPoint(2, homeRow));
+    }
+
+    // 升變：e8=Q 或 e8Q
+    bool hasPromotion = false;
+    PieceType promotion = PieceType::QUEEN;
+    int equals = s.indexOf('=');
+    char promotionChar = 0;
+    if (equals >= 0 && equals + 1 < s.size()) {
+        promotionChar = s[equals + 1];
+        s.truncate(equals);
+    } else if (s.size() >= 3 && s[s.size() - 2] >= '1' && s[s.size() - 2] <= '8' &&
+               QByteArray("NBRQnbrq").contains(s[s.size() - 1])) {
+        promotionChar = s[s.size() - 1];
+        s.chop(1);
+    }
+    if (promotionChar) {
+        hasPromotion = true;
+        switch (promotionChar) {
+        case 'N': case 'n': promotion = PieceType::KNIGHT; break;
+        case 'B': case 'b': promotion = PieceType::BISHOP; break;
+        case 'R': case 'r': promotion = PieceType::ROOK; break;
+        default:            promotion = PieceType::QUEEN; break;
+        }
+    }
+
+    PieceType type = PieceType::PAWN;
+    int start = 1;
+    switch (s.isEmpty() ? 0 : s[0]) {
+    case 'N': type = PieceType::KNIGHT; break;
+    case 'B': type = PieceType::BISHOP; break;
+    case 'R': type = PieceType::ROOK; break;
+    case 'Q': type = PieceType::QUEEN; break;
+    case 'K': type = PieceType::KING; break;
+    default:  start = 0; break;
+    }
+    if (s.size() - start < 2) {
+        return false;
+    }
+
+    int toFile = s[s.size() - 2] - 'a';
+    int toRank = s[s.size() - 1] - '1';
+    if (toFile < 0 || toFile > 7 || toRank < 0 || toRank > 7) {
+        return false;
+    }
+    QPoint to(toFile, 7 - toRank);
+
+    // 消歧義的起始直行/橫列
+    int fromFile = -1;
+    int fromRank = -1;
+    for (int i = start; i < s.size() - 2; ++i) {
+        char c = s[i];
+        if (c >= 'a' && c <= 'h') {
+            fromFile = c - 'a';
+        } else if (c >= '1' && c <= '8') {
+            fromRank = c - '1';
+        } else if (c != 'x' && c != '-') {
+            return false;
+        }
+    }
+
+    QPoint from(-1, -1);
+    for (int row = 0; row < 8; ++row) {
+        if (fromRank >= 0 && 7 - row != fromRank) continue;
+        for (int col = 0; col < 8; ++col) {
+            if (fromFile >= 0 && col != fromFile) continue;
+            ChessPiece* piece = m_board.getPieceAt(row, col);
+            if (!piece || piece->getType() != type || piece->getColor() != color) continue;
+
+            QPoint candidate(col, row);
+            if (m_board.canMove(candidate, to)) {
+                if (from.x() >= 0) {
+                    return false;  // 不合法的歧義著法
+                }
+                from = candidate;
+            }
+        }
+    }
+    if (from.x() < 0) {
+        return false;
+    }
+
+    if (hasPromotion) {
+        if (!m_board.wouldBePromotion(from, to)) {
+            return false;
+        }
+        m_board.setPromotionPieceType(promotion);
+    }
+    return m_board.movePiece(from, to);
+}
+
+QTemporaryFile* BookBuilder::createRun()
+{
+    QTemporaryFile* run = new QTemporaryFile(QDir(m_options.tempDir).filePath("bookbuilder-XXXXXX.run"));
+    if (!run->open()) {
+        m_errorString = QString("Cannot create temporary file in %1: %2").arg(m_options.tempDir, run->errorString());
+        delete run;
+        return nullptr;
+    }
+    return run;
+}
+
+bool BookBuilder::spill()
+{
+    if (m_table.isEmpty()) {
+        return true;
+    }
+
+    QVector<BookRecord> records;
+    records.reserve(m_table.size());
+    for (auto it = m_table.constBegin(); it != m_table.constEnd(); ++it) {
+        BookRecord record;
+        record.key = it.key().first;
+        record.move = it.key().second;
+        record.games = it.value().games;
+        record.score = it.value().score;
+        records.append(record);
+    }
+    m_table.clear();
+    m_table.reserve(m_tableCapacity);
+
+    std::sort(records.begin(), records.end(), recordLess);
+
+    QTemporaryFile* run = createRun();
+    if (!run) {
+        return false;
+    }
+    for (const BookRecord& record : records) {
+        if (!writeRecord(run, record)) {
+            m_errorString = QString("Cannot write temporary file: %1").arg(run->errorString());
+            delete run;
+            return false;
+        }
+    }
+    run->flush();
+    m_runs.append(run);
+    return true;
+}
+
+bool BookBuilder::writeBook(const QString& path)
+{
+    if (!spill()) {
+        return false;
+    }
+
+    // 暫存段太多時分批預先合併，避免同時開啟過多檔案
+    while (m_runs.size() > MAX_MERGE_FAN_IN) {
+        QList<QTemporaryFile*> merged;
+        for (int i = 0; i < m_runs.size(); i += MAX_MERGE_FAN_IN) {
+            QList<QTemporaryFile*> group = m_runs.mid(i, MAX_MERGE_FAN_IN);
+            if (group.size() == 1) {
+                merged.append(group.first());
+                continue;
+            }
+            QTemporaryFile* output = createRun();
+            if (!output || !mergeRuns(group, output, false)) {
+                delete output;
+                return false;
+            }
+            output->flush();
+            qDeleteAll(group);
+            merged.append(output);
+        }
+        m_runs = merged;
+    }
+
+    QFile book(path);
+    if (!book.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_errorString = QString("Cannot open %1: %2").arg(path, book.errorString());
+        return false;
+    }
+    m_entriesWritten = 0;
+    bool ok = mergeRuns(m_runs, &book, true);
+    book.close();
+    return ok;
+}
+
+bool BookBuilder::mergeRuns(const QList<QTemporaryFile*>& inputs, QIODevice* output, bool writeBookEntries)
+{
+    struct Head {
+        BookRecord record;
+        int run;
+    };
+    auto greater = [](const Head& a, const Head& b) { return recordLess(b.record, a.record); };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heap(greater);
+
+    for (int i = 0; i < inputs.size(); ++i) {
+        inputs[i]->seek(0);
+        Head head;
+        head.run = i;
+        if (readRecord(inputs[i], head.record)) {
+            heap.push(head);
+        }
+    }
+
+    QVector<BookRecord> position;
+    auto emitRecord = [&](const BookRecord& record) {
+        if (!writeBookEntries) {
+            if (!writeRecord(output, record)) {
+                m_errorString = QString("Cannot write temporary file: %1").arg(output->errorString());
+                return false;
+            }
+            return true;
+        }
+        if (!position.isEmpty() && position.first().key != record.key && !flushPosition(position, output)) {
+            return false;
+        }
+        position.append(record);
+        return true;
+    };
+
+    bool hasCurrent = false;
+    BookRecord current = BookRecord();
+    while (!heap.empty()) {
+        Head head = heap.top();
+        heap.pop();
+
+        Head next;
+        next.run = head.run;
+        if (readRecord(inputs[head.run], next.record)) {
+            heap.push(next);
+        }
+
+        // 不同暫存段中的同一組 (局面, 著法) 相鄰出現，直接累加
+        if (hasCurrent && current.key == head.record.key && current.move == head.record.move) {
+            current.games += head.record.games;
+            current.score += head.record.score;
+            continue;
+        }
+        if (hasCurrent && !emitRecord(current)) {
+            return false;
+        }
+        current = head.record;
+        hasCurrent = true;
+    }
+
+    if (hasCurrent && !emitRecord(current)) {
+        return false;
+    }
+    if (writeBookEntries && !position.isEmpty()) {
+        return flushPosition(position, output);
+    }
+    return true;
+}
+
+bool BookBuilder::flushPosition(QVector<BookRecord>& moves, QIODevice* output)
+{
+    QVector<BookRecord> kept;
+    quint32 maxScore = 0;
+    for (const BookRecord& record : moves) {
+        if (record.games >= static_cast<quint32>(m_options.minGames) && record.score > 0) {
+            kept.append(record);
+            maxScore = qMax(maxScore, record.score);
+        }
+    }
+    moves.clear();
+
+    // 同一局面中權重高的著法排在前面
+    std::sort(kept.begin(), kept.end(), [](const BookRecord& a, const BookRecord& b) {
+        return a.score > b.score;
+    });
+
+    for (const BookRecord& record : kept) {
+        PolyglotEntry entry;
+        entry.key = record.key;
+        entry.move = record.move;
+        // 權重只有 16 位元，超出時依同局面最大值等比例縮放
+        entry.weight = static_cast<quint16>(maxScore > 0xFFFF
+            ? qMax<quint64>(1, static_cast<quint64>(record.score) * 0xFFFF / maxScore)
+            : record.score);
+        if (!Polyglot::writeEntry(output, entry)) {
+            m_errorString = QString("Cannot write book: %1").arg(output->errorString());
+            return false;
+        }
+        ++m_entriesWritten;
+    }
+    return true;
+}
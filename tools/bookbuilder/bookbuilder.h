@@ -0,0 +1,73 @@
+#ifndef BOOKBUILDER_H
+#define BOOKBUILDER_H
+
+#include "chessboard.h"
+#include "pgnreader.h"
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+
+struct BookBuilderOptions {
+    int maxPly;          // 只統計前 N 個半回合
+    int minGames;        // 一步棋至少出現在幾局中才寫入開局庫
+    qint64 memoryBytes;  // 記憶體內彙總表的上限，超過時排序後寫出暫存段
+    QString tempDir;
+
+    BookBuilderOptions() : maxPly(24), minGames(3), memoryBytes(256LL * 1024 * 1024) {}
+};
+
+// 局面 + 著法的彙總資料；score 以半分計（勝 2、和 1、負 0）
+struct BookRecord {
+    quint64 key;
+    quint16 move;
+    quint32 games;
+    quint32 score;
+};
+
+// 從 PGN 串流建立 Polyglot 開局庫：
+// 對局透過 ChessBoard 重播，彙總表滿了就排序寫成暫存段，最後以多路合併輸出
+class BookBuilder {
+public:
+    explicit BookBuilder(const BookBuilderOptions& options);
+    ~BookBuilder();
+
+    bool addPgnFile(const QString& path);
+    bool writeBook(const QString& path);
+
+    QString errorString() const { return m_errorString; }
+    qint64 gamesRead() const { return m_gamesRead; }
+    qint64 gamesUsed() const { return m_gamesUsed; }
+    qint64 positionsAdded() const { return m_positionsAdded; }
+    qint64 entriesWritten() const { return m_entriesWritten; }
+
+private:
+    struct Stats {
+        quint32 games;
+        quint32 score;
+        Stats() : games(0), score(0) {}
+    };
+
+    BookBuilderOptions m_options;
+    ChessBoard m_board;
+    QHash<QPair<quint64, quint16>, Stats> m_table;
+    int m_tableCapacity;
+    QList<QTemporaryFile*> m_runs;
+    QString m_errorString;
+
+    qint64 m_gamesRead;
+    qint64 m_gamesUsed;
+    qint64 m_positionsAdded;
+    qint64 m_entriesWritten;
+
+    void addGame(const PgnGame& game);
+    bool applySan(const QByteArray& san);
+    bool spill();
+    QTemporaryFile* createRun();
+    bool mergeRuns(const QList<QTemporaryFile*>& inputs, QIODevice* output, bool writeBookEntries);
+    bool flushPosition(QVector<BookRecord>& moves, QIODevice* output);
+};
+
+#endif // BOOKBUILDER_H
@@ -0,0 +1,29 @@
+QT       += core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bookbuilder
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    bookbuilder.cpp \
+    pgnreader.cpp \
+    ../../chessboard.cpp \
+    ../../chesspiece.cpp \
+    ../../bitboard.cpp \
+    ../../position.cpp \
+    ../../polyglot.cpp
+
+HEADERS += \
+    bookbuilder.h \
+    pgnreader.h \
+    ../../chessboard.h \
+    ../../chesspiece.h \
+    ../../bitboard.h \
+    ../../position.h \
+    ../../polyglot.h
+
+unix: LIBS += -lpthread
@@ -0,0 +1,180 @@
+#include "pgnreader.h"
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isDelimiter(char c)
+{
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';';
+}
+
+bool isResultToken(const QByteArray& token)
+{
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+}
+
+PgnReader::PgnReader(QIODevice* device)
+    : m_device(device),
+      m_hasPendingLine(false),
+      m_lineNumber(0),
+      m_variationDepth(0),
+      m_inComment(false)
+{
+}
+
+bool PgnReader::nextLine(QByteArray& line)
+{
+    if (m_hasPendingLine) {
+        line = m_pendingLine;
+        m_hasPendingLine = false;
+        return true;
+    }
+    if (m_device->atEnd()) {
+        return false;
+    }
+    line = m_device->readLine();
+    ++m_lineNumber;
+    return true;
+}
+
+bool PgnReader::readGame(PgnGame& game)
+{
+    game.clear();
+    m_variationDepth = 0;
+    m_inComment = false;
+
+    bool inMovetext = false;
+    bool sawContent = false;
+    QByteArray line;
+
+    while (nextLine(line)) {
+        QByteArray trimmed = line.trimmed();
+        if (trimmed.isEmpty() || (!m_inComment && trimmed.startsWith('%'))) {
+            continue;
+        }
+
+        if (!m_inComment && trimmed.startsWith('[')) {
+            if (inMovetext) {
+                // 缺少結果記號的對局：下一局的標籤已開始
+                m_pendingLine = line;
+                m_hasPendingLine = true;
+                break;
+            }
+            parseTag(trimmed, game);
+            sawContent = true;
+            continue;
+        }
+
+        inMovetext = true;
+        sawContent = true;
+        if (parseMovetext(trimmed, game)) {
+            break;
+        }
+    }
+
+    if (game.result.isEmpty()) {
+        game.result = game.tags.value("Result", "*");
+    }
+    return sawContent;
+}
+
+void PgnReader::parseTag(const QByteArray& line, PgnGame& game)
+{
+    // 格式：[Name "Value"]
+    int nameEnd = line.indexOf(' ');
+    int valueStart = line.indexOf('"');
+    int valueEnd = line.lastIndexOf('"');
+    if (nameEnd < 2 || valueStart < 0 || valueEnd <= valueStart) {
+        return;
+    }
+    game.tags.insert(line.mid(1, nameEnd - 1), line.mid(valueStart + 1, valueEnd - valueStart - 1));
+}
+
+bool PgnReader::parseMovetext(const QByteArray& line, PgnGame& game)
+{
+    const int length = line.size();
+    int i = 0;
+
+    while (i < length) {
+        if (m_inComment) {
+            int end = line.indexOf('}', i);
+            if (end < 0) {
+                return false;  // 註解延續到下一行
+            }
+            m_inComment = false;
+            i = end + 1;
+            continue;
+        }
+
+        char c = line[i];
+        if (isSpace(c)) {
+            ++i;
+            continue;
+        }
+        if (c == '{') {
+            m_inComment = true;
+            ++i;
+            continue;
+        }
+        if (c == ';') {
+            return false;  // 行尾註解
+        }
+        if (c == '(') {
+            ++m_variationDepth;
+            ++i;
+            continue;
+        }
+        if (c == ')') {
+            if (m_variationDepth > 0) {
+                --m_variationDepth;
+            }
+            ++i;
+            continue;
+        }
+
+        int start = i;
+        while (i < length && !isDelimiter(line[i])) {
+            ++i;
+        }
+
+        // 變著內的著法全部略過，只保留主線
+        if (m_variationDepth > 0) {
+            continue;
+        }
+
+        QByteArray token = line.mid(start, i - start);
+        if (token.startsWith('$')) {
+            continue;  // NAG
+        }
+        if (isResultToken(token)) {
+            game.result = token;
+            return true;
+        }
+
+        // 去掉回合編號，例如 "12." 或 "12...e5"
+        int digits = 0;
+        while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') {
+            ++digits;
+        }
+        if (digits > 0 && digits < token.size() && token[digits] == '.') {
+            while (digits < token.size() && token[digits] == '.') {
+                ++digits;
+            }
+            token = token.mid(digits);
+        } else if (digits == token.size()) {
+            continue;
+        }
+
+        if (!token.isEmpty()) {
+            game.moves.append(token);
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,41 @@
+#ifndef PGNREADER_H
+#define PGNREADER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QMap>
+
+// 單局 PGN：標籤與主線著法（SAN），註解、變著與 NAG 已被略過
+struct PgnGame {
+    QMap<QByteArray, QByteArray> tags;
+    QList<QByteArray> moves;
+    QByteArray result;  // "1-0"、"0-1"、"1/2-1/2" 或 "*"
+
+    void clear() { tags.clear(); moves.clear(); result.clear(); }
+};
+
+// 逐行串流讀取 PGN，一次只保留一局在記憶體中
+class PgnReader {
+public:
+    explicit PgnReader(QIODevice* device);
+
+    // 讀取下一局；檔案結束時回傳 false
+    bool readGame(PgnGame& game);
+
+    qint64 lineNumber() const { return m_lineNumber; }
+
+private:
+    QIODevice* m_device;
+    QByteArray m_pendingLine;  // 讀到下一局的標籤行時暫存
+    bool m_hasPendingLine;
+    qint64 m_lineNumber;
+    int m_variationDepth;
+    bool m_inComment;
+
+    bool nextLine(QByteArray& line);
+    void parseTag(const QByteArray& line, PgnGame& game);
+    bool parseMovetext(const QByteArray& line, PgnGame& game);  // 讀到結果記號時回傳 true
+};
+
+#endif // PGNREADER_H
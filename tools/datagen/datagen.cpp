@@ -0,0 +1,190 @@
+#include "datagen.h"
+#include "syzygy.h"
+#include <QElapsedTimer>
+#include <chrono>
+#include <thread>
+
+using namespace Engine;
+
+namespace {
+
+enum { BLACK_WINS = 0, DRAW = 1, WHITE_WINS = 2 };
+
+}
+
+DataGenerator::DataGenerator(const DatagenOptions& options)
+    : m_options(options)
+    , m_gamesStarted(0)
+    , m_gamesDone(0)
+    , m_positions(0)
+{
+    m_options.threads = qMax(1, m_options.threads);
+    for (std::atomic<qint64>& result : m_results) {
+        result = 0;
+    }
+}
+
+bool DataGenerator::open(const QString& path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        m_errorString = QString("cannot open %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+void DataGenerator::run(int intervalMs, const std::function<void()>& progress)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < m_options.threads; ++i) {
+        threads.emplace_back(&DataGenerator::worker, this, i);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (m_gamesDone < m_options.games) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (progress && timer.elapsed() >= intervalMs) {
+            progress();
+            timer.restart();
+        }
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    m_file.flush();
+}
+
+void DataGenerator::worker(int index)
+{
+    Player player;
+    player.search.setHashSize(m_options.hashMb);
+    player.search.setThreads(1);
+    player.search.setInfoCallback([&player](const SearchInfo& info) { player.score = info.score; });
+    player.rng.seed(m_options.seed + quint64(index) * 0x9E3779B97F4A7C15ULL);
+
+    std::vector<PackedPosition> records;
+    while (m_gamesStarted.fetch_add(1) < m_options.games) {
+        records.clear();
+        const int result = playGame(player, records);
+        for (PackedPosition& record : records) {
+            record.setResult(result);
+        }
+        write(records);
+
+        m_positions += qint64(records.size());
+        ++m_results[result];
+        ++m_gamesDone;
+    }
+}
+
+void DataGenerator::think(Player& player, const Position& pos)
+{
+    SearchLimits limits;
+    limits.nodes = m_options.nodes;
+    player.bestMove = MOVE_NONE;
+    player.search.start(pos, limits, [&player](Move bestMove, Move) { player.bestMove = bestMove; });
+    player.search.wait();
+}
+
+bool DataGenerator::randomOpening(Player& player, Position& pos)
+{
+    pos.setFen(Position::StartFen);
+    const int plies = m_options.randomPlies + int(player.rng() & 1);
+    for (int i = 0; i < plies; ++i) {
+        MoveList list;
+        pos.generateLegal(list);
+        if (list.size == 0) {
+            return false;
+        }
+        pos.doMove(list.moves[player.rng() % list.size]);
+    }
+
+    // 隨機開局可能已經輸定或無棋可走，這種開局不要
+    MoveList list;
+    pos.generateLegal(list);
+    if (list.size == 0) {
+        return false;
+    }
+    think(player, pos);
+    return qAbs(player.score) <= m_options.maxOpeningScore;
+}
+
+int DataGenerator::playGame(Player& player, std::vector<PackedPosition>& records)
+{
+    Position pos;
+    player.search.clearHash();
+    while (!randomOpening(player, pos)) {
+    }
+
+    int winCount = 0;
+    int lossCount = 0;  // 以白方角度計
+    int drawCount = 0;
+
+    for (int ply = 0; ; ++ply) {
+        const Color us = pos.sideToMove();
+
+        MoveList legal;
+        pos.generateLegal(legal);
+        if (legal.size == 0) {
+            return !pos.inCheck() ? DRAW : us == WHITE ? BLACK_WINS : WHITE_WINS;
+        }
+        if (pos.rule50() >= 100 || pos.isInsufficientMaterial() || pos.repetitions() >= 2
+            || ply >= m_options.maxPlies) {
+            return DRAW;
+        }
+
+        // 殘局庫範圍內直接以查詢結果判定
+        if (Syzygy::canProbe(pos) && pos.pieceCount() <= Syzygy::maxCardinality()) {
+            Syzygy::ProbeState state;
+            const Syzygy::WDLScore wdl = Syzygy::probeWdl(pos, &state);
+            if (state != Syzygy::PROBE_FAIL) {
+                if (wdl == Syzygy::WDL_WIN) {
+                    return us == WHITE ? WHITE_WINS : BLACK_WINS;
+                }
+                if (wdl == Syzygy::WDL_LOSS) {
+                    return us == WHITE ? BLACK_WINS : WHITE_WINS;
+                }
+                return DRAW;
+            }
+        }
+
+        think(player, pos);
+        const Move move = player.bestMove;
+        const int score = player.score;
+        const int whiteScore = us == WHITE ? score : -score;
+
+        // 只記錄安靜的局面：不在將軍中、最佳著法不是吃子或升變、不是已知的殺棋
+        if (!pos.inCheck() && !pos.isCapture(move) && moveType(move) != PROMOTION
+            && qAbs(score) < VALUE_TB_WIN_IN_MAX_PLY) {
+            records.push_back(PackedPosition::pack(pos, whiteScore, DRAW));
+        }
+
+        winCount = whiteScore >= m_options.winScore ? winCount + 1 : 0;
+        lossCount = whiteScore <= -m_options.winScore ? lossCount + 1 : 0;
+        drawCount = ply >= m_options.drawStartPly && qAbs(score) <= m_options.drawScore ? drawCount + 1 : 0;
+        if (winCount >= m_options.winPlies) {
+            return WHITE_WINS;
+        }
+        if (lossCount >= m_options.winPlies) {
+            return BLACK_WINS;
+        }
+        if (drawCount >= m_options.drawPlies) {
+            return DRAW;
+        }
+
+        pos.doMove(move);
+    }
+}
+
+void DataGenerator::write(const std::vector<PackedPosition>& records)
+{
+    if (records.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_file.write(reinterpret_cast<const char*>(records.data()), qint64(records.size()) * PackedPosition::Size);
+    m_file.flush();
+}
@@ -0,0 +1,79 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include "packedposition.h"
+#include "search.h"
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <vector>
+
+struct DatagenOptions {
+    int threads = 1;
+    qint64 games = 1000;
+    quint64 nodes = 5000;        // 每步固定的搜尋節點數
+    int randomPlies = 8;         // 開局隨機走的半回合數（另外隨機多走 0 或 1 步，讓雙方都有機會先走）
+    int maxOpeningScore = 300;   // 隨機開局後評估超過此值就重抽
+    int hashMb = 8;              // 每個對局執行緒的置換表
+    quint64 seed = 0;
+
+    // 判定：連續 winPlies 個半回合分數都超過 winScore 判勝；
+    // 第 drawStartPly 步之後連續 drawPlies 個半回合都在 ±drawScore 內判和
+    int winScore = 1500;
+    int winPlies = 6;
+    int drawScore = 10;
+    int drawPlies = 10;
+    int drawStartPly = 80;
+    int maxPlies = 400;          // 超過時判和
+};
+
+// 自我對弈產生訓練資料：每個執行緒各自用單執行緒的 Engine::Search 下完整盤棋，
+// 執行緒之間只共用計數器與輸出檔，因此速度隨核心數線性增加
+// 每盤結束後把記錄的局面填上結果，以 PackedPosition（32 位元組）附加到輸出檔
+class DataGenerator {
+public:
+    explicit DataGenerator(const DatagenOptions& options);
+
+    // 以附加模式開啟，多次執行的資料會接在一起
+    bool open(const QString& path);
+
+    // 執行到下完指定盤數為止；每隔 intervalMs 在呼叫端執行緒呼叫一次 progress
+    void run(int intervalMs, const std::function<void()>& progress);
+
+    qint64 games() const { return m_gamesDone; }
+    qint64 positions() const { return m_positions; }
+    qint64 whiteWins() const { return m_results[2]; }
+    qint64 draws() const { return m_results[1]; }
+    qint64 blackWins() const { return m_results[0]; }
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct Player {
+        Engine::Search search;
+        std::mt19937_64 rng;
+        int score = 0;
+        Engine::Move bestMove = Engine::MOVE_NONE;
+    };
+
+    DatagenOptions m_options;
+    QFile m_file;
+    std::mutex m_fileMutex;
+    QString m_errorString;
+
+    std::atomic<qint64> m_gamesStarted;
+    std::atomic<qint64> m_gamesDone;
+    std::atomic<qint64> m_positions;
+    std::atomic<qint64> m_results[3];
+
+    void worker(int index);
+    void think(Player& player, const Engine::Position& pos);
+    bool randomOpening(Player& player, Engine::Position& pos);
+    // 回傳白方角度的結果（0 負、1 和、2 勝），records 為這盤要寫出的局面
+    int playGame(Player& player, std::vector<Engine::PackedPosition>& records);
+    void write(const std::vector<Engine::PackedPosition>& records);
+};
+
+#endif // DATAGEN_H
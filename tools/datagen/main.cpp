@@ -0,0 +1,86 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include "datagen.h"
+#include "syzygy.h"
+
+// 以內建引擎自我對弈產生訓練資料（PackedPosition，每個局面 32 位元組）
+// 用法：datagen [--threads N] [--games N] [--nodes N] [--random-plies N] [--hash MB] [--syzygy PATH] [--seed N] output.packed
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("datagen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates labelled training positions from built-in engine self-play.");
+    parser.addHelpOption();
+    QCommandLineOption threadsOption("threads", "Concurrent games (default: all cores).", "n",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption gamesOption("games", "Games to play (default 1000).", "n", "1000");
+    QCommandLineOption nodesOption("nodes", "Search nodes per move (default 5000).", "n", "5000");
+    QCommandLineOption randomPliesOption("random-plies", "Random opening plies (default 8).", "n", "8");
+    QCommandLineOption hashOption("hash", "Hash table per game thread in MB (default 8).", "mb", "8");
+    QCommandLineOption syzygyOption("syzygy", "Syzygy folders used to adjudicate endgames.", "path");
+    QCommandLineOption seedOption("seed", "Random seed (default: current time).", "n");
+    parser.addOption(threadsOption);
+    parser.addOption(gamesOption);
+    parser.addOption(nodesOption);
+    parser.addOption(randomPliesOption);
+    parser.addOption(hashOption);
+    parser.addOption(syzygyOption);
+    parser.addOption(seedOption);
+    parser.addPositionalArgument("output", "Packed position file; new data is appended.");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    if (parser.isSet(syzygyOption)) {
+        const int count = Syzygy::init(parser.value(syzygyOption));
+        out << "Tablebases:      " << count << " (up to " << Syzygy::maxCardinality() << " pieces)" << Qt::endl;
+    }
+
+    DatagenOptions options;
+    options.threads = qMax(1, parser.value(threadsOption).toInt());
+    options.games = qMax(1LL, parser.value(gamesOption).toLongLong());
+    options.nodes = qMax(1ULL, parser.value(nodesOption).toULongLong());
+    options.randomPlies = qMax(0, parser.value(randomPliesOption).toInt());
+    options.hashMb = qMax(1, parser.value(hashOption).toInt());
+    options.seed = parser.isSet(seedOption) ? parser.value(seedOption).toULongLong()
+                                            : quint64(QDateTime::currentMSecsSinceEpoch());
+
+    DataGenerator generator(options);
+    if (!generator.open(args.first())) {
+        err << "error: " << generator.errorString() << Qt::endl;
+        return 1;
+    }
+
+    out << "Threads:         " << options.threads << Qt::endl;
+    out << "Nodes per move:  " << options.nodes << Qt::endl;
+    out << "Seed:            " << options.seed << Qt::endl;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto report = [&]() {
+        const double seconds = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+        out << "Games " << generator.games() << "/" << options.games
+            << "  positions " << generator.positions()
+            << "  " << qRound64(generator.positions() / seconds) << " pos/s"
+            << "  +" << generator.whiteWins() << " =" << generator.draws() << " -" << generator.blackWins()
+            << Qt::endl;
+    };
+    generator.run(10000, report);
+    report();
+
+    out << "Total time:      " << timer.elapsed() / 1000.0 << " s" << Qt::endl;
+    out << "Wrote " << generator.positions() * Engine::PackedPosition::Size << " bytes to " << args.first() << Qt::endl;
+    return 0;
+}
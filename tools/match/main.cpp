@@ -0,0 +1,195 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include "match.h"
+
+namespace {
+
+// 每行一個 FEN 或 EPD（只取前四欄），# 開頭為註解
+bool readOpenings(const QString& path, QStringList* openings, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        if (fields.size() < 4) {
+            continue;
+        }
+        bool numeric = fields.size() >= 6;
+        if (numeric) {
+            fields[4].toInt(&numeric);
+        }
+        const QString fen = numeric ? fields.mid(0, 6).join(' ') : fields.mid(0, 4).join(' ') + " 0 1";
+        Engine::Position pos;
+        if (pos.setFen(fen)) {
+            openings->append(pos.fen());
+        }
+    }
+    if (openings->isEmpty()) {
+        *error = QString("no valid positions in %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+// "10+0.1"：每方 10 秒，每步加 0.1 秒
+bool parseTimeControl(const QString& text, MatchOptions* options)
+{
+    const QStringList parts = text.split('+');
+    bool ok = true;
+    const double base = parts[0].toDouble(&ok);
+    if (!ok || base <= 0.0) {
+        return false;
+    }
+    const double inc = parts.size() > 1 ? parts[1].toDouble(&ok) : 0.0;
+    if (!ok || inc < 0.0) {
+        return false;
+    }
+    options->baseMs = qint64(base * 1000);
+    options->incMs = qint64(inc * 1000);
+    return true;
+}
+
+}
+
+// 兩個引擎設定之間的對戰：同時進行多盤，回報 Elo 差、誤差範圍與 SPRT 結論，對局存成 PGN
+// 用法：match --engine SPEC --engine SPEC [--games N] [--concurrency N] [--tc 10+0.1] [--openings FILE]
+//             [--pgn FILE] [--sprt elo0,elo1] [--alpha A] [--beta B]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("match");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Plays engine-vs-engine matches and reports Elo and SPRT results.\n"
+                                     "Engine SPEC: name=NAME,cmd=PATH[,arg=ARG][,threads=N][,hash=MB][,option.NAME=VALUE]\n"
+                                     "Omit cmd to use the built-in engine.");
+    parser.addHelpOption();
+    QCommandLineOption engineOption("engine", "Engine configuration; give exactly two.", "spec");
+    QCommandLineOption gamesOption("games", "Games to play (default 100).", "n", "100");
+    QCommandLineOption concurrencyOption("concurrency", "Games played at the same time (default 1).", "n", "1");
+    QCommandLineOption tcOption("tc", "Time control in seconds, base+increment (default 10+0.1).", "tc", "10+0.1");
+    QCommandLineOption marginOption("timemargin", "Milliseconds an engine may exceed its clock (default 100).", "ms", "100");
+    QCommandLineOption openingsOption("openings", "FEN/EPD file; each opening is played with both colours.", "file");
+    QCommandLineOption pgnOption("pgn", "Append finished games to this PGN file.", "file");
+    QCommandLineOption sprtOption("sprt", "Run an SPRT between elo0 and elo1 and stop when it concludes.", "elo0,elo1");
+    QCommandLineOption alphaOption("alpha", "SPRT false positive rate (default 0.05).", "a", "0.05");
+    QCommandLineOption betaOption("beta", "SPRT false negative rate (default 0.05).", "b", "0.05");
+    parser.addOption(engineOption);
+    parser.addOption(gamesOption);
+    parser.addOption(concurrencyOption);
+    parser.addOption(tcOption);
+    parser.addOption(marginOption);
+    parser.addOption(openingsOption);
+    parser.addOption(pgnOption);
+    parser.addOption(sprtOption);
+    parser.addOption(alphaOption);
+    parser.addOption(betaOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList specs = parser.values(engineOption);
+    if (specs.size() != 2) {
+        err << "error: exactly two --engine options are required" << Qt::endl;
+        return 1;
+    }
+
+    MatchOptions options;
+    QString error;
+    for (int i = 0; i < 2; ++i) {
+        if (!PlayerConfig::parse(specs[i], &options.engines[i], &error)) {
+            err << "error: " << error << Qt::endl;
+            return 1;
+        }
+    }
+    if (options.engines[0].name == options.engines[1].name) {
+        options.engines[0].name += "-1";
+        options.engines[1].name += "-2";
+    }
+
+    options.games = qMax(1, parser.value(gamesOption).toInt());
+    options.concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    options.timeMarginMs = qMax(0, parser.value(marginOption).toInt());
+    options.pgnPath = parser.value(pgnOption);
+    if (!parseTimeControl(parser.value(tcOption), &options)) {
+        err << "error: invalid time control " << parser.value(tcOption) << Qt::endl;
+        return 1;
+    }
+    if (parser.isSet(openingsOption) && !readOpenings(parser.value(openingsOption), &options.openings, &error)) {
+        err << "error: " << error << Qt::endl;
+        return 1;
+    }
+    if (parser.isSet(sprtOption)) {
+        const QStringList bounds = parser.value(sprtOption).split(',');
+        if (bounds.size() != 2) {
+            err << "error: --sprt expects elo0,elo1" << Qt::endl;
+            return 1;
+        }
+        options.sprt = true;
+        options.elo0 = bounds[0].toDouble();
+        options.elo1 = bounds[1].toDouble();
+        options.alpha = parser.value(alphaOption).toDouble();
+        options.beta = parser.value(betaOption).toDouble();
+    }
+
+    const QString first = options.engines[0].name;
+    const QString second = options.engines[1].name;
+    MatchRunner runner(options);
+
+    auto printScore = [&](const MatchScore& score) {
+        out << QString("Score of %1 vs %2: %3 - %4 - %5  [%6] %7")
+                   .arg(first, second)
+                   .arg(score.wins).arg(score.losses).arg(score.draws)
+                   .arg(score.score(), 0, 'f', 3)
+                   .arg(score.games())
+            << Qt::endl;
+    };
+    auto printElo = [&](const MatchScore& score) {
+        out << QString("Elo difference: %1 +/- %2").arg(score.elo(), 0, 'f', 1).arg(score.eloError(), 0, 'f', 1)
+            << Qt::endl;
+        if (options.sprt) {
+            const double llr = score.llr(options.elo0, options.elo1);
+            out << QString("SPRT: llr %1 (%2%), lbound %3, ubound %4")
+                       .arg(llr, 0, 'f', 2)
+                       .arg(100.0 * llr / runner.upperBound(), 0, 'f', 1)
+                       .arg(runner.lowerBound(), 0, 'f', 2)
+                       .arg(runner.upperBound(), 0, 'f', 2)
+                << Qt::endl;
+        }
+    };
+
+    const bool ok = runner.run([&](const FinishedGame& game) {
+        out << QString("Finished game %1 (%2 vs %3): %4 {%5}")
+                   .arg(game.number).arg(game.white, game.black, game.result, game.reason)
+            << Qt::endl;
+        printScore(game.score);
+        if (game.score.games() % 10 == 0) {
+            printElo(game.score);
+        }
+    });
+    if (!ok) {
+        err << "error: " << runner.errorString() << Qt::endl;
+        return 1;
+    }
+
+    const MatchScore score = runner.score();
+    out << "Finished match" << Qt::endl;
+    printScore(score);
+    printElo(score);
+    if (runner.verdict() == SprtVerdict::AcceptH1) {
+        out << "SPRT: H1 was accepted" << Qt::endl;
+    } else if (runner.verdict() == SprtVerdict::AcceptH0) {
+        out << "SPRT: H0 was accepted" << Qt::endl;
+    }
+    return 0;
+}
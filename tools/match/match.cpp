@@ -0,0 +1,315 @@
+#include "match.h"
+#include <QDate>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cmath>
+#include <thread>
+
+using namespace Engine;
+
+namespace {
+
+double eloFromScore(double score)
+{
+    score = qBound(1e-6, score, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double scoreFromElo(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+QString winFor(Color c)
+{
+    return c == WHITE ? "1-0" : "0-1";
+}
+
+QString colorName(Color c)
+{
+    return c == WHITE ? "White" : "Black";
+}
+
+}
+
+double MatchScore::score() const
+{
+    return games() ? (wins + 0.5 * draws) / games() : 0.5;
+}
+
+double MatchScore::elo() const
+{
+    return eloFromScore(score());
+}
+
+double MatchScore::eloError() const
+{
+    const int n = games();
+    if (n == 0) {
+        return 0.0;
+    }
+    const double s = score();
+    const double variance = (wins * (1.0 - s) * (1.0 - s) + losses * s * s + draws * (0.5 - s) * (0.5 - s)) / n;
+    const double margin = 1.96 * std::sqrt(variance / n);
+    return (eloFromScore(s + margin) - eloFromScore(s - margin)) / 2.0;
+}
+
+double MatchScore::llr(double elo0, double elo1) const
+{
+    const int n = games();
+    if (n == 0 || wins + draws == 0 || losses + draws == 0) {
+        return 0.0;
+    }
+    const double s = score();
+    const double variance = (wins * (1.0 - s) * (1.0 - s) + losses * s * s + draws * (0.5 - s) * (0.5 - s)) / n;
+    if (variance <= 0.0) {
+        return 0.0;
+    }
+    const double s0 = scoreFromElo(elo0);
+    const double s1 = scoreFromElo(elo1);
+    return n * (s1 - s0) * (2.0 * s - s0 - s1) / (2.0 * variance);
+}
+
+MatchRunner::MatchRunner(const MatchOptions& options)
+    : m_options(options)
+    , m_verdict(SprtVerdict::None)
+    , m_nextGame(0)
+    , m_stop(false)
+{
+    m_options.concurrency = qMax(1, m_options.concurrency);
+    if (m_options.openings.isEmpty()) {
+        m_options.openings.append(Position::StartFen);
+    }
+}
+
+double MatchRunner::lowerBound() const
+{
+    return std::log(m_options.beta / (1.0 - m_options.alpha));
+}
+
+double MatchRunner::upperBound() const
+{
+    return std::log((1.0 - m_options.beta) / m_options.alpha);
+}
+
+MatchScore MatchRunner::score() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_score;
+}
+
+bool MatchRunner::run(const GameCallback& onGame)
+{
+    m_onGame = onGame;
+    if (!m_options.pgnPath.isEmpty()) {
+        m_pgn.setFileName(m_options.pgnPath);
+        if (!m_pgn.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            m_errorString = QString("cannot open %1: %2").arg(m_options.pgnPath, m_pgn.errorString());
+            return false;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < m_options.concurrency; ++i) {
+        threads.emplace_back(&MatchRunner::worker, this);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return m_errorString.isEmpty();
+}
+
+void MatchRunner::worker()
+{
+    std::unique_ptr<Player> players[2];
+    for (int i = 0; i < 2; ++i) {
+        players[i] = Player::create(m_options.engines[i]);
+        QString error;
+        if (!players[i]->start(&error)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_errorString = error;
+            m_stop = true;
+            return;
+        }
+    }
+
+    while (!m_stop) {
+        const int index = m_nextGame.fetch_add(1);
+        if (index >= m_options.games) {
+            break;
+        }
+        const QString& fen = m_options.openings[(index / 2) % m_options.openings.size()];
+        const bool firstIsWhite = (index & 1) == 0;
+        Player* white = players[firstIsWhite ? 0 : 1].get();
+        Player* black = players[firstIsWhite ? 1 : 0].get();
+        white->newGame();
+        black->newGame();
+
+        const GameRecord game = playGame(white, black, m_options.engines[firstIsWhite ? 0 : 1].name,
+                                         m_options.engines[firstIsWhite ? 1 : 0].name, fen);
+        finishGame(index, firstIsWhite, game);
+    }
+}
+
+MatchRunner::GameRecord MatchRunner::playGame(Player* white, Player* black, const QString& whiteName,
+                                              const QString& blackName, const QString& fen)
+{
+    GameRecord game;
+    game.white = whiteName;
+    game.black = blackName;
+    game.fen = fen;
+
+    Position pos;
+    pos.setFen(fen);
+    QStringList moves;
+
+    Clock clock;
+    for (Color c : { WHITE, BLACK }) {
+        clock.time[c] = m_options.baseMs;
+        clock.inc[c] = m_options.incMs;
+    }
+
+    for (int ply = 0; ; ++ply) {
+        const Color us = pos.sideToMove();
+
+        MoveList legal;
+        pos.generateLegal(legal);
+        if (legal.size == 0) {
+            if (pos.inCheck()) {
+                game.result = winFor(~us);
+                game.reason = colorName(~us) + " mates";
+            } else {
+                game.result = "1/2-1/2";
+                game.reason = "Draw by stalemate";
+            }
+            return game;
+        }
+        if (pos.rule50() >= 100) {
+            game.result = "1/2-1/2";
+            game.reason = "Draw by fifty moves rule";
+            return game;
+        }
+        if (pos.repetitions() >= 2) {
+            game.result = "1/2-1/2";
+            game.reason = "Draw by 3-fold repetition";
+            return game;
+        }
+        if (pos.isInsufficientMaterial()) {
+            game.result = "1/2-1/2";
+            game.reason = "Draw by insufficient mating material";
+            return game;
+        }
+        if (ply >= m_options.maxPlies) {
+            game.result = "1/2-1/2";
+            game.reason = "Draw by adjudication: game too long";
+            return game;
+        }
+
+        Player* player = us == WHITE ? white : black;
+        QElapsedTimer timer;
+        timer.start();
+        const QString uci = player->go(fen, moves, clock, clock.time[us] + m_options.timeMarginMs);
+        clock.time[us] -= timer.elapsed();
+
+        if (clock.time[us] < -m_options.timeMarginMs) {
+            game.result = winFor(~us);
+            game.reason = colorName(us) + " loses on time";
+            return game;
+        }
+        const Move move = uci.isEmpty() ? MOVE_NONE : pos.parseUciMove(uci);
+        if (move == MOVE_NONE) {
+            game.result = winFor(~us);
+            game.reason = uci.isEmpty() ? colorName(us) + " disconnects"
+                                        : colorName(us) + " makes an illegal move: " + uci;
+            return game;
+        }
+        clock.time[us] += clock.inc[us];
+
+        game.san.append(pos.moveToSan(move));
+        pos.doMove(move);
+        moves.append(uci);
+    }
+}
+
+void MatchRunner::finishGame(int index, bool firstIsWhite, const GameRecord& game)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (game.result == "1/2-1/2") {
+        ++m_score.draws;
+    } else if ((game.result == "1-0") == firstIsWhite) {
+        ++m_score.wins;
+    } else {
+        ++m_score.losses;
+    }
+
+    if (m_pgn.isOpen()) {
+        writePgn(index, game);
+    }
+
+    if (m_options.sprt && m_verdict == SprtVerdict::None) {
+        const double llr = m_score.llr(m_options.elo0, m_options.elo1);
+        if (llr >= upperBound()) {
+            m_verdict = SprtVerdict::AcceptH1;
+        } else if (llr <= lowerBound()) {
+            m_verdict = SprtVerdict::AcceptH0;
+        }
+        // 有結論後不再開新局，進行中的對局照常下完並計入結果
+        if (m_verdict != SprtVerdict::None) {
+            m_stop = true;
+        }
+    }
+
+    if (m_onGame) {
+        m_onGame({ index + 1, game.white, game.black, game.result, game.reason, m_score });
+    }
+}
+
+void MatchRunner::writePgn(int index, const GameRecord& game)
+{
+    QTextStream out(&m_pgn);
+    out << "[Event \"match\"]\n";
+    out << "[Site \"?\"]\n";
+    out << "[Date \"" << QDate::currentDate().toString("yyyy.MM.dd") << "\"]\n";
+    out << "[Round \"" << index + 1 << "\"]\n";
+    out << "[White \"" << game.white << "\"]\n";
+    out << "[Black \"" << game.black << "\"]\n";
+    out << "[Result \"" << game.result << "\"]\n";
+    if (game.fen != Position::StartFen) {
+        out << "[FEN \"" << game.fen << "\"]\n";
+        out << "[SetUp \"1\"]\n";
+    }
+    out << "[TimeControl \"" << m_options.baseMs / 1000.0 << "+" << m_options.incMs / 1000.0 << "\"]\n";
+    out << "[PlyCount \"" << game.san.size() << "\"]\n\n";
+
+    // 著法每行不超過 80 字元
+    Position pos;
+    pos.setFen(game.fen);
+    int moveNumber = 1 + pos.gamePly() / 2;
+    bool whiteToMove = pos.sideToMove() == WHITE;
+    QString line;
+    auto append = [&out, &line](const QString& token) {
+        if (!line.isEmpty() && line.size() + 1 + token.size() > 80) {
+            out << line << '\n';
+            line.clear();
+        }
+        line += line.isEmpty() ? token : ' ' + token;
+    };
+
+    for (int i = 0; i < game.san.size(); ++i) {
+        if (whiteToMove) {
+            append(QString("%1. %2").arg(moveNumber).arg(game.san[i]));
+        } else if (i == 0) {
+            append(QString("%1... %2").arg(moveNumber).arg(game.san[i]));
+        } else {
+            append(game.san[i]);
+        }
+        if (!whiteToMove) {
+            ++moveNumber;
+        }
+        whiteToMove = !whiteToMove;
+    }
+    append(QString("{%1} %2").arg(game.reason, game.result));
+    out << line << "\n\n";
+    out.flush();
+}
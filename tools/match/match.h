@@ -0,0 +1,100 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include "player.h"
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+struct MatchOptions {
+    PlayerConfig engines[2];
+    int games = 100;               // 每個開局會互換顏色各下一盤，建議用偶數
+    int concurrency = 1;
+    qint64 baseMs = 10000;         // 每方的起始時間
+    qint64 incMs = 100;
+    qint64 timeMarginMs = 100;     // 超時容忍量，超過才判超時負
+    int maxPlies = 600;            // 超過時判和
+    QStringList openings;          // FEN；空的時候只用初始局面
+    QString pgnPath;
+
+    bool sprt = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+// 以第一個引擎的角度統計
+struct MatchScore {
+    int wins = 0;
+    int losses = 0;
+    int draws = 0;
+
+    int games() const { return wins + losses + draws; }
+    double score() const;
+    double elo() const;
+    double eloError() const;  // 95% 信賴區間的半寬
+    // 序貫機率比檢定的對數概似比（以常態近似的 GSPRT）
+    double llr(double elo0, double elo1) const;
+};
+
+enum class SprtVerdict { None, AcceptH0, AcceptH1 };
+
+// 每盤結束後交給回呼的摘要，score 為加入這一盤之後的累計
+struct FinishedGame {
+    int number;
+    QString white;
+    QString black;
+    QString result;
+    QString reason;
+    MatchScore score;
+};
+
+// 同時進行多盤對局：每個執行緒建立自己的兩個對局者，依序取下一盤的編號
+// 第 i 盤使用第 i / 2 個開局，奇數盤互換顏色；SPRT 有結論後不再開新局
+class MatchRunner {
+public:
+    // 每盤結束後呼叫（在對局執行緒上，已持有鎖，不可再呼叫 score()）
+    typedef std::function<void(const FinishedGame&)> GameCallback;
+
+    explicit MatchRunner(const MatchOptions& options);
+
+    bool run(const GameCallback& onGame);
+
+    MatchScore score() const;
+    SprtVerdict verdict() const { return m_verdict; }
+    double lowerBound() const;
+    double upperBound() const;
+    QString errorString() const { return m_errorString; }
+
+private:
+    struct GameRecord {
+        QString white;
+        QString black;
+        QString fen;
+        QStringList san;
+        QString result;       // "1-0"、"0-1"、"1/2-1/2"
+        QString reason;
+    };
+
+    MatchOptions m_options;
+    mutable std::mutex m_mutex;
+    MatchScore m_score;
+    SprtVerdict m_verdict;
+    std::atomic<int> m_nextGame;
+    std::atomic<bool> m_stop;
+    QFile m_pgn;
+    QString m_errorString;
+    GameCallback m_onGame;
+
+    void worker();
+    GameRecord playGame(Player* white, Player* black, const QString& whiteName, const QString& blackName,
+                        const QString& fen);
+    void finishGame(int index, bool firstIsWhite, const GameRecord& game);
+    void writePgn(int index, const GameRecord& game);
+};
+
+#endif // MATCH_H
@@ -0,0 +1,45 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = match
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    match.cpp \
+    player.cpp \
+    ../../bitboard.cpp \
+    ../../position.cpp \
+    ../../bitbase.cpp \
+    ../../syzygy.cpp \
+    ../../evaluate.cpp \
+    ../../nnue.cpp \
+    ../../movepick.cpp \
+    ../../tt.cpp \
+    ../../search.cpp
+
+HEADERS += \
+    match.h \
+    player.h \
+    ../../bitboard.h \
+    ../../position.h \
+    ../../bitbase.h \
+    ../../syzygy.h \
+    ../../evaluate.h \
+    ../../evalparams.h \
+    ../../nnue.h \
+    ../../movepick.h \
+    ../../tt.h \
+    ../../search.h
+
+# NNUE 推論在 x86-64 預設使用 SSE2；以 qmake CONFIG+=avx2 建置可改用 AVX2（執行的 CPU 必須支援）
+avx2 {
+    gcc|clang: QMAKE_CXXFLAGS += -mavx2
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+}
+
+unix: LIBS += -lpthread
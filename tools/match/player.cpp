@@ -0,0 +1,185 @@
+#include "player.h"
+#include <QElapsedTimer>
+
+using namespace Engine;
+
+namespace {
+
+// 啟動與 isready 的等待時間
+const int HandshakeTimeoutMs = 10000;
+
+}
+
+bool PlayerConfig::parse(const QString& spec, PlayerConfig* config, QString* error)
+{
+    *config = PlayerConfig();
+    for (const QString& item : spec.split(',', Qt::SkipEmptyParts)) {
+        const int eq = item.indexOf('=');
+        const QString key = (eq < 0 ? item : item.left(eq)).trimmed();
+        const QString value = eq < 0 ? QString() : item.mid(eq + 1).trimmed();
+
+        if (key == "name") {
+            config->name = value;
+        } else if (key == "cmd") {
+            config->command = value;
+        } else if (key == "arg") {
+            config->arguments.append(value);
+        } else if (key == "threads") {
+            config->threads = qMax(1, value.toInt());
+        } else if (key == "hash") {
+            config->hashMb = qMax(1, value.toInt());
+        } else if (key.startsWith("option.")) {
+            config->options.append(qMakePair(key.mid(7), value));
+        } else if (key != "builtin") {
+            *error = QString("unknown engine setting '%1'").arg(key);
+            return false;
+        }
+    }
+    if (config->name.isEmpty()) {
+        config->name = config->isBuiltin() ? "builtin" : config->command;
+    }
+    return true;
+}
+
+std::unique_ptr<Player> Player::create(const PlayerConfig& config)
+{
+    if (config.isBuiltin()) {
+        return std::unique_ptr<Player>(new BuiltinPlayer(config));
+    }
+    return std::unique_ptr<Player>(new UciPlayer(config));
+}
+
+BuiltinPlayer::BuiltinPlayer(const PlayerConfig& config)
+    : m_config(config)
+{
+}
+
+bool BuiltinPlayer::start(QString*)
+{
+    m_search.setHashSize(m_config.hashMb);
+    m_search.setThreads(m_config.threads);
+    return true;
+}
+
+void BuiltinPlayer::newGame()
+{
+    m_search.clearHash();
+}
+
+QString BuiltinPlayer::go(const QString& fen, const QStringList& moves, const Clock& clock, qint64)
+{
+    Position pos;
+    pos.setFen(fen);
+    for (const QString& uci : moves) {
+        pos.doMove(pos.parseUciMove(uci));
+    }
+
+    SearchLimits limits;
+    for (Color c : { WHITE, BLACK }) {
+        limits.time[c] = int(qMax<qint64>(1, clock.time[c]));
+        limits.inc[c] = int(clock.inc[c]);
+    }
+
+    Move best = MOVE_NONE;
+    m_search.start(pos, limits, [&best](Move bestMove, Move) { best = bestMove; });
+    m_search.wait();
+    return best == MOVE_NONE ? QString() : pos.moveToUci(best);
+}
+
+UciPlayer::UciPlayer(const PlayerConfig& config)
+    : m_config(config)
+{
+    m_process.setProcessChannelMode(QProcess::SeparateChannels);
+}
+
+UciPlayer::~UciPlayer()
+{
+    if (m_process.state() != QProcess::NotRunning) {
+        send("quit");
+        if (!m_process.waitForFinished(1000)) {
+            m_process.kill();
+            m_process.waitForFinished(1000);
+        }
+    }
+}
+
+bool UciPlayer::start(QString* error)
+{
+    m_process.start(m_config.command, m_config.arguments);
+    if (!m_process.waitForStarted(HandshakeTimeoutMs)) {
+        *error = QString("%1: cannot start %2").arg(m_config.name, m_config.command);
+        return false;
+    }
+
+    send("uci");
+    if (waitFor("uciok", HandshakeTimeoutMs).isEmpty()) {
+        *error = QString("%1: no uciok").arg(m_config.name);
+        return false;
+    }
+
+    send(QString("setoption name Threads value %1").arg(m_config.threads));
+    send(QString("setoption name Hash value %1").arg(m_config.hashMb));
+    for (const auto& option : m_config.options) {
+        send(QString("setoption name %1 value %2").arg(option.first, option.second));
+    }
+    send("isready");
+    if (waitFor("readyok", HandshakeTimeoutMs).isEmpty()) {
+        *error = QString("%1: no readyok").arg(m_config.name);
+        return false;
+    }
+    return true;
+}
+
+void UciPlayer::newGame()
+{
+    send("ucinewgame");
+    send("isready");
+    waitFor("readyok", HandshakeTimeoutMs);
+}
+
+QString UciPlayer::go(const QString& fen, const QStringList& moves, const Clock& clock, qint64 timeoutMs)
+{
+    QString position = fen == Position::StartFen ? QString("position startpos") : "position fen " + fen;
+    if (!moves.isEmpty()) {
+        position += " moves " + moves.join(' ');
+    }
+    send(position);
+    send(QString("go wtime %1 btime %2 winc %3 binc %4")
+             .arg(qMax<qint64>(1, clock.time[WHITE])).arg(qMax<qint64>(1, clock.time[BLACK]))
+             .arg(clock.inc[WHITE]).arg(clock.inc[BLACK]));
+
+    QString line = waitFor("bestmove", timeoutMs);
+    if (line.isEmpty()) {
+        // 超時：要求停止並收掉 bestmove，下一盤才不會讀到舊的回答
+        send("stop");
+        waitFor("bestmove", HandshakeTimeoutMs);
+        return QString();
+    }
+    const QStringList tokens = line.split(' ', Qt::SkipEmptyParts);
+    return tokens.size() > 1 ? tokens[1] : QString();
+}
+
+void UciPlayer::send(const QString& line)
+{
+    m_process.write((line + '\n').toUtf8());
+    m_process.waitForBytesWritten(1000);
+}
+
+QString UciPlayer::waitFor(const QString& prefix, qint64 timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (true) {
+        while (m_process.canReadLine()) {
+            const QString line = QString::fromUtf8(m_process.readLine()).trimmed();
+            if (line.startsWith(prefix)) {
+                return line;
+            }
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0 || m_process.state() == QProcess::NotRunning) {
+            return QString();
+        }
+        m_process.waitForReadyRead(int(qMin<qint64>(remaining, 100)));
+    }
+}
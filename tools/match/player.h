@@ -0,0 +1,77 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include "search.h"
+#include <QProcess>
+#include <QStringList>
+#include <memory>
+
+// 對局者設定，由命令列的 --engine "name=X,cmd=...,threads=1,hash=16,option.Name=value" 解析而來
+// 沒有 cmd 時使用內建引擎
+struct PlayerConfig {
+    QString name;
+    QString command;                           // UCI 引擎執行檔
+    QStringList arguments;
+    int threads = 1;
+    int hashMb = 16;
+    QList<QPair<QString, QString>> options;    // 額外的 UCI setoption
+
+    bool isBuiltin() const { return command.isEmpty(); }
+
+    // 格式錯誤時回傳 false 並填入 error
+    static bool parse(const QString& spec, PlayerConfig* config, QString* error);
+};
+
+// 單盤棋的時鐘（毫秒）
+struct Clock {
+    qint64 time[Engine::COLOR_NB] = { 0, 0 };
+    qint64 inc[Engine::COLOR_NB] = { 0, 0 };
+};
+
+// 對局者：每個對局執行緒各自建立，同一個物件連續下很多盤
+// go() 在呼叫端執行緒上同步等待結果
+class Player {
+public:
+    virtual ~Player() {}
+
+    virtual bool start(QString* error) = 0;
+    virtual void newGame() = 0;
+    // 回傳 UCI 著法；引擎沒有回應或在 timeoutMs 內沒有回答時回傳空字串
+    virtual QString go(const QString& fen, const QStringList& moves, const Clock& clock, qint64 timeoutMs) = 0;
+
+    static std::unique_ptr<Player> create(const PlayerConfig& config);
+};
+
+class BuiltinPlayer : public Player {
+public:
+    explicit BuiltinPlayer(const PlayerConfig& config);
+
+    bool start(QString* error) override;
+    void newGame() override;
+    QString go(const QString& fen, const QStringList& moves, const Clock& clock, qint64 timeoutMs) override;
+
+private:
+    PlayerConfig m_config;
+    Engine::Search m_search;
+};
+
+// 以子程序執行的 UCI 引擎；不需要事件迴圈，全部以 waitFor* 同步讀寫
+class UciPlayer : public Player {
+public:
+    explicit UciPlayer(const PlayerConfig& config);
+    ~UciPlayer() override;
+
+    bool start(QString* error) override;
+    void newGame() override;
+    QString go(const QString& fen, const QStringList& moves, const Clock& clock, qint64 timeoutMs) override;
+
+private:
+    PlayerConfig m_config;
+    QProcess m_process;
+
+    void send(const QString& line);
+    // 讀到以 prefix 開頭的一行為止，回傳該行；逾時或程序結束時回傳空字串
+    QString waitFor(const QString& prefix, qint64 timeoutMs);
+};
+
+#endif // PLAYER_H
@@ -0,0 +1,123 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QTimer>
+#include "chessboard.h"
+#include "enginepool.h"
+
+namespace {
+
+QTextStream out(stdout);
+int failures = 0;
+
+void check(bool ok, const QString& name)
+{
+    out << (ok ? "ok   " : "FAIL ") << name << Qt::endl;
+    if (!ok) {
+        ++failures;
+    }
+}
+
+// 在借到的引擎上從起始局面搜尋到指定深度，等到 bestmove 或逾時
+bool searchOnce(UCIEngine* engine, int depth, int timeoutMs)
+{
+    ChessBoard board;
+    Engine::SearchLimits limits;
+    limits.depth = depth;
+
+    // 連線以 loop 為 context，函式結束時隨 loop 一起斷開
+    bool found = false;
+    QEventLoop loop;
+    QObject::connect(engine, &UCIEngine::bestMoveFound, &loop, [&](QString, QString, PieceType) {
+        found = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeoutMs, &loop, &QEventLoop::quit);
+    engine->getBestMove(&board, limits);
+    loop.exec();
+    return found;
+}
+
+} // namespace
+
+// 以真正的引擎程序檢查 EnginePool：預算分配、借滿後排隊、優先順序、取消與歸還時的交接
+// 用法：poolcheck --engine PATH [--depth N] [--timeout MS]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("poolcheck");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Exercises EnginePool against a real UCI engine and reports each check.");
+    parser.addHelpOption();
+    QCommandLineOption engineOption("engine", "UCI engine executable.", "path");
+    QCommandLineOption depthOption("depth", "Search depth used on leased engines (default 8).", "n", "8");
+    QCommandLineOption timeoutOption("timeout", "Milliseconds to wait for each search (default 30000).", "ms", "30000");
+    parser.addOption(engineOption);
+    parser.addOption(depthOption);
+    parser.addOption(timeoutOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+    const QString enginePath = parser.value(engineOption);
+    const int depth = qMax(1, parser.value(depthOption).toInt());
+    const int timeoutMs = qMax(1000, parser.value(timeoutOption).toInt());
+
+    // 預算：不夠每個程序 1 個執行緒與 16 MB 時程序數減少
+    {
+        EnginePool pool;
+        if (!pool.initialize(enginePath, 8, 2, 32)) {
+            err << "error: engine not found: " << enginePath << Qt::endl;
+            return 1;
+        }
+        check(pool.size() == 2, "size is reduced to fit a 2-thread, 32 MB budget");
+        check(pool.threadsPerEngine() * pool.size() <= 2 && pool.hashPerEngine() * pool.size() <= 32,
+              "threads and hash stay within the budget");
+    }
+
+    EnginePool pool;
+    pool.initialize(enginePath, 2, 2, 64);
+
+    // 借滿：前兩個請求在呼叫中拿到程序，之後的排隊
+    QStringList order;
+    UCIEngine* first = nullptr;
+    UCIEngine* second = nullptr;
+    UCIEngine* high = nullptr;
+    UCIEngine* low = nullptr;
+    pool.acquire([&](UCIEngine* engine) { first = engine; order << "first"; });
+    pool.acquire([&](UCIEngine* engine) { second = engine; order << "second"; });
+    pool.acquire([&](UCIEngine* engine) { low = engine; order << "low"; }, 0);
+    const int cancelled = pool.acquire([&](UCIEngine*) { order << "cancelled"; }, 0);
+    pool.acquire([&](UCIEngine* engine) { high = engine; order << "high"; }, 10);
+    check(first && second && first != second, "the first two requests are leased immediately");
+    check(pool.leasedCount() == 2 && pool.idleCount() == 0 && pool.queuedCount() == 3,
+          "further requests queue once the pool is saturated");
+
+    pool.cancel(cancelled);
+    check(pool.queuedCount() == 2, "cancel removes a queued request");
+
+    check(searchOnce(first, depth, timeoutMs), "a leased engine finishes a search");
+
+    // 歸還：依優先順序交給排隊的請求，被取消的不會拿到
+    pool.release(first);
+    check(high == first && pool.queuedCount() == 1, "release hands the engine to the higher-priority request");
+    pool.release(second);
+    check(low == second && pool.queuedCount() == 0, "the next release serves the remaining request");
+    check(order.join(' ') == "first second high low", "leases happen in priority order: " + order.join(' '));
+
+    // 交接後的程序從乾淨的狀態開始，照常可以搜尋
+    check(searchOnce(high, depth, timeoutMs), "a handed-off engine finishes a search");
+
+    pool.release(high);
+    pool.release(low);
+    pool.release(low);
+    check(pool.idleCount() == 2 && pool.leasedCount() == 0, "released engines return to the idle list once");
+
+    bool reused = false;
+    pool.acquire([&](UCIEngine* engine) { reused = engine == first || engine == second; pool.release(engine); });
+    check(reused && pool.idleCount() == 2, "an idle engine is reused instead of starting another process");
+
+    out << (failures == 0 ? "All checks passed" : QString("%1 check(s) failed").arg(failures)) << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}
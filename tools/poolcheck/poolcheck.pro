@@ -0,0 +1,31 @@
+QT       += core gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = poolcheck
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../enginepool.cpp \
+    ../../uciengine.cpp \
+    ../../uciengineio.cpp \
+    ../../linequeue.cpp \
+    ../../chessboard.cpp \
+    ../../chesspiece.cpp \
+    ../../bitboard.cpp \
+    ../../position.cpp
+
+HEADERS += \
+    ../../enginepool.h \
+    ../../uciengine.h \
+    ../../uciengineio.h \
+    ../../linequeue.h \
+    ../../chessboard.h \
+    ../../chesspiece.h \
+    ../../bitboard.h \
+    ../../position.h
+
+unix: LIBS += -lpthread
@@ -0,0 +1,10 @@
+# 無介面的命令列工具（與主程式共用棋盤程式碼）
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bookbuilder \
+    uci \
+    tuner \
+    datagen \
+    match \
+    poolcheck
@@ -0,0 +1,100 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include "tuner.h"
+
+// 以本機的已標記局面（EPD/CSV）調校內建引擎的評估參數，結果寫成 evalparams.h
+// 用法：tuner [--threads N] [--epochs N] [--rate R] [--k K] [--limit N] [--output FILE] data.epd...
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tuner");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tunes the built-in engine's evaluation parameters on labelled positions (Texel method).");
+    parser.addHelpOption();
+    QCommandLineOption threadsOption("threads", "Worker threads (default: all cores).", "n",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption epochsOption("epochs", "Optimisation passes over the data (default 500).", "n", "500");
+    QCommandLineOption rateOption("rate", "Adam learning rate in centipawns (default 1.0).", "r", "1.0");
+    QCommandLineOption kOption("k", "Scaling constant of the sigmoid; fitted to the data when omitted.", "k");
+    QCommandLineOption limitOption("limit", "Read at most <n> positions (default: all).", "n", "0");
+    QCommandLineOption outputOption("output", "Header to write (default evalparams.h).", "file", "evalparams.h");
+    parser.addOption(threadsOption);
+    parser.addOption(epochsOption);
+    parser.addOption(rateOption);
+    parser.addOption(kOption);
+    parser.addOption(limitOption);
+    parser.addOption(outputOption);
+    parser.addPositionalArgument("data", "EPD, CSV or datagen .packed files with positions and game results.", "data...");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    TunerOptions options;
+    options.threads = qMax(1, parser.value(threadsOption).toInt());
+    options.epochs = qMax(1, parser.value(epochsOption).toInt());
+    options.learningRate = parser.value(rateOption).toDouble();
+    options.k = parser.isSet(kOption) ? parser.value(kOption).toDouble() : 0.0;
+    options.limit = qMax(0LL, parser.value(limitOption).toLongLong());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Tuner tuner(options);
+    for (const QString& file : files) {
+        out << "Reading " << file << "..." << Qt::endl;
+        if (!tuner.addFile(file)) {
+            err << "error: " << tuner.errorString() << Qt::endl;
+            return 1;
+        }
+    }
+    if (tuner.positionCount() == 0) {
+        err << "error: no usable positions" << Qt::endl;
+        return 1;
+    }
+
+    out << "Positions:       " << tuner.positionCount() << " (" << tuner.skippedCount() << " skipped)" << Qt::endl;
+    out << "Memory:          " << tuner.memoryUsage() / (1024 * 1024) << " MB" << Qt::endl;
+    out << "Load time:       " << timer.elapsed() / 1000.0 << " s" << Qt::endl;
+
+    if (options.k <= 0.0) {
+        tuner.fitK();
+    }
+    const double initialError = tuner.error();
+    out << "K:               " << tuner.k() << Qt::endl;
+    out << "Initial error:   " << initialError << Qt::endl;
+
+    timer.restart();
+    tuner.tune([&out](int epoch, double error) {
+        if (epoch == 1 || epoch % 50 == 0) {
+            out << "Epoch " << epoch << ": error " << error << Qt::endl;
+        }
+    });
+    const double finalError = tuner.error();
+    out << "Final error:     " << finalError << Qt::endl;
+    out << "Tuning time:     " << timer.elapsed() / 1000.0 << " s" << Qt::endl;
+
+    const QString output = parser.value(outputOption);
+    const QString source = QString("資料：%1，%2 個局面，K = %3，誤差 %4 -> %5")
+                               .arg(QFileInfo(files.first()).fileName())
+                               .arg(tuner.positionCount())
+                               .arg(tuner.k(), 0, 'f', 4)
+                               .arg(initialError, 0, 'f', 6)
+                               .arg(finalError, 0, 'f', 6);
+    if (!tuner.writeHeader(output, source)) {
+        err << "error: " << tuner.errorString() << Qt::endl;
+        return 1;
+    }
+    out << "Wrote " << output << Qt::endl;
+    return 0;
+}
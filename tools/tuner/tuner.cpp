@@ -0,0 +1,449 @@
+#include "tuner.h"
+#include "evalparams.h"
+#include "packedposition.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <cmath>
+#include <thread>
+
+using namespace Engine;
+
+namespace {
+
+const int MaxPhase = 24;
+const int PhaseWeight[PIECE_KIND_NB] = { 0, 1, 1, 2, 4, 0 };
+
+enum EntryFlag {
+    FLAG_BLACK_TO_MOVE = 1,
+    FLAG_WHITE_BISHOP_PAIR = 2,
+    FLAG_BLACK_BISHOP_PAIR = 4
+};
+
+const char* const PieceNames[PIECE_KIND_NB] = { "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+
+// 與 evaluate.cpp 相同：白方直接翻成表格索引（a8 = 0），黑方上下鏡射
+inline int tableIndex(Color c, int sq)
+{
+    return c == WHITE ? sq ^ 56 : sq;
+}
+
+inline int mg(int term) { return 2 * term; }
+inline int eg(int term) { return 2 * term + 1; }
+
+// 預期得分：K 把百分兵換成勝率的比例
+inline double sigmoid(double k, double eval)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+}
+
+Tuner::Tuner(const TunerOptions& options)
+    : m_options(options)
+    , m_params(PARAM_NB, 0.0)
+    , m_k(options.k)
+    , m_skipped(0)
+{
+    m_options.threads = qMax(1, m_options.threads);
+
+    // 從目前的參數開始調校
+    for (int k = 0; k < PIECE_KIND_NB; ++k) {
+        m_params[mg(TERM_MATERIAL + k)] = EvalParams::MaterialMg[k];
+        m_params[eg(TERM_MATERIAL + k)] = EvalParams::MaterialEg[k];
+        for (int sq = 0; sq < SQUARE_NB; ++sq) {
+            m_params[mg(TERM_PST + k * 64 + sq)] = EvalParams::PstMg[k][sq];
+            m_params[eg(TERM_PST + k * 64 + sq)] = EvalParams::PstEg[k][sq];
+        }
+    }
+    m_params[mg(TERM_BISHOP_PAIR)] = EvalParams::BishopPairMg;
+    m_params[eg(TERM_BISHOP_PAIR)] = EvalParams::BishopPairEg;
+    m_params[mg(TERM_TEMPO)] = EvalParams::TempoMg;
+    m_params[eg(TERM_TEMPO)] = EvalParams::TempoEg;
+}
+
+bool Tuner::addFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    // tools/datagen 產生的二進位資料
+    if (QFileInfo(path).suffix() == "packed") {
+        PackedPosition packed;
+        while (file.read(reinterpret_cast<char*>(packed.data), PackedPosition::Size) == PackedPosition::Size) {
+            if (m_options.limit > 0 && positionCount() >= m_options.limit) {
+                break;
+            }
+            Position pos;
+            if (!packed.unpack(&pos) || packed.result() > 2 || !addPosition(pos, quint8(packed.result()))) {
+                ++m_skipped;
+            }
+        }
+        return true;
+    }
+
+    while (!file.atEnd()) {
+        if (m_options.limit > 0 && positionCount() >= m_options.limit) {
+            break;
+        }
+        if (!addLine(file.readLine())) {
+            ++m_skipped;
+        }
+    }
+    return true;
+}
+
+bool Tuner::addLine(const QByteArray& line)
+{
+    const QString text = QString::fromLatin1(line).trimmed();
+    if (text.isEmpty() || text.startsWith('#')) {
+        return false;
+    }
+
+    // CSV 以逗號分隔 FEN 與結果；EPD 的 FEN 只有前四欄，其餘為操作碼
+    QString fenPart = text;
+    QString resultPart;
+    const int comma = text.indexOf(',');
+    if (comma >= 0) {
+        fenPart = text.left(comma);
+        resultPart = text.mid(comma + 1);
+    }
+    QStringList fields = fenPart.split(' ', Qt::SkipEmptyParts);
+    if (fields.size() < 4) {
+        return false;
+    }
+    if (comma < 0) {
+        resultPart = fields.mid(4).join(' ');
+    }
+    fields = fields.mid(0, 4);
+
+    quint8 result;
+    if (resultPart.contains("1/2")) {
+        result = 1;
+    } else if (resultPart.contains("1-0")) {
+        result = 2;
+    } else if (resultPart.contains("0-1")) {
+        result = 0;
+    } else {
+        QString number = resultPart;
+        number.remove('[').remove(']').remove('"').remove(';');
+        bool ok;
+        const double score = number.trimmed().toDouble(&ok);
+        if (!ok || score < 0.0 || score > 1.0) {
+            return false;
+        }
+        result = quint8(qRound(score * 2));
+    }
+
+    Position pos;
+    if (!pos.setFen(fields.join(' ') + " 0 1")) {
+        return false;
+    }
+    return addPosition(pos, result);
+}
+
+bool Tuner::addPosition(const Position& pos, quint8 result)
+{
+    // 被將軍的局面評估不可靠；四子以內由內建殘局庫處理，不使用這些參數
+    if (pos.inCheck() || pos.pieceCount() <= 4) {
+        return false;
+    }
+
+    Entry entry;
+    entry.offset = quint32(m_pieces.size());
+    entry.count = 0;
+    entry.result = result;
+    entry.flags = pos.sideToMove() == BLACK ? FLAG_BLACK_TO_MOVE : 0;
+    int phase = 0;
+
+    for (Color c : { WHITE, BLACK }) {
+        for (int k = PAWN; k <= KING; ++k) {
+            Bitboard b = pos.pieces(c, PieceKind(k));
+            phase += PhaseWeight[k] * popcount(b);
+            while (b) {
+                const int index = tableIndex(c, popLsb(b));
+                m_pieces.push_back(quint16(((c * PIECE_KIND_NB + k) << 6) | index));
+                ++entry.count;
+            }
+        }
+        if (pos.count(c, BISHOP) >= 2) {
+            entry.flags |= c == WHITE ? FLAG_WHITE_BISHOP_PAIR : FLAG_BLACK_BISHOP_PAIR;
+        }
+    }
+    entry.phase = quint8(qMin(phase, MaxPhase));
+
+    m_positions.push_back(entry);
+    return true;
+}
+
+size_t Tuner::memoryUsage() const
+{
+    return m_positions.size() * sizeof(Entry) + m_pieces.size() * sizeof(quint16);
+}
+
+// 白方角度的評估，與 Engine::evaluate() 相同但使用浮點參數
+double Tuner::evaluate(const Entry& entry, const double* params) const
+{
+    double mgScore = 0.0;
+    double egScore = 0.0;
+
+    const quint16* pieces = m_pieces.data() + entry.offset;
+    for (int i = 0; i < entry.count; ++i) {
+        const int piece = pieces[i] >> 6;
+        const int kind = piece % PIECE_KIND_NB;
+        const int pst = TERM_PST + kind * 64 + (pieces[i] & 63);
+        const double sign = piece < PIECE_KIND_NB ? 1.0 : -1.0;
+        mgScore += sign * (params[mg(TERM_MATERIAL + kind)] + params[mg(pst)]);
+        egScore += sign * (params[eg(TERM_MATERIAL + kind)] + params[eg(pst)]);
+    }
+
+    const double bishopPair = ((entry.flags & FLAG_WHITE_BISHOP_PAIR) ? 1.0 : 0.0)
+                            - ((entry.flags & FLAG_BLACK_BISHOP_PAIR) ? 1.0 : 0.0);
+    const double tempo = (entry.flags & FLAG_BLACK_TO_MOVE) ? -1.0 : 1.0;
+    mgScore += bishopPair * params[mg(TERM_BISHOP_PAIR)] + tempo * params[mg(TERM_TEMPO)];
+    egScore += bishopPair * params[eg(TERM_BISHOP_PAIR)] + tempo * params[eg(TERM_TEMPO)];
+
+    return (mgScore * entry.phase + egScore * (MaxPhase - entry.phase)) / MaxPhase;
+}
+
+double Tuner::errorSum(size_t begin, size_t end, double k, double* gradient) const
+{
+    const double* params = m_params.data();
+    const double scale = k * std::log(10.0) / 400.0;
+    double total = 0.0;
+
+    for (size_t i = begin; i < end; ++i) {
+        const Entry& entry = m_positions[i];
+        const double expected = sigmoid(k, evaluate(entry, params));
+        const double diff = entry.result * 0.5 - expected;
+        total += diff * diff;
+
+        if (!gradient) {
+            continue;
+        }
+
+        // d(diff^2)/d(eval) = -2 * diff * s * (1 - s) * scale，再乘上各參數在評估中的係數
+        const double d = -2.0 * diff * expected * (1.0 - expected) * scale;
+        const double dMg = d * entry.phase / MaxPhase;
+        const double dEg = d * (MaxPhase - entry.phase) / MaxPhase;
+
+        const quint16* pieces = m_pieces.data() + entry.offset;
+        for (int j = 0; j < entry.count; ++j) {
+            const int piece = pieces[j] >> 6;
+            const int kind = piece % PIECE_KIND_NB;
+            const int pst = TERM_PST + kind * 64 + (pieces[j] & 63);
+            const double sign = piece < PIECE_KIND_NB ? 1.0 : -1.0;
+            gradient[mg(TERM_MATERIAL + kind)] += sign * dMg;
+            gradient[eg(TERM_MATERIAL + kind)] += sign * dEg;
+            gradient[mg(pst)] += sign * dMg;
+            gradient[eg(pst)] += sign * dEg;
+        }
+
+        const double bishopPair = ((entry.flags & FLAG_WHITE_BISHOP_PAIR) ? 1.0 : 0.0)
+                                - ((entry.flags & FLAG_BLACK_BISHOP_PAIR) ? 1.0 : 0.0);
+        const double tempo = (entry.flags & FLAG_BLACK_TO_MOVE) ? -1.0 : 1.0;
+        gradient[mg(TERM_BISHOP_PAIR)] += bishopPair * dMg;
+        gradient[eg(TERM_BISHOP_PAIR)] += bishopPair * dEg;
+        gradient[mg(TERM_TEMPO)] += tempo * dMg;
+        gradient[eg(TERM_TEMPO)] += tempo * dEg;
+    }
+    return total;
+}
+
+// 把局面平均分給各執行緒，每個執行緒有自己的梯度緩衝區，最後再加總
+double Tuner::computeError(double k, std::vector<double>* gradient) const
+{
+    const size_t count = m_positions.size();
+    if (count == 0) {
+        return 0.0;
+    }
+
+    const int threadCount = int(qMin<size_t>(size_t(m_options.threads), count));
+    std::vector<double> sums(threadCount, 0.0);
+    std::vector<std::vector<double>> gradients(gradient ? threadCount : 0, std::vector<double>(PARAM_NB, 0.0));
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t) {
+        const size_t begin = count * t / threadCount;
+        const size_t end = count * (t + 1) / threadCount;
+        threads.emplace_back([this, t, begin, end, k, gradient, &sums, &gradients]() {
+            sums[t] = errorSum(begin, end, k, gradient ? gradients[t].data() : nullptr);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    double total = 0.0;
+    for (double sum : sums) {
+        total += sum;
+    }
+
+    if (gradient) {
+        gradient->assign(PARAM_NB, 0.0);
+        for (const std::vector<double>& partial : gradients) {
+            for (int i = 0; i < PARAM_NB; ++i) {
+                (*gradient)[i] += partial[i] / count;
+            }
+        }
+    }
+    return total / count;
+}
+
+double Tuner::error() const
+{
+    return computeError(m_k, nullptr);
+}
+
+// 黃金分割搜尋：找出讓目前參數誤差最小的 K
+double Tuner::fitK()
+{
+    const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+    double low = 0.1;
+    double high = 3.0;
+    double a = high - ratio * (high - low);
+    double b = low + ratio * (high - low);
+    double errorA = computeError(a, nullptr);
+    double errorB = computeError(b, nullptr);
+
+    for (int i = 0; i < 40; ++i) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            errorA = computeError(a, nullptr);
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            errorB = computeError(b, nullptr);
+        }
+    }
+
+    m_k = (low + high) / 2;
+    return m_k;
+}
+
+// Adam：每個參數有自己的步長，對稀有的位置表格子也能穩定收斂
+void Tuner::tune(const std::function<void(int, double)>& progress)
+{
+    if (m_k <= 0.0) {
+        fitK();
+    }
+
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+    const double epsilon = 1e-8;
+    std::vector<double> m(PARAM_NB, 0.0);
+    std::vector<double> v(PARAM_NB, 0.0);
+    std::vector<double> gradient;
+
+    for (int epoch = 1; epoch <= m_options.epochs; ++epoch) {
+        const double currentError = computeError(m_k, &gradient);
+
+        for (int i = 0; i < PARAM_NB; ++i) {
+            m[i] = beta1 * m[i] + (1.0 - beta1) * gradient[i];
+            v[i] = beta2 * v[i] + (1.0 - beta2) * gradient[i] * gradient[i];
+            const double mHat = m[i] / (1.0 - std::pow(beta1, epoch));
+            const double vHat = v[i] / (1.0 - std::pow(beta2, epoch));
+            m_params[i] -= m_options.learningRate * mHat / (std::sqrt(vHat) + epsilon);
+        }
+
+        // 國王沒有子力價值
+        m_params[mg(TERM_MATERIAL + KING)] = 0.0;
+        m_params[eg(TERM_MATERIAL + KING)] = 0.0;
+
+        if (progress) {
+            progress(epoch, currentError);
+        }
+    }
+
+    normalize();
+}
+
+// 子力價值與位置表可以互相抵換：把每張位置表的平均值移到子力價值，讓數字容易閱讀
+// 兵只計算第 2 到第 7 橫列；國王的位置表平均值在雙方之間抵消，不必處理
+void Tuner::normalize()
+{
+    for (int k = PAWN; k < KING; ++k) {
+        for (int phase = 0; phase < 2; ++phase) {
+            const int first = k == PAWN ? 8 : 0;
+            const int last = k == PAWN ? 56 : 64;
+            double sum = 0.0;
+            for (int sq = first; sq < last; ++sq) {
+                sum += m_params[2 * (TERM_PST + k * 64 + sq) + phase];
+            }
+            const double mean = sum / (last - first);
+            for (int sq = first; sq < last; ++sq) {
+                m_params[2 * (TERM_PST + k * 64 + sq) + phase] -= mean;
+            }
+            m_params[2 * (TERM_MATERIAL + k) + phase] += mean;
+        }
+    }
+}
+
+bool Tuner::writeHeader(const QString& path, const QString& source)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_errorString = QString("cannot write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    auto value = [this](int index) { return QString::number(qRound(m_params[index])); };
+
+    QTextStream out(&file);
+    out << "// 由 tools/tuner 產生，請勿手動修改\n";
+    out << "// " << source << "\n";
+    out << "#ifndef EVALPARAMS_H\n#define EVALPARAMS_H\n\n";
+    out << "// 評估參數：每一項分為開局（Mg）與殘局（Eg）兩個值，依剩餘子力線性漸變\n";
+    out << "// 位置表以白方視角、a8 在左上角書寫，順序為兵、馬、象、車、后、王\n";
+    out << "namespace Engine {\nnamespace EvalParams {\n\n";
+
+    for (int phase = 0; phase < 2; ++phase) {
+        const char* suffix = phase == 0 ? "Mg" : "Eg";
+        out << "const int Material" << suffix << "[6] = { ";
+        for (int k = 0; k < PIECE_KIND_NB; ++k) {
+            out << value(2 * (TERM_MATERIAL + k) + phase) << (k + 1 < PIECE_KIND_NB ? ", " : " };\n");
+        }
+    }
+    out << "\n";
+
+    for (int phase = 0; phase < 2; ++phase) {
+        out << "const int Pst" << (phase == 0 ? "Mg" : "Eg") << "[6][64] = {\n";
+        for (int k = 0; k < PIECE_KIND_NB; ++k) {
+            out << "    {   // " << PieceNames[k] << "\n";
+            for (int row = 0; row < 8; ++row) {
+                out << "       ";
+                for (int file = 0; file < 8; ++file) {
+                    const int sq = row * 8 + file;
+                    out << QString("%1").arg(value(2 * (TERM_PST + k * 64 + sq) + phase), 5)
+                        << (sq < 63 ? "," : "");
+                }
+                out << "\n";
+            }
+            out << (k + 1 < PIECE_KIND_NB ? "    },\n" : "    }\n");
+        }
+        out << "};\n\n";
+    }
+
+    out << "const int BishopPairMg = " << value(mg(TERM_BISHOP_PAIR)) << ";\n";
+    out << "const int BishopPairEg = " << value(eg(TERM_BISHOP_PAIR)) << ";\n";
+    out << "const int TempoMg = " << value(mg(TERM_TEMPO)) << ";\n";
+    out << "const int TempoEg = " << value(eg(TERM_TEMPO)) << ";\n\n";
+    out << "}\n}\n\n#endif // EVALPARAMS_H\n";
+    out.flush();
+
+    if (!file.commit()) {
+        m_errorString = QString("cannot write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include "position.h"
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <vector>
+
+// 參數索引：每一項有開局與殘局兩個值，分別位於 2 * term 與 2 * term + 1
+// 順序必須與 evalparams.h 及 Engine::evaluate() 一致
+enum TunerTerm {
+    TERM_MATERIAL = 0,
+    TERM_PST = TERM_MATERIAL + 6,
+    TERM_BISHOP_PAIR = TERM_PST + 6 * 64,
+    TERM_TEMPO,
+    TERM_NB
+};
+
+const int PARAM_NB = 2 * TERM_NB;
+
+struct TunerOptions {
+    int threads = 1;
+    int epochs = 500;
+    double learningRate = 1.0;  // 每步最多移動約這麼多分（Adam）
+    double k = 0.0;             // 0 表示由資料擬合
+    qint64 limit = 0;           // 最多讀入的局面數，0 表示不限
+};
+
+// Texel 式調校：以邏輯函數把評估分數換成預期得分，最小化與實際結果的均方誤差
+// 評估對參數是線性的（只有漸變係數與局面有關），梯度可以直接算出
+class Tuner {
+public:
+    explicit Tuner(const TunerOptions& options);
+
+    // 讀入 EPD 或 CSV；支援 "<FEN> c9 \"1-0\";"、"<FEN> [0.5]" 與 "<FEN>,1/2-1/2" 等寫法，結果為白方角度
+    // 副檔名為 .packed 時當作 tools/datagen 產生的 PackedPosition 資料
+    bool addFile(const QString& path);
+
+    qint64 positionCount() const { return qint64(m_positions.size()); }
+    qint64 skippedCount() const { return m_skipped; }
+    size_t memoryUsage() const;
+
+    double fitK();
+    double k() const { return m_k; }
+    double error() const;
+
+    // 每個 epoch 後呼叫 progress(epoch, error)
+    void tune(const std::function<void(int, double)>& progress);
+
+    bool writeHeader(const QString& path, const QString& source);
+    QString errorString() const { return m_errorString; }
+
+private:
+    // 每個局面 8 位元組，棋子另外以每子 2 位元組存在共用陣列中
+    struct Entry {
+        quint32 offset;  // m_pieces 中的起點
+        quint8 count;
+        quint8 phase;    // 0（只剩兵）到 24（開局）
+        quint8 result;   // 白方角度：0 負、1 和、2 勝
+        quint8 flags;
+    };
+
+    TunerOptions m_options;
+    std::vector<Entry> m_positions;
+    std::vector<quint16> m_pieces;  // (棋子 << 6) | 位置表索引
+    std::vector<double> m_params;
+    double m_k;
+    qint64 m_skipped;
+    QString m_errorString;
+
+    bool addLine(const QByteArray& line);
+    bool addPosition(const Engine::Position& pos, quint8 result);
+    double evaluate(const Entry& entry, const double* params) const;
+    // 回傳誤差總和；gradient 不為空時累加誤差對參數的偏導數
+    double errorSum(size_t begin, size_t end, double k, double* gradient) const;
+    double computeError(double k, std::vector<double>* gradient) const;
+    void normalize();
+};
+
+#endif // TUNER_H
@@ -0,0 +1,25 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = tuner
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    tuner.cpp \
+    ../../bitboard.cpp \
+    ../../position.cpp \
+    ../../packedposition.cpp
+
+HEADERS += \
+    tuner.h \
+    ../../bitboard.h \
+    ../../position.h \
+    ../../packedposition.h \
+    ../../evalparams.h
+
+unix: LIBS += -lpthread
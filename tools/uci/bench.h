@@ -0,0 +1,17 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <QStringList>
+
+// 基準測試用的固定局面：開局、中局、殘局，以及將死/逼和等沒有著法的局面
+// 固定深度搜尋全部局面的總節點數可當作搜尋行為的指紋，搜尋有任何改變時都會不同
+namespace Bench {
+
+// 預設深度：一般電腦上單執行緒數秒內完成
+const int DefaultDepth = 11;
+
+const QStringList& positions();
+
+}
+
+#endif // BENCH_H
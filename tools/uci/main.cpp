@@ -0,0 +1,18 @@
+#include <QCoreApplication>
+#include "uciloop.h"
+#include "bench.h"
+
+// 以 UCI 協定（標準輸入/輸出）提供內建引擎，可接到任何支援 UCI 的介面、對戰或測試工具
+// chess-uci bench [depth]：執行基準測試後結束
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("chess-uci");
+
+    UciLoop loop;
+    const QStringList args = QCoreApplication::arguments();
+    if (args.size() > 1 && args[1] == "bench") {
+        return loop.bench(args.size() > 2 ? args[2].toInt() : Bench::DefaultDepth);
+    }
+    return loop.run();
+}
@@ -0,0 +1,302 @@
+#include "uciloop.h"
+#include "bench.h"
+#include "nnue.h"
+#include "syzygy.h"
+#include <QElapsedTimer>
+#include <iostream>
+#include <string>
+
+using namespace Engine;
+
+namespace {
+
+const char* EngineName = "Chess built-in engine";
+
+// 取出 name/value 之間的字串（選項名稱可能含空白，例如 "Clear Hash"）
+QString joinTokens(const QStringList& tokens, int from, int to)
+{
+    return tokens.mid(from, to - from).join(' ');
+}
+
+}
+
+UciLoop::UciLoop()
+    : m_multiPv(1)
+    , m_skillLevel(MAX_SKILL_LEVEL)
+{
+    m_position.setFen(Position::StartFen);
+    m_search.setInfoCallback([this](const SearchInfo& info) { sendInfo(info); });
+}
+
+int UciLoop::run()
+{
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        const QStringList tokens = QString::fromStdString(line).split(' ', Qt::SkipEmptyParts);
+        if (tokens.isEmpty()) {
+            continue;
+        }
+
+        const QString command = tokens.first();
+        if (command == "uci") {
+            onUci();
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "setoption") {
+            onSetOption(tokens);
+        } else if (command == "ucinewgame") {
+            m_search.stop();
+            m_search.clearHash();
+        } else if (command == "position") {
+            onPosition(tokens);
+        } else if (command == "go") {
+            onGo(tokens);
+        } else if (command == "stop") {
+            m_search.stop();
+        } else if (command == "ponderhit") {
+            m_search.ponderhit();
+        } else if (command == "quit") {
+            break;
+        } else if (command == "d") {
+            send(m_position.fen());
+        } else if (command == "bench") {
+            m_search.stop();
+            bench(tokens.size() > 1 ? tokens[1].toInt() : Bench::DefaultDepth);
+        } else {
+            send("info string unknown command: " + command);
+        }
+    }
+
+    m_search.stop();
+    m_search.wait();
+    return 0;
+}
+
+int UciLoop::bench(int depth)
+{
+    depth = depth > 0 ? depth : Bench::DefaultDepth;
+
+    // 每個局面都從空的置換表開始，節點數才不受先前局面影響；
+    // 執行緒數與置換表大小沿用目前設定，只有單執行緒時節點數才固定
+    m_search.wait();
+    m_search.setInfoCallback(nullptr);
+
+    const QStringList& fens = Bench::positions();
+    SearchStats total;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < fens.size(); ++i) {
+        Position pos;
+        if (!pos.setFen(fens[i])) {
+            send(QString("info string invalid bench position: %1").arg(fens[i]));
+            continue;
+        }
+
+        m_search.clearHash();
+        SearchLimits limits;
+        limits.depth = depth;
+        Move best = MOVE_NONE;
+        m_search.start(pos, limits, [&best](Move bestMove, Move) { best = bestMove; });
+        m_search.wait();
+
+        const SearchStats stats = m_search.stats();
+        total.nodes += stats.nodes;
+        total.ttProbes += stats.ttProbes;
+        total.ttHits += stats.ttHits;
+        total.betaCutoffs += stats.betaCutoffs;
+        total.firstMoveCutoffs += stats.firstMoveCutoffs;
+
+        send(QString("Position %1/%2: %3").arg(i + 1).arg(fens.size()).arg(fens[i]));
+        send(QString("  nodes %1 time %2 ms bestmove %3")
+                 .arg(stats.nodes)
+                 .arg(stats.time)
+                 .arg(best == MOVE_NONE ? QString("(none)") : pos.moveToUci(best)));
+    }
+
+    const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+    send("===========================");
+    send(QString("Total time (ms) : %1").arg(elapsed));
+    send(QString("Nodes searched  : %1").arg(total.nodes));
+    send(QString("Nodes/second    : %1").arg(total.nodes * 1000 / quint64(elapsed)));
+    send(QString("TT hit rate     : %1%").arg(total.ttHitRate() * 100, 0, 'f', 1));
+    send(QString("First-move cuts : %1%").arg(total.firstMoveCutoffRate() * 100, 0, 'f', 1));
+
+    m_search.setInfoCallback([this](const SearchInfo& info) { sendInfo(info); });
+    return 0;
+}
+
+void UciLoop::send(const QString& line)
+{
+    // 搜尋執行緒也會輸出 info 與 bestmove，整行寫出避免交錯
+    std::lock_guard<std::mutex> lock(m_outputMutex);
+    std::cout << line.toStdString() << std::endl;
+}
+
+void UciLoop::onUci()
+{
+    send(QString("id name %1").arg(EngineName));
+    send("id author Chess project");
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name Ponder type check default false");
+    send("option name Threads type spin default 1 min 1 max 256");
+    send("option name MultiPV type spin default 1 min 1 max 256");
+    send(QString("option name Skill Level type spin default %1 min 0 max %1").arg(MAX_SKILL_LEVEL));
+    send("option name Clear Hash type button");
+    send("option name SyzygyPath type string default <empty>");
+    send("option name EvalFile type string default <empty>");
+    send("uciok");
+}
+
+void UciLoop::onSetOption(const QStringList& tokens)
+{
+    const int nameIndex = tokens.indexOf("name");
+    const int valueIndex = tokens.indexOf("value");
+    if (nameIndex < 0) {
+        return;
+    }
+
+    const QString name = joinTokens(tokens, nameIndex + 1, valueIndex < 0 ? tokens.size() : valueIndex).toLower();
+    const QString value = valueIndex < 0 ? QString() : joinTokens(tokens, valueIndex + 1, tokens.size());
+
+    // 變更設定前先停止搜尋，Search 的設定函式會等待搜尋結束
+    m_search.stop();
+    if (name == "hash") {
+        m_search.setHashSize(value.toInt());
+    } else if (name == "threads") {
+        m_search.setThreads(value.toInt());
+    } else if (name == "multipv") {
+        m_multiPv = qBound(1, value.toInt(), 256);
+    } else if (name == "skill level") {
+        m_skillLevel = qBound(0, value.toInt(), MAX_SKILL_LEVEL);
+    } else if (name == "clear hash") {
+        m_search.clearHash();
+    } else if (name == "ponder") {
+        // 只是告知 GUI 支援 go ponder，本身不需要處理
+    } else if (name == "syzygypath") {
+        // 重新掃描會釋放舊的表格，要等搜尋執行緒都結束
+        m_search.wait();
+        const int count = Syzygy::init(value == "<empty>" ? QString() : value);
+        send(QString("info string found %1 tablebases").arg(count));
+    } else if (name == "evalfile") {
+        // 換網路前要等搜尋結束；空字串改回傳統評估
+        m_search.wait();
+        QString error;
+        if (value.isEmpty() || value == "<empty>") {
+            NNUE::unload();
+            send("info string using classical evaluation");
+        } else if (NNUE::load(value, &error)) {
+            send(QString("info string loaded network %1 (%2 hidden, %3)")
+                     .arg(value).arg(NNUE::hiddenSize()).arg(NNUE::simdName()));
+        } else {
+            send(QString("info string failed to load network: %1").arg(error));
+        }
+        m_search.clearHash();
+    } else {
+        send("info string unknown option: " + name);
+    }
+}
+
+void UciLoop::onPosition(const QStringList& tokens)
+{
+    const int movesIndex = tokens.indexOf("moves");
+    const int end = movesIndex < 0 ? tokens.size() : movesIndex;
+
+    Position pos;
+    if (tokens.size() >= 2 && tokens[1] == "startpos") {
+        pos.setFen(Position::StartFen);
+    } else if (tokens.size() >= 3 && tokens[1] == "fen") {
+        if (!pos.setFen(joinTokens(tokens, 2, end))) {
+            send("info string invalid fen");
+            return;
+        }
+    } else {
+        return;
+    }
+
+    // 逐步走子保留歷史，讓搜尋能看到之前的局面
+    if (movesIndex >= 0) {
+        for (int i = movesIndex + 1; i < tokens.size(); ++i) {
+            const Move move = pos.parseUciMove(tokens[i]);
+            if (move == MOVE_NONE) {
+                send("info string illegal move: " + tokens[i]);
+                break;
+            }
+            pos.doMove(move);
+        }
+    }
+
+    m_search.stop();
+    m_search.wait();
+    m_position = pos;
+}
+
+void UciLoop::onGo(const QStringList& tokens)
+{
+    SearchLimits limits;
+    limits.multiPv = m_multiPv;
+    limits.skillLevel = m_skillLevel;
+    for (int i = 1; i < tokens.size(); ++i) {
+        const QString& token = tokens[i];
+        const QString next = i + 1 < tokens.size() ? tokens[i + 1] : QString();
+
+        if (token == "infinite") {
+            limits.infinite = true;
+        } else if (token == "ponder") {
+            limits.ponder = true;
+        } else if (token == "depth") {
+            limits.depth = next.toInt();
+            ++i;
+        } else if (token == "movetime") {
+            limits.movetime = next.toInt();
+            ++i;
+        } else if (token == "wtime") {
+            limits.time[WHITE] = next.toInt();
+            ++i;
+        } else if (token == "btime") {
+            limits.time[BLACK] = next.toInt();
+            ++i;
+        } else if (token == "winc") {
+            limits.inc[WHITE] = next.toInt();
+            ++i;
+        } else if (token == "binc") {
+            limits.inc[BLACK] = next.toInt();
+            ++i;
+        } else if (token == "movestogo") {
+            limits.movestogo = next.toInt();
+            ++i;
+        } else if (token == "nodes") {
+            limits.nodes = next.toULongLong();
+            ++i;
+        }
+    }
+
+    m_search.stop();
+    m_search.wait();
+
+    const Position root = m_position;
+    m_search.start(root, limits, [this, root](Move bestMove, Move ponderMove) {
+        QString line = "bestmove " + (bestMove == MOVE_NONE ? QString("0000") : root.moveToUci(bestMove));
+        if (ponderMove != MOVE_NONE) {
+            line += " ponder " + root.moveToUci(ponderMove);
+        }
+        send(line);
+    });
+}
+
+void UciLoop::sendInfo(const SearchInfo& info)
+{
+    QString line = QString("info depth %1 seldepth %2 multipv %3 score %4 nodes %5 nps %6 hashfull %7 time %8 pv")
+                       .arg(info.depth)
+                       .arg(info.selDepth)
+                       .arg(info.multiPv)
+                       .arg(Search::scoreToUci(info.score))
+                       .arg(info.nodes)
+                       .arg(info.time > 0 ? info.nodes * 1000 / quint64(info.time) : info.nodes)
+                       .arg(info.hashfull)
+                       .arg(info.time);
+    for (Move move : info.pv) {
+        line += ' ' + m_position.moveToUci(move);
+    }
+    send(line);
+}
@@ -0,0 +1,38 @@
+#ifndef UCILOOP_H
+#define UCILOOP_H
+
+#include "position.h"
+#include "search.h"
+#include <QString>
+#include <QStringList>
+#include <mutex>
+
+// UCI 指令迴圈：主執行緒讀取標準輸入，搜尋在 Engine::Search 的背景執行緒進行，
+// 因此搜尋中仍能即時處理 stop、isready 與 quit
+class UciLoop {
+public:
+    UciLoop();
+
+    int run();
+
+    // 以固定深度搜尋內建局面並印出節點數、時間與 nps；回傳值供 main() 作為結束代碼
+    int bench(int depth);
+
+private:
+    Engine::Search m_search;
+    Engine::Position m_position;
+    std::mutex m_outputMutex;
+    int m_multiPv;
+    int m_skillLevel;
+
+    void send(const QString& line);
+
+    void onUci();
+    void onSetOption(const QStringList& tokens);
+    void onPosition(const QStringList& tokens);
+    void onGo(const QStringList& tokens);
+
+    void sendInfo(const Engine::SearchInfo& info);
+};
+
+#endif // UCILOOP_H
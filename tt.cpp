@@ -0,0 +1,101 @@
+#include "tt.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace Engine {
+
+TranspositionTable::TranspositionTable()
+    : m_table(nullptr)
+    , m_clusterCount(0)
+    , m_generation(0)
+{
+    resize(16);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    std::free(m_table);
+}
+
+void TranspositionTable::resize(int megabytes)
+{
+    std::free(m_table);
+    m_clusterCount = qMax<size_t>(1, size_t(qMax(1, megabytes)) * 1024 * 1024 / sizeof(Cluster));
+    m_table = static_cast<Cluster*>(std::malloc(m_clusterCount * sizeof(Cluster)));
+    if (!m_table) {
+        // 記憶體不足時退回最小的表格，搜尋仍可進行
+        m_clusterCount = 1024;
+        m_table = static_cast<Cluster*>(std::malloc(m_clusterCount * sizeof(Cluster)));
+    }
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    std::memset(m_table, 0, m_clusterCount * sizeof(Cluster));
+    m_generation = 0;
+}
+
+TTEntry* TranspositionTable::probe(quint64 key, bool& found) const
+{
+    TTEntry* const entries = clusterOf(key)->entries;
+    const quint16 key16 = quint16(key >> 48);
+
+    for (int i = 0; i < 3; ++i) {
+        if (entries[i].key16 == key16 && entries[i].bound() != BOUND_NONE) {
+            // 命中時更新世代，避免仍在使用的項目被取代
+            entries[i].genBound = quint8(m_generation | entries[i].bound());
+            found = true;
+            return &entries[i];
+        }
+        if (entries[i].bound() == BOUND_NONE) {
+            found = false;
+            return &entries[i];
+        }
+    }
+
+    // 取代深度最淺、世代最舊的項目
+    TTEntry* replace = &entries[0];
+    for (int i = 1; i < 3; ++i) {
+        const int replaceAge = quint8(m_generation - (replace->genBound & 0xFC));
+        const int age = quint8(m_generation - (entries[i].genBound & 0xFC));
+        if (replace->depth - replaceAge > entries[i].depth - age) {
+            replace = &entries[i];
+        }
+    }
+    found = false;
+    return replace;
+}
+
+void TranspositionTable::save(TTEntry* entry, quint64 key, int value, int eval, int depth, Bound bound, Move move)
+{
+    const quint16 key16 = quint16(key >> 48);
+
+    // 沒有新著法時保留舊的著法
+    if (move != MOVE_NONE || entry->key16 != key16) {
+        entry->move = move;
+    }
+
+    // 較淺的非精確結果不覆蓋同一局面較深的結果
+    if (bound == BOUND_EXACT || entry->key16 != key16 || depth + 4 > entry->depth) {
+        entry->key16 = key16;
+        entry->value = qint16(value);
+        entry->eval = qint16(eval);
+        entry->depth = qint8(qBound(-128, depth, 127));
+        entry->genBound = quint8(m_generation | bound);
+    }
+}
+
+int TranspositionTable::hashfull() const
+{
+    const size_t samples = qMin<size_t>(1000, m_clusterCount);
+    int used = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        for (const TTEntry& entry : m_table[i].entries) {
+            used += (entry.genBound & 0xFC) == m_generation && entry.genBound & 3;
+        }
+    }
+    return int(used * 1000 / (samples * 3));
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef TT_H
+#define TT_H
+
+#include "position.h"
+
+namespace Engine {
+
+enum Bound { BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3 };
+
+// 置換表項目：10 位元組，三個一組剛好放進 32 位元組
+// 多執行緒同時讀寫時不加鎖；讀到不一致的資料只會造成一次錯誤的剪枝，著法使用前一律再檢查合法性
+struct TTEntry {
+    quint16 key16;
+    Move move;
+    qint16 value;
+    qint16 eval;
+    qint8 depth;
+    quint8 genBound;  // 高 6 位元為世代、低 2 位元為 Bound
+
+    Bound bound() const { return Bound(genBound & 3); }
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+
+    void resize(int megabytes);  // 會清除內容
+    void clear();
+    void newSearch() { m_generation += 4; }  // 每次搜尋開始時呼叫，讓舊項目優先被取代
+
+    // 找到時 found 為 true；否則回傳應該寫入的項目
+    TTEntry* probe(quint64 key, bool& found) const;
+    void save(TTEntry* entry, quint64 key, int value, int eval, int depth, Bound bound, Move move);
+
+    int hashfull() const;  // 千分比，取前 1000 組估計
+
+private:
+    struct Cluster {
+        TTEntry entries[3];
+        char padding[2];
+    };
+
+    Cluster* m_table;
+    size_t m_clusterCount;
+    quint8 m_generation;
+
+    Cluster* clusterOf(quint64 key) const
+    {
+        // 以乘法取高位，不需要叢集數為 2 的冪次
+        return m_table + size_t((quint64(quint32(key)) * quint64(m_clusterCount)) >> 32);
+    }
+};
+
+}
+
+#endif // TT_H
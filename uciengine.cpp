@@ -1,230 +1,967 @@
 #include "uciengine.h"
+#include "uciengineio.h"
+#include "position.h"
 #include <QDebug>
 #include <QCoreApplication>
 #include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// 分析更新的最短間隔（毫秒），約為畫面的更新率
+static const int ANALYSIS_INTERVAL_MS = 16;
+
+// 追蹤的主變化條數上限（m_analysisDirty 的位元數）
+static const int MAX_MULTI_PV = 64;
+
+// 監看：超過這些時間沒有回應就視為當掉（毫秒）
+static const int HANDSHAKE_TIMEOUT_MS = 10000;  // uciok 與握手的 readyok（大的置換表配置需要時間）
+static const int READY_TIMEOUT_MS = 10000;      // 其他 isready（ucinewgame 會清除置換表）
+static const int STOP_TIMEOUT_MS = 5000;        // stop 之後的 bestmove
+static const int SEARCH_GRACE_MS = 5000;        // 搜尋的時間預算之外再等的時間
+
+// 連續失敗幾次後放棄；第 n 次重新啟動前等待 RESTART_DELAY_MS * 2^(n-1)
+static const int MAX_RESTARTS = 3;
+static const int RESTART_DELAY_MS = 500;
+
+// 沒有 movestogo 時假設還要走的步數；引擎在難的局面可能用到平均分配的幾倍
+static const int DEFAULT_MOVES_TO_GO = 20;
+static const int MOVE_TIME_OVERRUN = 3;
+
+// 這一步最多可以想多久：棋鐘時是每步的平均分配（剩餘時間 / 剩餘步數 + 加秒）乘上 MOVE_TIME_OVERRUN，
+// 不超過剩餘時間；另有每步時間時取較小者，只限深度或節點時為 0（不限）
+static int searchBudget(const Engine::SearchLimits& limits, int side)
+{
+    int budget = limits.movetime;
+    const int time = limits.time[side];
+    if (time > 0) {
+        const int movesToGo = limits.movestogo > 0 ? limits.movestogo : DEFAULT_MOVES_TO_GO;
+        const qint64 allocation = (qint64(time) / movesToGo + limits.inc[side]) * MOVE_TIME_OVERRUN;
+        const int clocked = int(qMin<qint64>(time, allocation));
+        if (budget == 0 || clocked < budget) {
+            budget = clocked;
+        }
+    }
+    return budget;
+}
 
 UCIEngine::UCIEngine(QObject *parent)
     : QObject(parent),
-      m_process(nullptr),
-      m_isReady(false),
-      m_skillLevel(10)
+      m_ioThread(new QThread(this)),
+      m_io(new UCIEngineIO(&m_lines)),
+      m_processRunning(false),
+      m_state(State::NotRunning),
+      m_discardBestMove(false),
+      m_pondering(false),
+      m_ponderSearch(false),
+      m_searchSide(Engine::WHITE),
+      m_searchStartedAt(0),
+      m_watchdog(new QTimer(this)),
+      m_restartTimer(new QTimer(this)),
+      m_restartCount(0),
+      m_analysis(MAX_MULTI_PV),
+      m_analysisDirty(0),
+      m_analysisTimer(new QTimer(this)),
+      m_logNext(0)
 {
+    m_analysisTimer->setSingleShot(true);
+    m_analysisTimer->setInterval(ANALYSIS_INTERVAL_MS);
+    connect(m_analysisTimer, &QTimer::timeout, this, &UCIEngine::flushAnalysis);
+    m_watchdog->setSingleShot(true);
+    connect(m_watchdog, &QTimer::timeout, this, &UCIEngine::onWatchdogTimeout);
+    m_restartTimer->setSingleShot(true);
+    connect(m_restartTimer, &QTimer::timeout, this, &UCIEngine::startProcess);
+    m_clock.start();
+
+    // 管線 I/O 在自己的執行緒：引擎大量輸出時 GUI 執行緒只在佇列有內容時被喚醒一次，批次取出
+    m_io->moveToThread(m_ioThread);
+    connect(m_io, &UCIEngineIO::started, this, &UCIEngine::onStarted);
+    connect(m_io, &UCIEngineIO::linesAvailable, this, &UCIEngine::onLinesAvailable);
+    connect(m_io, &UCIEngineIO::errorOccurred, this, &UCIEngine::onErrorOccurred);
+    connect(m_io, &UCIEngineIO::finished, this, &UCIEngine::onFinished);
+    m_ioThread->setObjectName("UCIEngineIO");
+    m_ioThread->start();
 }
 
 UCIEngine::~UCIEngine()
 {
-    if (m_process) {
-        m_process->write("quit\n");
-        m_process->waitForFinished(1000);
-        delete m_process;
-    }
+    // I/O 執行緒可能正等著佇列騰出空間，先讓它放棄再同步結束程序
+    m_io->abort();
+    UCIEngineIO* io = m_io;
+    QMetaObject::invokeMethod(m_io, [io]() { io->shutdown(); }, Qt::BlockingQueuedConnection);
+    m_ioThread->quit();
+    m_ioThread->wait();
+    delete m_io;
 }
 
 bool UCIEngine::initialize(const QString& enginePath)
 {
-    if (m_process) {
-        delete m_process;
-    }
-
-    m_process = new QProcess(this);
-    
-    connect(m_process, &QProcess::readyReadStandardOutput, this, &UCIEngine::onReadyRead);
-    connect(m_process, &QProcess::errorOccurred, this, &UCIEngine::onErrorOccurred);
-
-    // 啟動引擎
-    m_process->start(enginePath);
-    
-    if (!m_process->waitForStarted(3000)) {
-        qDebug() << "Failed to start engine:" << enginePath;
-        emit engineError("Failed to start engine");
+    if (!QFileInfo::exists(enginePath)) {
+        qDebug() << "Engine not found:" << enginePath;
         return false;
     }
 
-    // 發送 UCI 初始化命令
-    sendCommand("uci");
-    
-    // 等待 uciok 回應
-    m_process->waitForReadyRead(2000);
-    
-    // 設定選項
-    sendCommand(QString("setoption name Skill Level value %1").arg(m_skillLevel));
-    sendCommand("isready");
-    
+    // 舊的程序由 I/O 執行緒結束
+    m_enginePath = enginePath;
+    m_restartTimer->stop();
+    m_restartCount = 0;
+    m_processRunning = false;
+    m_pendingCommands.clear();
+    m_readyCallbacks.clear();
+    m_options.clear();
+    m_discardBestMove = false;
+    resetPonder();
+    m_analysisDirty = 0;
+
+    setState(State::Starting);
+    startProcess();
     return true;
 }
 
+bool UCIEngine::restart()
+{
+    return !m_enginePath.isEmpty() && initialize(m_enginePath);
+}
+
+void UCIEngine::startProcess()
+{
+    UCIEngineIO* io = m_io;
+    const QString path = m_enginePath;
+    QMetaObject::invokeMethod(m_io, [io, path]() { io->start(path); }, Qt::QueuedConnection);
+}
+
+void UCIEngine::newGame()
+{
+    stop();
+    m_ponderMove.clear();
+    if (isAvailable()) {
+        // 規範要求 ucinewgame 之後以 isready 等待引擎清除狀態，下一個搜尋等到 readyok 才送出
+        enqueueCommand("ucinewgame");
+        enqueueCommand("isready");
+    }
+}
+
 void UCIEngine::setSkillLevel(int level)
 {
     // Stockfish 技能等級範圍 0-20
-    m_skillLevel = qBound(0, level, 20);
-    
-    if (m_process && m_process->state() == QProcess::Running) {
-        sendCommand(QString("setoption name Skill Level value %1").arg(m_skillLevel));
-        sendCommand("isready");
+    setOption("Skill Level", QString::number(qBound(0, level, 20)));
+}
+
+void UCIEngine::setOption(const QString& name, const QString& value)
+{
+    // button 是一次性的動作（例如 Clear Hash），不記下來，握手完成前按下則忽略
+    const Option* option = findOption(name);
+    if (option && option->type == "button") {
+        enqueueCommand(optionCommand(option->name, value));
+        return;
+    }
+
+    const QString key = option ? option->name : name;
+    if (m_optionValues.contains(key) && m_optionValues.value(key) == value) {
+        return;
+    }
+    m_optionValues.insert(key, value);
+
+    // 還沒收到 uciok 時不知道引擎支援哪些選項，握手時再一起送出
+    if (m_state == State::NotRunning || m_state == State::Starting || m_state == State::WaitingUciOk) {
+        return;
+    }
+    const QString command = optionCommand(key, value);
+    if (!command.isEmpty()) {
+        enqueueCommand(command);
+    }
+}
+
+void UCIEngine::resetOption(const QString& name)
+{
+    const Option* option = findOption(name);
+    if (!option) {
+        m_optionValues.remove(name);
+        return;
+    }
+    if (option->type != "button") {
+        setOption(option->name, option->defaultValue);
+    }
+}
+
+const UCIEngine::Option* UCIEngine::findOption(const QString& name) const
+{
+    // UCI 規定選項名稱不分大小寫
+    for (const Option& option : m_options) {
+        if (option.name.compare(name, Qt::CaseInsensitive) == 0) {
+            return &option;
+        }
+    }
+    return nullptr;
+}
+
+QString UCIEngine::optionCommand(const QString& name, const QString& value) const
+{
+    const Option* option = findOption(name);
+    if (!option) {
+        qDebug() << "Engine has no option" << name;
+        return QString();
+    }
+
+    QString command = "setoption name " + option->name;
+    if (option->type == "spin") {
+        command += " value " + QString::number(qBound(option->min, value.toInt(), option->max));
+    } else if (option->type != "button") {
+        command += " value " + value;
+    }
+    return command;
+}
+
+int UCIEngine::defaultThreads()
+{
+    return qMax(1, QThread::idealThreadCount() - 1);
+}
+
+int UCIEngine::defaultHashMb()
+{
+    quint64 available = 0;
+#ifdef Q_OS_WIN
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        available = status.ullAvailPhys;
+    }
+#elif defined(_SC_AVPHYS_PAGES)
+    const long pages = sysconf(_SC_AVPHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) {
+        available = quint64(pages) * quint64(pageSize);
+    }
+#elif defined(_SC_PHYS_PAGES)
+    // 沒有可用記憶體的資訊時以實體記憶體的一半估計
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) {
+        available = quint64(pages) * quint64(pageSize) / 2;
+    }
+#endif
+
+    const quint64 budget = available / 8 / (1024 * 1024);
+    int hash = 16;
+    while (hash < 4096 && quint64(hash) * 2 <= budget) {
+        hash *= 2;
     }
+    return hash;
 }
 
-void UCIEngine::getBestMove(ChessBoard* board, PieceColor color)
+void UCIEngine::getBestMove(ChessBoard* board, const Engine::SearchLimits& limits)
 {
-    if (!m_process || m_process->state() != QProcess::Running || !m_isReady) {
+    if (!isAvailable()) {
         emit engineError("Engine not ready");
         return;
     }
 
-    // 建立 FEN 字串
-    QString fen = boardToFEN(board, color);
-    
     // 發送位置和計算命令
-    sendCommand("position fen " + fen);
-    sendCommand("go movetime 1000");  // 思考 1 秒
+    const int side = board->getCurrentTurn() == PieceColor::WHITE ? Engine::WHITE : Engine::BLACK;
+    enqueueSearch(positionCommand(board), limits, side);
 }
 
 void UCIEngine::stop()
 {
-    if (m_process) {
-        sendCommand("stop");
+    // 還沒送出的搜尋直接取消
+    for (int i = m_pendingCommands.size() - 1; i >= 0; --i) {
+        const QString& command = m_pendingCommands[i].command;
+        if (command.startsWith("position ") || command.startsWith("go")) {
+            m_pendingCommands.removeAt(i);
+        }
+    }
+
+    m_pondering = false;
+    if (m_state == State::Searching) {
+        m_discardBestMove = true;
+        writeCommand("stop");
+        setState(State::Stopping);
     }
 }
 
-void UCIEngine::sendCommand(const QString& command)
+bool UCIEngine::ponder(const Engine::SearchLimits& limits)
 {
-    if (m_process && m_process->state() == QProcess::Running) {
-        qDebug() << "UCI >>" << command;
-        m_process->write((command + "\n").toUtf8());
-        m_process->waitForBytesWritten();
+    if (!isAvailable() || m_ponderMove.isEmpty()) {
+        return false;
     }
+
+    // 上一次搜尋的局面接上引擎走的著法與預測的應著
+    m_ponderPosition = m_searchPosition + (m_searchPosition.contains(" moves ") ? " " : " moves ")
+                     + m_bestMove + " " + m_ponderMove;
+    m_ponderMove.clear();
+    m_pondering = true;
+
+    // 走完預測的應著後又輪到上一次搜尋的一方
+    Engine::SearchLimits ponderLimits = limits;
+    ponderLimits.ponder = true;
+    enqueueSearch(m_ponderPosition, ponderLimits, m_searchSide);
+    return true;
 }
 
-void UCIEngine::onReadyRead()
+bool UCIEngine::ponderHit(const ChessBoard* board)
 {
-    while (m_process->canReadLine()) {
-        QString line = QString::fromUtf8(m_process->readLine()).trimmed();
-        processLine(line);
+    if (!m_pondering) {
+        return false;
+    }
+    if (positionCommand(board) != m_ponderPosition) {
+        stop();
+        return false;
+    }
+
+    m_pondering = false;
+    if (m_ponderSearch) {
+        // 時間預算從 ponderhit 起算
+        m_ponderSearch = false;
+        m_searchLimits.ponder = false;
+        m_searchStartedAt = m_clock.elapsed();
+        writeCommand("ponderhit");
+        updateWatchdog();
+        return true;
+    }
+    // go ponder 還在佇列中（例如等待 readyok）：改為一般的搜尋
+    for (PendingCommand& pending : m_pendingCommands) {
+        if (pending.command.startsWith("go ponder")) {
+            pending.limits.ponder = false;
+            pending.command = goCommand(pending.limits);
+            return true;
+        }
+    }
+    return false;
+}
+
+void UCIEngine::resetPonder()
+{
+    m_searchPosition.clear();
+    m_bestMove.clear();
+    m_ponderMove.clear();
+    m_pondering = false;
+    m_ponderSearch = false;
+}
+
+void UCIEngine::sync(std::function<void()> onReady)
+{
+    enqueueCommand("isready", onReady);
+}
+
+void UCIEngine::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        updateWatchdog();
+        emit stateChanged(state);
+    }
+}
+
+void UCIEngine::enqueueCommand(const QString& command, std::function<void()> onReady)
+{
+    m_pendingCommands.enqueue({ command, onReady });
+    flushCommands();
+}
+
+void UCIEngine::enqueueSearch(const QString& position, const Engine::SearchLimits& limits, int side,
+                              qint64 startedAt)
+{
+    m_pendingCommands.enqueue({ position, nullptr });
+    PendingCommand go = { goCommand(limits), nullptr };
+    go.limits = limits;
+    go.side = side;
+    go.startedAt = startedAt;
+    m_pendingCommands.enqueue(go);
+    flushCommands();
+}
+
+void UCIEngine::flushCommands()
+{
+    // 一次只進行一個搜尋：送出 go 之後其餘命令等到 bestmove
+    // isready 也是一道屏障：之後的命令等到對應的 readyok（例如 ucinewgame 之後的搜尋）
+    while (m_state == State::Idle && m_readyCallbacks.isEmpty() && !m_pendingCommands.isEmpty()) {
+        PendingCommand pending = m_pendingCommands.dequeue();
+        if (pending.startedAt >= 0) {
+            // 重新啟動前被中斷的搜尋：已經想過的時間從棋鐘與每步時間扣掉
+            const int elapsed = int(m_clock.elapsed() - pending.startedAt);
+            Engine::SearchLimits& limits = pending.limits;
+            if (limits.time[pending.side] > 0) {
+                limits.time[pending.side] = qMax(1, limits.time[pending.side] - elapsed);
+            }
+            if (limits.movetime > 0) {
+                limits.movetime = qMax(1, limits.movetime - elapsed);
+            }
+            pending.command = goCommand(limits);
+        }
+        writeCommand(pending.command, pending.onReady);
+        if (pending.command.startsWith("position ")) {
+            m_searchPosition = pending.command;
+        } else if (pending.command.startsWith("go")) {
+            m_ponderSearch = pending.limits.ponder;
+            m_searchLimits = pending.limits;
+            m_searchSide = pending.side;
+            m_searchStartedAt = m_clock.elapsed();
+            // 上一次搜尋的 multipv 不能與這一次的混在一起
+            m_analysisDirty = 0;
+            for (AnalysisUpdate& update : m_analysis) {
+                update = AnalysisUpdate();
+            }
+            setState(State::Searching);
+        }
+    }
+}
+
+void UCIEngine::writeCommand(const QString& command, std::function<void()> onReady)
+{
+    if (!m_processRunning) {
+        return;
+    }
+    if (command == "isready") {
+        m_readyCallbacks.enqueue(onReady);
+        updateWatchdog();
+    }
+    log(">> " + command);
+    // 交給 I/O 執行緒寫入 QProcess 的緩衝區，立即返回
+    const QByteArray data = (command + "\n").toUtf8();
+    UCIEngineIO* io = m_io;
+    QMetaObject::invokeMethod(m_io, [io, data]() { io->write(data); }, Qt::QueuedConnection);
+}
+
+void UCIEngine::onStarted()
+{
+    // 程序啟動前印出的行（例如版本資訊）與舊程序剩下的輸出都不需要
+    m_lines.clear();
+    m_processRunning = true;
+    setState(State::WaitingUciOk);
+    writeCommand("uci");
+}
+
+void UCIEngine::setLogCapacity(int lines)
+{
+    m_log.clear();
+    m_log.resize(qMax(0, lines));
+    m_logNext = 0;
+}
+
+QStringList UCIEngine::logLines() const
+{
+    QStringList lines;
+    for (int i = 0; i < m_log.size(); ++i) {
+        const QString& line = m_log[(m_logNext + i) % m_log.size()];
+        if (!line.isEmpty()) {
+            lines.append(line);
+        }
+    }
+    return lines;
+}
+
+void UCIEngine::log(const QString& line)
+{
+    if (m_log.isEmpty()) {
+        return;
+    }
+    m_log[m_logNext] = line;
+    m_logNext = (m_logNext + 1) % m_log.size();
+}
+
+void UCIEngine::onLinesAvailable()
+{
+    // 搜尋時每秒可能有上千行 info：直接在緩衝區上解析，其他的行才轉成 QString
+    m_lines.beginDrain();
+    int length;
+    while ((length = m_lines.pop(m_lineBuffer)) >= 0) {
+        if (length >= 5 && std::memcmp(m_lineBuffer, "info ", 5) == 0) {
+            if (!m_log.isEmpty()) {
+                log("<< " + QString::fromUtf8(m_lineBuffer, length));
+            }
+            processInfo(m_lineBuffer, length);
+        } else {
+            processLine(QString::fromUtf8(m_lineBuffer, length).trimmed());
+        }
     }
 }
 
 void UCIEngine::processLine(const QString& line)
 {
-    qDebug() << "UCI <<" << line;
-    
+    log("<< " + line);
+
     if (line == "uciok") {
-        qDebug() << "Engine initialized";
+        if (m_state != State::WaitingUciOk) {
+            return;
+        }
+        setState(State::WaitingReadyOk);
+
+        // 握手前設定的選項（重新啟動時是之前的所有設定）先送出，再以 isready 確認引擎已套用
+        // 剛啟動的程序已經是預設值，和預設值相同的不送
+        for (auto it = m_optionValues.constBegin(); it != m_optionValues.constEnd(); ++it) {
+            const Option* option = findOption(it.key());
+            if (option && (option->type == "button" || option->defaultValue == it.value())) {
+                continue;
+            }
+            const QString command = optionCommand(it.key(), it.value());
+            if (!command.isEmpty()) {
+                writeCommand(command);
+            }
+        }
+        writeCommand("isready", [this]() {
+            setState(State::Idle);
+            emit ready();
+        });
+    }
+    else if (line.startsWith("option ")) {
+        if (m_state == State::WaitingUciOk) {
+            parseOption(line);
+        }
     }
     else if (line == "readyok") {
-        m_isReady = true;
-        qDebug() << "Engine ready";
+        if (!m_readyCallbacks.isEmpty()) {
+            const std::function<void()> onReady = m_readyCallbacks.dequeue();
+            if (onReady) {
+                onReady();
+            }
+            updateWatchdog();
+        }
+        flushCommands();
     }
     else if (line.startsWith("bestmove")) {
-        QStringList parts = line.split(' ');
-        if (parts.size() >= 2) {
-            QString move = parts[1];
-            if (move.length() >= 4) {
-                QString from = move.mid(0, 2);
-                QString to = move.mid(2, 2);
-                emit bestMoveFound(from, to);
+        if (m_state != State::Searching && m_state != State::Stopping) {
+            return;
+        }
+        setState(State::Idle);
+
+        // 被 stop 中斷的搜尋，以及沒有等到 ponderhit 就結束的預先思考（不符合協定）都不回報
+        if (m_discardBestMove || m_ponderSearch) {
+            m_discardBestMove = false;
+            m_ponderSearch = false;
+            m_pondering = false;
+            m_ponderMove.clear();
+            m_analysisDirty = 0;
+        } else {
+            // 引擎能正常完成搜尋，之後的失敗重新計算次數
+            m_restartCount = 0;
+            flushAnalysis();
+            // bestmove <著法> [ponder <預測的應著>]
+            QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+            m_bestMove = parts.size() >= 2 ? parts[1] : QString();
+            m_ponderMove = parts.size() >= 4 && parts[2] == "ponder" ? parts[3] : QString();
+            if (parts.size() >= 2) {
+                QString move = parts[1];
+                if (move.length() >= 4) {
+                    QString from = move.mid(0, 2);
+                    QString to = move.mid(2, 2);
+                    // 第 5 個字元是升變的棋子（e7e8n），沒有時照舊升后
+                    PieceType promotion = PieceType::QUEEN;
+                    if (move.length() >= 5) {
+                        switch (move[4].toLatin1()) {
+                        case 'n': promotion = PieceType::KNIGHT; break;
+                        case 'b': promotion = PieceType::BISHOP; break;
+                        case 'r': promotion = PieceType::ROOK; break;
+                        default:  promotion = PieceType::QUEEN; break;
+                        }
+                    }
+                    emit bestMoveFound(from, to, promotion);
+                }
             }
         }
+        flushCommands();
     }
 }
 
-void UCIEngine::onErrorOccurred(QProcess::ProcessError error)
+void UCIEngine::parseOption(const QString& line)
 {
-    QString errorMsg;
-    switch (error) {
-        case QProcess::FailedToStart:
-            errorMsg = "Engine failed to start";
-            break;
-        case QProcess::Crashed:
-            errorMsg = "Engine crashed";
-            break;
-        default:
-            errorMsg = "Engine error occurred";
-            break;
+    // option name <名稱> type <型別> [default <值>] [min <n>] [max <n>] [var <值>]...
+    // 名稱與值可以含空白，一直延續到下一個關鍵字
+    static const QStringList keywords = { "name", "type", "default", "min", "max", "var" };
+
+    Option option;
+    QString key;
+    QString value;
+    auto commit = [&option](const QString& key, const QString& value) {
+        if (key == "name") option.name = value;
+        else if (key == "type") option.type = value;
+        else if (key == "default") option.defaultValue = value == "<empty>" ? QString() : value;
+        else if (key == "min") option.min = value.toInt();
+        else if (key == "max") option.max = value.toInt();
+        else if (key == "var") option.vars.append(value);
+    };
+
+    const QStringList tokens = line.split(' ', Qt::SkipEmptyParts);
+    for (int i = 1; i < tokens.size(); ++i) {
+        if (keywords.contains(tokens[i])) {
+            if (!key.isEmpty()) {
+                commit(key, value);
+            }
+            key = tokens[i];
+            value.clear();
+        } else if (!key.isEmpty()) {
+            value += value.isEmpty() ? tokens[i] : " " + tokens[i];
+        }
+    }
+    if (!key.isEmpty()) {
+        commit(key, value);
+    }
+
+    if (!option.name.isEmpty() && !option.type.isEmpty()) {
+        m_options.append(option);
     }
-    
-    qDebug() << errorMsg;
-    emit engineError(errorMsg);
 }
 
-QString UCIEngine::positionToUCI(int row, int col)
+void UCIEngine::processInfo(const char* line, int length)
 {
-    // 將棋盤座標 (row, col) 轉換為 UCI 格式 (例如 "e2")
-    char file = 'a' + col;
-    char rank = '1' + row;
-    return QString(file) + QString(rank);
+    if (m_state != State::Searching) {
+        return;
+    }
+
+    AnalysisUpdate info;
+    const bool hasScore = parseInfo(line, length, &info);
+    if (info.multiPv < 1 || info.multiPv > MAX_MULTI_PV) {
+        return;
+    }
+    AnalysisUpdate& update = m_analysis[info.multiPv - 1];
+    if (hasScore) {
+        update = info;
+    } else {
+        // currmove、hashfull 之類的行只更新統計
+        if (info.nodes) update.nodes = info.nodes;
+        if (info.nps) update.nps = info.nps;
+        if (info.tbHits) update.tbHits = info.tbHits;
+        if (info.hashFull) update.hashFull = info.hashFull;
+        if (info.time) update.time = info.time;
+        if (update.depth == 0) {
+            return;
+        }
+    }
+
+    m_analysisDirty |= quint64(1) << (info.multiPv - 1);
+    if (!m_analysisTimer->isActive()) {
+        m_analysisTimer->start();
+    }
 }
 
-QPoint UCIEngine::uciToPosition(const QString& uci)
+void UCIEngine::flushAnalysis()
 {
-    // 將 UCI 格式 (例如 "e2") 轉換為棋盤座標 (row, col)
-    if (uci.length() < 2) return QPoint(-1, -1);
-    
-    int col = uci[0].toLatin1() - 'a';
-    int row = uci[1].toLatin1() - '1';
-    
-    return QPoint(row, col);
+    m_analysisTimer->stop();
+    for (int i = 0; m_analysisDirty; ++i) {
+        const quint64 bit = quint64(1) << i;
+        if (m_analysisDirty & bit) {
+            m_analysisDirty &= ~bit;
+            emit analysisUpdated(m_analysis[i]);
+        }
+    }
 }
 
-QString UCIEngine::boardToFEN(ChessBoard* board, PieceColor turn)
+namespace {
+
+// 從 *p 讀下一個以空白分隔的字，回傳長度；沒有時回傳 0
+int nextToken(const char*& p, const char* end, const char** token)
 {
-    QString fen;
-    
-    // 棋盤位置（從第8列到第1列）
-    for (int row = 7; row >= 0; --row) {
-        int emptyCount = 0;
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece* piece = board->getPieceAt(row, col);
-            if (piece) {
-                if (emptyCount > 0) {
-                    fen += QString::number(emptyCount);
-                    emptyCount = 0;
-                }
-                
-                char pieceChar;
-                switch (piece->getType()) {
-                    case PieceType::PAWN:   pieceChar = 'p'; break;
-                    case PieceType::KNIGHT: pieceChar = 'n'; break;
-                    case PieceType::BISHOP: pieceChar = 'b'; break;
-                    case PieceType::ROOK:   pieceChar = 'r'; break;
-                    case PieceType::QUEEN:  pieceChar = 'q'; break;
-                    case PieceType::KING:   pieceChar = 'k'; break;
-                    default: pieceChar = '?'; break;
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+    *token = p;
+    while (p < end && *p != ' ') {
+        ++p;
+    }
+    return int(p - *token);
+}
+
+bool tokenIs(const char* token, int length, const char* word)
+{
+    return int(std::strlen(word)) == length && std::memcmp(token, word, length) == 0;
+}
+
+qint64 tokenToInt(const char* token, int length)
+{
+    qint64 value = 0;
+    bool negative = false;
+    int i = 0;
+    if (i < length && (token[i] == '-' || token[i] == '+')) {
+        negative = token[i] == '-';
+        ++i;
+    }
+    for (; i < length && token[i] >= '0' && token[i] <= '9'; ++i) {
+        value = value * 10 + (token[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+}
+
+bool UCIEngine::parseInfo(const char* line, int length, AnalysisUpdate* update)
+{
+    const char* p = line;
+    const char* end = line + length;
+    const char* token;
+    int n = nextToken(p, end, &token);
+    if (!tokenIs(token, n, "info")) {
+        return false;
+    }
+
+    bool hasScore = false;
+    while ((n = nextToken(p, end, &token)) > 0) {
+        const char* value;
+        if (tokenIs(token, n, "string")) {
+            break;  // 其餘是任意文字
+        } else if (tokenIs(token, n, "pv")) {
+            // pv 之後到行尾都是著法
+            update->pvLength = 0;
+            int m;
+            while ((m = nextToken(p, end, &value)) > 0 && update->pvLength < AnalysisUpdate::MaxPvLength) {
+                if (m < 4 || m > 5) {
+                    break;
                 }
-                
-                if (piece->getColor() == PieceColor::WHITE) {
-                    pieceChar = toupper(pieceChar);
+                char* move = update->pv[update->pvLength++];
+                std::memcpy(move, value, m);
+                move[m] = '\0';
+            }
+            break;
+        } else if (tokenIs(token, n, "lowerbound")) {
+            update->bound = 1;
+        } else if (tokenIs(token, n, "upperbound")) {
+            update->bound = -1;
+        } else if (tokenIs(token, n, "score")) {
+            hasScore = true;
+            while ((n = nextToken(p, end, &token)) > 0) {
+                if (tokenIs(token, n, "cp") || tokenIs(token, n, "mate")) {
+                    update->isMate = token[0] == 'm';
+                    const int m = nextToken(p, end, &value);
+                    update->score = int(tokenToInt(value, m));
+                    break;
                 }
-                
-                fen += pieceChar;
-            } else {
-                emptyCount++;
             }
+        } else {
+            const int m = nextToken(p, end, &value);
+            const qint64 number = tokenToInt(value, m);
+            if (tokenIs(token, n, "depth")) update->depth = int(number);
+            else if (tokenIs(token, n, "seldepth")) update->selDepth = int(number);
+            else if (tokenIs(token, n, "multipv")) update->multiPv = int(number);
+            else if (tokenIs(token, n, "nodes")) update->nodes = quint64(number);
+            else if (tokenIs(token, n, "nps")) update->nps = quint64(number);
+            else if (tokenIs(token, n, "tbhits")) update->tbHits = quint64(number);
+            else if (tokenIs(token, n, "hashfull")) update->hashFull = int(number);
+            else if (tokenIs(token, n, "time")) update->time = int(number);
+            else if (tokenIs(token, n, "wdl")) {
+                // wdl 有三個值
+                nextToken(p, end, &value);
+                nextToken(p, end, &value);
+            }
+            // currmove、currmovenumber 等用不到的欄位已經跳過它的值
         }
-        
-        if (emptyCount > 0) {
-            fen += QString::number(emptyCount);
-        }
-        
-        if (row > 0) {
-            fen += '/';
-        }
-    }
-    
-    // 輪到誰
-    fen += (turn == PieceColor::WHITE) ? " w " : " b ";
-    
-    // 王車易位權利（簡化版本 - 可以改進）
-    QString castling;
-    // TODO: 實際檢查王車易位的可用性
-    castling = "KQkq";  // 假設全部可用
-    fen += castling.isEmpty() ? "-" : castling;
-    fen += " ";
-    
-    // 吃過路兵目標格（簡化）
-    fen += "- ";
-    
-    // 半回合計數器和完整回合數（簡化）
-    fen += "0 1";
-    
-    return fen;
+    }
+    return hasScore;
+}
+
+QString UCIEngine::AnalysisUpdate::pvText() const
+{
+    QString text;
+    for (int i = 0; i < pvLength; ++i) {
+        if (i > 0) {
+            text += ' ';
+        }
+        text += QString::fromLatin1(pv[i]);
+    }
+    return text;
+}
+
+void UCIEngine::onErrorOccurred(QProcess::ProcessError error)
+{
+    // 程序結束由 onFinished 處理，讀寫錯誤之後也會接著結束
+    if (error == QProcess::FailedToStart) {
+        handleFailure("Engine failed to start");
+    } else if (error != QProcess::Crashed) {
+        qDebug() << "Engine error occurred:" << error;
+    }
+}
+
+void UCIEngine::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Q_UNUSED(exitCode);
+    handleFailure(exitStatus == QProcess::CrashExit ? "Engine crashed" : "Engine exited");
+}
+
+void UCIEngine::updateWatchdog()
+{
+    int timeout = 0;
+    switch (m_state) {
+    case State::WaitingUciOk:
+    case State::WaitingReadyOk:
+        timeout = HANDSHAKE_TIMEOUT_MS;
+        break;
+    case State::Idle:
+        if (!m_readyCallbacks.isEmpty()) {
+            timeout = READY_TIMEOUT_MS;
+        }
+        break;
+    case State::Searching:
+        // 預先思考要等到 ponderhit 或 stop，只限深度或節點的搜尋沒有時間上限
+        if (!m_ponderSearch) {
+            const int budget = searchBudget(m_searchLimits, m_searchSide);
+            if (budget > 0) {
+                timeout = budget + SEARCH_GRACE_MS;
+            }
+        }
+        break;
+    case State::Stopping:
+        timeout = STOP_TIMEOUT_MS;
+        break;
+    default:
+        break;
+    }
+
+    if (timeout > 0) {
+        m_watchdog->start(timeout);
+    } else {
+        m_watchdog->stop();
+    }
+}
+
+void UCIEngine::onWatchdogTimeout()
+{
+    switch (m_state) {
+    case State::WaitingUciOk:
+    case State::WaitingReadyOk:
+        handleFailure("Engine handshake timed out");
+        break;
+    case State::Idle:
+        handleFailure("Engine did not answer isready");
+        break;
+    case State::Searching:
+        handleFailure("Engine did not return a move in time");
+        break;
+    case State::Stopping:
+        handleFailure("Engine did not stop");
+        break;
+    default:
+        break;
+    }
+}
+
+void UCIEngine::handleFailure(const QString& reason)
+{
+    // 等待重新啟動期間收到的舊程序事件不重複處理
+    if (m_state == State::NotRunning || m_restartTimer->isActive()) {
+        return;
+    }
+    qDebug() << reason;
+
+    // 沒有回應的程序直接結束，不等 quit
+    m_watchdog->stop();
+    m_processRunning = false;
+    UCIEngineIO* io = m_io;
+    QMetaObject::invokeMethod(m_io, [io]() { io->kill(); }, Qt::QueuedConnection);
+
+    // 重新啟動後依序送出：還沒有回應的 isready（握手的除外）、被中斷的搜尋，再接上還沒送出的命令
+    // 選項在握手時從 m_optionValues 重送；預先思考不接續，玩家走完後 ponderHit() 回傳 false 而重新搜尋
+    QQueue<PendingCommand> resume;
+    if (m_state == State::Idle) {
+        for (const std::function<void()>& onReady : m_readyCallbacks) {
+            resume.enqueue({ "isready", onReady });
+        }
+    } else if (m_state == State::Searching && !m_ponderSearch) {
+        resume.enqueue({ m_searchPosition, nullptr });
+        PendingCommand go = { goCommand(m_searchLimits), nullptr };
+        go.limits = m_searchLimits;
+        go.side = m_searchSide;
+        go.startedAt = m_searchStartedAt;
+        resume.enqueue(go);
+    }
+    if (m_ponderSearch) {
+        m_pondering = false;
+    }
+    while (!m_pendingCommands.isEmpty()) {
+        resume.enqueue(m_pendingCommands.dequeue());
+    }
+    m_pendingCommands = resume;
+    m_readyCallbacks.clear();
+    m_options.clear();
+    m_discardBestMove = false;
+    m_ponderSearch = false;
+    m_analysisDirty = 0;
+    m_analysisTimer->stop();
+
+    if (m_restartCount >= MAX_RESTARTS) {
+        m_pendingCommands.clear();
+        resetPonder();
+        setState(State::NotRunning);
+        emit engineError(reason);
+        return;
+    }
+
+    // 指數退避，避免一啟動就當掉的引擎佔滿 CPU
+    const int delay = RESTART_DELAY_MS << m_restartCount;
+    ++m_restartCount;
+    qDebug() << "Restarting engine in" << delay << "ms, attempt" << m_restartCount;
+    setState(State::Starting);
+    m_restartTimer->start(delay);
+}
+
+QString UCIEngine::positionToUCI(const QPoint& square)
+{
+    // 將棋盤座標 (col, row) 轉換為 UCI 格式 (例如 "e2")，row 0 是第 8 橫列
+    char file = 'a' + square.x();
+    char rank = '8' - square.y();
+    return QString(file) + QString(rank);
+}
+
+QString UCIEngine::moveToUCI(const Move& move)
+{
+    QString uci = positionToUCI(move.from) + positionToUCI(move.to);
+    if (move.wasPromotion) {
+        switch (move.promotedTo) {
+        case PieceType::ROOK:   uci += 'r'; break;
+        case PieceType::BISHOP: uci += 'b'; break;
+        case PieceType::KNIGHT: uci += 'n'; break;
+        default:                uci += 'q'; break;
+        }
+    }
+    return uci;
+}
+
+QString UCIEngine::positionCommand(const ChessBoard* board)
+{
+    // 送出起始局面與完整著法序列而不只是目前局面：引擎才看得到重複局面，
+    // 也能認出與上一次只差幾步而沿用置換表
+    const QString startFen = board->getStartFEN();
+    QString command = startFen == Engine::Position::StartFen
+                    ? QString("position startpos")
+                    : "position fen " + startFen;
+
+    const QVector<Move>& history = board->getMoveHistory();
+    if (!history.isEmpty()) {
+        command += " moves";
+        for (const Move& move : history) {
+            command += ' ';
+            command += moveToUCI(move);
+        }
+    }
+    return command;
+}
+
+QString UCIEngine::goCommand(const Engine::SearchLimits& limits)
+{
+    // 有棋鐘時交給引擎自行分配時間，其他限制同時生效（先到者為準）
+    QString command = "go";
+    if (limits.ponder) {
+        command += " ponder";
+    }
+    if (limits.useTimeManagement()) {
+        command += QString(" wtime %1 btime %2").arg(limits.time[Engine::WHITE]).arg(limits.time[Engine::BLACK]);
+        if (limits.inc[Engine::WHITE] > 0 || limits.inc[Engine::BLACK] > 0) {
+            command += QString(" winc %1 binc %2").arg(limits.inc[Engine::WHITE]).arg(limits.inc[Engine::BLACK]);
+        }
+        if (limits.movestogo > 0) {
+            command += QString(" movestogo %1").arg(limits.movestogo);
+        }
+    }
+    if (limits.depth > 0) {
+        command += QString(" depth %1").arg(limits.depth);
+    }
+    if (limits.nodes > 0) {
+        command += QString(" nodes %1").arg(limits.nodes);
+    }
+    if (limits.movetime > 0) {
+        command += QString(" movetime %1").arg(limits.movetime);
+    }
+    return command;
 }
@@ -5,51 +5,210 @@
 #include <QProcess>
 #include <QString>
 #include <QQueue>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <functional>
 #include "chessboard.h"
 #include "chesspiece.h"
+#include "search.h"
+#include "linequeue.h"
+
+// 外部 UCI 引擎：所有操作都不會阻塞 GUI 執行緒
+// 狀態：NotRunning → Starting（等待程序啟動）→ WaitingUciOk → WaitingReadyOk → Idle ⇄ Searching → Stopping → Idle
+// 送出的命令先進入佇列，只在引擎能接受時才寫出：握手前設定的選項在 uciok 之後送出，
+// 搜尋中的 position/go/setoption 等到 bestmove 之後，isready 之後的命令等到 readyok；stop 與 ponderhit 不經佇列
+// 程序當掉、握手或 isready 沒有回應、搜尋超過時間預算都視為失敗：結束程序，等待後重新啟動並接續，
+// 連續失敗 MAX_RESTARTS 次才發出 engineError()
+class QThread;
+class UCIEngineIO;
 
 class UCIEngine : public QObject
 {
     Q_OBJECT
 
 public:
+    enum class State {
+        NotRunning,
+        Starting,
+        WaitingUciOk,
+        WaitingReadyOk,
+        Idle,
+        Searching,
+        Stopping
+    };
+
+    // 引擎在握手時以 option name ... 宣告的選項
+    struct Option {
+        QString name;
+        QString type;          // check、spin、combo、button 或 string
+        QString defaultValue;
+        int min = 0;
+        int max = 0;
+        QStringList vars;      // combo 的可選值
+    };
+
+    // 搜尋中一條主變化的 info：分數與統計都是引擎回報的原值，分數為輪走方的觀點
+    // 固定大小、不配置記憶體，可以直接複製
+    struct AnalysisUpdate {
+        static const int MaxPvLength = 32;
+
+        int multiPv = 1;
+        int depth = 0;
+        int selDepth = 0;
+        bool isMate = false;    // true 時 score 為幾步將死（負數為被將死）
+        int score = 0;          // 百分兵或步數
+        int bound = 0;          // 0 精確，1 為 lowerbound，-1 為 upperbound
+        quint64 nodes = 0;
+        quint64 nps = 0;
+        quint64 tbHits = 0;
+        int hashFull = 0;       // 千分比
+        int time = 0;           // 毫秒
+        int pvLength = 0;
+        char pv[MaxPvLength][6] = {};  // UCI 著法，例如 "e7e8q"
+
+        QString pvText() const;  // 以空白分隔的主變化
+    };
+
+    // 解析一行 info（不含結尾換行），不配置記憶體；有 score 的行回傳 true
+    // 沒有 score 的行（currmove、hashfull 等）只填入出現的欄位
+    static bool parseInfo(const char* line, int length, AnalysisUpdate* update);
+
     explicit UCIEngine(QObject *parent = nullptr);
     ~UCIEngine();
 
-    // 初始化引擎
+    // 在背景啟動引擎並進行握手，立即返回；執行檔不存在時回傳 false
+    // 握手完成時發出 ready()（每次重新啟動後也會），多次重新啟動都失敗時發出 engineError()
     bool initialize(const QString& enginePath);
-    
+    // 放棄之後以同一個執行檔重新開始，失敗次數歸零
+    bool restart();
+
+    // 開新局：中斷目前的搜尋並送出 ucinewgame，程序與置換表配置都沿用
+    void newGame();
+
     // 設定技能等級 (0-20, Stockfish 支援)
     void setSkillLevel(int level);
-    
-    // 取得最佳移動
-    void getBestMove(ChessBoard* board, PieceColor color);
-    
-    // 停止引擎
+
+    // 設定引擎選項；值會保留，引擎重新啟動時在握手中再送出一次
+    // 握手完成前先記下，uciok 後只送出引擎宣告過的選項，spin 的值限制在 min/max 之內；值沒有改變時不重送
+    void setOption(const QString& name, const QString& value);
+    // 把之前設定過的選項改回引擎宣告的預設值；握手完成前只是忘掉記下的值
+    void resetOption(const QString& name);
+    // 最近一次握手時引擎宣告的選項（依宣告順序）；握手完成前為空
+    const QList<Option>& options() const { return m_options; }
+    const Option* findOption(const QString& name) const;
+
+    // 依主機決定的預設值：保留一個核心給介面，置換表用可用記憶體的 1/8（2 的次方，16 MB 至 4 GB）
+    static int defaultThreads();
+    static int defaultHashMb();
+
+    // 取得最佳移動；握手尚未完成或上一次搜尋還沒結束時排入佇列
+    // limits 的 time/inc/movestogo/depth/nodes/movetime 有設定的才送出
+    void getBestMove(ChessBoard* board, const Engine::SearchLimits& limits);
+
+    // 停止搜尋並丟棄結果，佇列中尚未送出的搜尋（含預先思考）一併取消
     void stop();
-    
-    // 檢查引擎是否準備就緒
-    bool isReady() const { return m_isReady; }
+
+    // 預先思考：在對手的時間以 go ponder 搜尋上一次 bestmove 之後引擎預測的應著；沒有預測的應著時回傳 false
+    // limits 為此時的棋鐘，引擎收到 ponderhit 才依它計時，在那之前想的時間都不算
+    bool ponder(const Engine::SearchLimits& limits);
+    // 對手走完後呼叫：走的正是預測的應著時送出 ponderhit 並回傳 true，結果照常以 bestMoveFound() 回報；
+    // 否則停止預先思考（結果丟棄）並回傳 false，由呼叫端重新搜尋
+    bool ponderHit(const ChessBoard* board);
+    bool isPondering() const { return m_pondering; }
+
+    // 送出 isready，引擎回應 readyok 時呼叫 onReady（依送出順序）
+    void sync(std::function<void()> onReady);
+
+    // 除錯用：保留最近 lines 行的引擎通訊（送出以 ">> "、收到以 "<< " 開頭），0 表示不記錄（預設）
+    void setLogCapacity(int lines);
+    QStringList logLines() const;  // 由舊到新
+
+    State state() const { return m_state; }
+    // 握手完成且沒有在搜尋
+    bool isReady() const { return m_state == State::Idle; }
+    // 程序已啟動或正在啟動，可以接受請求（會排入佇列）
+    bool isAvailable() const { return m_state != State::NotRunning; }
 
 signals:
-    void bestMoveFound(QString from, QString to);
+    void ready();
+    void stateChanged(UCIEngine::State state);
+    void bestMoveFound(QString from, QString to, PieceType promotion);
     void engineError(QString error);
+    // 每條主變化最新的分析，合併後最多每 ANALYSIS_INTERVAL_MS 發出一次；bestmove 前會先發出剩下的
+    void analysisUpdated(const UCIEngine::AnalysisUpdate& update);
 
 private slots:
-    void onReadyRead();
+    void onStarted();
+    void onLinesAvailable();
     void onErrorOccurred(QProcess::ProcessError error);
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void flushAnalysis();
+    void startProcess();
+    void onWatchdogTimeout();
 
 private:
-    QProcess* m_process;
-    bool m_isReady;
-    int m_skillLevel;
-    QString m_pendingCommand;
-    
-    void sendCommand(const QString& command);
+    struct PendingCommand {
+        QString command;
+        std::function<void()> onReady;  // 只用於 isready
+        // 以下只用於 go：時間預算與重新啟動後的接續
+        Engine::SearchLimits limits;
+        int side = Engine::WHITE;       // 輪走方
+        qint64 startedAt = -1;          // 接續的搜尋原本開始的時間（m_clock），送出時從棋鐘扣掉已用的時間
+    };
+
+    QThread* m_ioThread;
+    UCIEngineIO* m_io;                              // 在 m_ioThread 中，擁有 QProcess
+    LineQueue m_lines;                              // I/O 執行緒 → GUI 執行緒
+    bool m_processRunning;
+    State m_state;
+    QList<Option> m_options;               // 引擎宣告的選項
+    QMap<QString, QString> m_optionValues; // 介面設定的選項值
+    QQueue<PendingCommand> m_pendingCommands;       // 等待送出的命令
+    QQueue<std::function<void()>> m_readyCallbacks; // 每個已送出的 isready 一筆
+    bool m_discardBestMove;                         // 被 stop 中斷的搜尋結果不回報
+    QString m_searchPosition;                       // 最近送出的 position 命令
+    QString m_bestMove;                             // 最近一次回報的 bestmove 與引擎預測的應著
+    QString m_ponderMove;
+    QString m_ponderPosition;                       // 預先思考的局面（position 命令）
+    bool m_pondering;                               // go ponder 已排入或送出，還沒有 ponderhit
+    bool m_ponderSearch;                            // 正在進行的搜尋是 go ponder，還沒有 ponderhit
+    Engine::SearchLimits m_searchLimits;            // 正在進行的搜尋，失敗時重送
+    int m_searchSide;
+    qint64 m_searchStartedAt;                       // 送出 go（或 ponderhit）的時間（m_clock）
+    QString m_enginePath;
+    QElapsedTimer m_clock;
+    QTimer* m_watchdog;                             // 等待回應的期限，依狀態設定
+    QTimer* m_restartTimer;                         // 重新啟動前的等待
+    int m_restartCount;                             // 連續失敗次數，正常回報 bestmove 後歸零
+    QVector<AnalysisUpdate> m_analysis;             // 依 multipv 編號，建構時配置一次
+    quint64 m_analysisDirty;                        // 還沒發出的 multipv（位元）
+    QTimer* m_analysisTimer;
+    char m_lineBuffer[LineQueue::MaxLineLength + 1]; // 取出的行，避免每行配置
+    QVector<QString> m_log;                         // 環狀緩衝區，空的表示不記錄
+    int m_logNext;
+
+    void setState(State state);
+    void enqueueCommand(const QString& command, std::function<void()> onReady = nullptr);
+    void enqueueSearch(const QString& position, const Engine::SearchLimits& limits, int side,
+                       qint64 startedAt = -1);
+    void flushCommands();
+    void updateWatchdog();
+    void handleFailure(const QString& reason);
+    void resetPonder();
+    void writeCommand(const QString& command, std::function<void()> onReady = nullptr);
     void processLine(const QString& line);
-    QString positionToUCI(int row, int col);
-    QPoint uciToPosition(const QString& uci);
-    QString boardToFEN(ChessBoard* board, PieceColor turn);
+    void processInfo(const char* line, int length);
+    void log(const QString& line);
+    void parseOption(const QString& line);
+    QString optionCommand(const QString& name, const QString& value) const;  // 引擎不支援時為空字串
+    QString positionToUCI(const QPoint& square);
+    QString moveToUCI(const Move& move);  // 升變加上小寫棋子字母，例如 e7e8q
+    QString positionCommand(const ChessBoard* board);  // position startpos|fen ... moves ...
+    QString goCommand(const Engine::SearchLimits& limits);
 };
 
 #endif // UCIENGINE_H
@@ -0,0 +1,107 @@
+#include "uciengineio.h"
+#include <QDebug>
+#include <QThread>
+#include <cstring>
+
+UCIEngineIO::UCIEngineIO(LineQueue* lines, QObject *parent)
+    : QObject(parent),
+      m_lines(lines),
+      m_process(nullptr),
+      m_skipLine(false),
+      m_droppedInfo(0),
+      m_aborted(false)
+{
+}
+
+void UCIEngineIO::start(const QString& enginePath)
+{
+    kill();
+    m_skipLine = false;
+
+    m_process = new QProcess(this);
+    connect(m_process, &QProcess::started, this, &UCIEngineIO::started);
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &UCIEngineIO::onReadyRead);
+    connect(m_process, &QProcess::errorOccurred, this, &UCIEngineIO::errorOccurred);
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &UCIEngineIO::finished);
+    m_process->start(enginePath);
+}
+
+void UCIEngineIO::kill()
+{
+    if (!m_process) {
+        return;
+    }
+    // 先斷開連線，被結束的程序不會再發出 finished()
+    m_process->disconnect(this);
+    m_process->kill();
+    m_process->waitForFinished(1000);
+    delete m_process;
+    m_process = nullptr;
+}
+
+void UCIEngineIO::write(const QByteArray& data)
+{
+    if (m_process && m_process->state() == QProcess::Running) {
+        m_process->write(data);
+    }
+}
+
+void UCIEngineIO::shutdown()
+{
+    if (!m_process) {
+        return;
+    }
+    m_process->disconnect(this);
+    if (m_process->state() == QProcess::Running) {
+        m_process->write("quit\n");
+        if (!m_process->waitForFinished(1000)) {
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+    }
+    delete m_process;
+    m_process = nullptr;
+}
+
+void UCIEngineIO::onReadyRead()
+{
+    bool pushed = false;
+    while (m_process->canReadLine()) {
+        qint64 length = m_process->readLine(m_buffer, sizeof(m_buffer));
+        if (length <= 0) {
+            break;
+        }
+        const bool complete = m_buffer[length - 1] == '\n';
+        const bool skip = m_skipLine;
+        m_skipLine = !complete;
+        if (skip) {
+            continue;
+        }
+        while (length > 0 && (m_buffer[length - 1] == '\n' || m_buffer[length - 1] == '\r')) {
+            --length;
+        }
+
+        // 佇列滿時 info 行直接丟掉（很快就會被新的取代），其他的行等 GUI 執行緒取出
+        while (!m_lines->tryPush(m_buffer, int(length))) {
+            if (length >= 5 && std::memcmp(m_buffer, "info ", 5) == 0) {
+                if (++m_droppedInfo % 1000 == 1) {
+                    qDebug() << "Engine output queue full, dropped info lines:" << m_droppedInfo;
+                }
+                break;
+            }
+            if (m_aborted.load()) {
+                return;
+            }
+            if (m_lines->needsWakeup()) {
+                emit linesAvailable();
+            }
+            QThread::yieldCurrentThread();
+        }
+        pushed = true;
+    }
+
+    if (pushed && m_lines->needsWakeup()) {
+        emit linesAvailable();
+    }
+}
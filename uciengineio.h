@@ -0,0 +1,48 @@
+#ifndef UCIENGINEIO_H
+#define UCIENGINEIO_H
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include "linequeue.h"
+
+// 外部引擎的管線 I/O，在自己的執行緒中執行：QProcess 屬於這個執行緒，
+// 讀到的行放進 LineQueue 交給 GUI 執行緒，佇列由空變成有內容時才發出一次 linesAvailable()
+// 公開的槽都由 GUI 執行緒以佇列連線呼叫
+class UCIEngineIO : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UCIEngineIO(LineQueue* lines, QObject *parent = nullptr);
+
+    // GUI 執行緒準備結束時設定，佇列滿時不再等待消費者
+    void abort() { m_aborted.store(true); }
+
+public slots:
+    void start(const QString& enginePath);  // 舊的程序直接結束
+    void kill();                            // 不等引擎回應直接結束程序（當掉或沒有回應時）
+    void write(const QByteArray& data);
+    void shutdown();                        // 送出 quit，最多等 1 秒後結束程序
+
+signals:
+    void started();
+    void linesAvailable();
+    void errorOccurred(QProcess::ProcessError error);
+    void finished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void onReadyRead();
+
+private:
+    LineQueue* m_lines;
+    QProcess* m_process;
+    char m_buffer[LineQueue::MaxLineLength + 1];
+    bool m_skipLine;                // 超過緩衝區的行丟棄剩下的部分
+    quint64 m_droppedInfo;          // 佇列滿時丟掉的 info 行
+    std::atomic<bool> m_aborted;
+};
+
+#endif // UCIENGINEIO_H